@@ -0,0 +1,81 @@
+#include "capture.h"
+#include <LittleFS.h>
+#include <mbedtls/base64.h>
+
+PayloadCapture payloadCapture;
+
+bool PayloadCapture::mount() {
+    if (!_mounted) {
+        _mounted = LittleFS.begin(true, CAPTURE_MOUNT);
+        if (!_mounted) Serial.println("[capture] LittleFS mount failed");
+    }
+    return _mounted;
+}
+
+bool PayloadCapture::begin() {
+    if (!mount()) return false;
+    bool ok = _writer.begin(CAPTURE_FILE, CAPTURE_OLD_FILE, CAPTURE_MAX_BYTES, millis());
+    Serial.printf("[capture] %s %s, fs %u/%u bytes used\n", ok ? "recording to" : "cannot open", CAPTURE_FILE,
+                  LittleFS.usedBytes(), LittleFS.totalBytes());
+    return ok;
+}
+
+void PayloadCapture::poll(Stream& io) {
+    if (_writer.active() && millis() - _lastSync > CAPTURE_SYNC_MS) {
+        _writer.flush();
+        _lastSync = millis();
+    }
+    while (io.available()) {
+        int c = io.read();
+        if (c != '\n' && c != '\r') {
+            if (_lineLen < sizeof(_line) - 1) _line[_lineLen++] = c;
+            continue;
+        }
+        _line[_lineLen] = 0;
+        _lineLen = 0;
+        if (!_mounted) continue;
+        bool recording = _writer.active();
+        if (strcmp(_line, "dump") == 0) {
+            // 讀檔前先關閉寫入端，印完再接著記錄
+            _writer.end();
+            dump(io, CAPTURE_OLD_FILE);
+            dump(io, CAPTURE_FILE);
+            if (recording) begin();
+        } else if (strcmp(_line, "clear") == 0) {
+            _writer.end();
+            remove(CAPTURE_OLD_FILE);
+            remove(CAPTURE_FILE);
+            io.println("[capture] cleared");
+            if (recording) begin();
+        }
+    }
+}
+
+// [capture] dump <name> <size>，接著每行 76 個 base64 字元，最後 [capture] dump end <name>
+void PayloadCapture::dump(Print& out, const char* path) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    const char* name = strrchr(path, '/') + 1;
+    out.printf("[capture] dump %s %ld\n", name, size);
+    uint8_t raw[57];
+    unsigned char line[80];
+    size_t n;
+    while ((n = fread(raw, 1, sizeof(raw), f)) > 0) {
+        size_t olen = 0;
+        mbedtls_base64_encode(line, sizeof(line), &olen, raw, n);
+        line[olen] = 0;
+        out.println((const char*)line);
+    }
+    fclose(f);
+    out.printf("[capture] dump end %s\n", name);
+}
+
+void PayloadCapture::printStats(Print& out) const {
+    const PayloadStats& st = _writer.stats();
+    out.printf("[capture] %s records=%u file=%u truncated=%u rotations=%u errors=%u fs=%u/%u\n",
+               _writer.active() ? "on" : "off", st.records, st.bytes, st.truncated, st.rotations, st.errors,
+               _mounted ? LittleFS.usedBytes() : 0, _mounted ? LittleFS.totalBytes() : 0);
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <Arduino.h>
+#include "payload_log.h"
+
+// --- 記錄 / 回放：網路收到的原始 payload 寫進 LittleFS，之後餵回同一套解析 / 繪圖流程 ---
+// CAPTURE_MODE：照常連線，網路 task 收到的 REST 回應 (已解開 gzip) 與 WebSocket 訊息附上時間寫進記錄檔。
+//               Serial 輸入 "dump" 以 base64 印出記錄檔 (tools/capture_pull.py 從 monitor 的輸出還原)，"clear" 清除。
+// REPLAY_MODE ：不連 WiFi，依記錄的順序與時間把 payload 餵給解析 -> 合併 -> 發布 -> 繪圖，
+//               記錄檔可以是裝置自己錄的，也可以放在 data/ 以 uploadfs 上傳。
+#ifndef CAPTURE_MODE
+#define CAPTURE_MODE 0
+#endif
+#ifndef REPLAY_MODE
+#define REPLAY_MODE 0
+#endif
+#ifndef REPLAY_SPEED
+#define REPLAY_SPEED 1              // 倍速，1 為原速，0 為盡快 (壓測整條流程)
+#endif
+#ifndef REPLAY_LOOP
+#define REPLAY_LOOP 1               // 播完從頭再播 (每輪先清空序列)
+#endif
+#ifndef CAPTURE_MAX_BYTES
+#define CAPTURE_MAX_BYTES (512 * 1024)   // 新舊兩個檔案合計，預設分割區 (1.4 MB) 留一半給 uploadfs 的資料
+#endif
+#define CAPTURE_MOUNT "/littlefs"
+#define CAPTURE_FILE CAPTURE_MOUNT "/capture.bin"
+#define CAPTURE_OLD_FILE CAPTURE_MOUNT "/capture.old"
+#define CAPTURE_SYNC_MS 5000        // 每 5 秒把記錄檔同步到 flash，斷電最多遺失這麼久
+
+class PayloadCapture {
+public:
+    // 掛載 LittleFS (第一次使用時格式化)
+    bool mount();
+    // 掛載並開始記錄
+    bool begin();
+    // 記錄中時回傳寫入端，否則為 nullptr
+    PayloadWriter* writer() { return _writer.active() ? &_writer : nullptr; }
+    // 網路 task 每輪呼叫：定時同步，並處理 Serial 的 dump / clear 指令
+    void poll(Stream& io);
+    void printStats(Print& out) const;
+
+private:
+    void dump(Print& out, const char* path);
+
+    PayloadWriter _writer;
+    bool _mounted = false;
+    uint32_t _lastSync = 0;
+    char _line[16];
+    uint8_t _lineLen = 0;
+};
+
+extern PayloadCapture payloadCapture;
@@ -0,0 +1,107 @@
+#include "clock_sync.h"
+
+void ClockSync::addSample(uint64_t localSend, uint64_t localRecv, uint64_t serverMs, uint32_t resolutionMs) {
+    if (localRecv < localSend || serverMs == 0) return;
+    int slot = _count;
+    if (_count == CLOCK_SAMPLES) {
+        slot = -1;
+        // 先取代解析度最差的，同解析度中取最舊的
+        for (int i = 0; i < _count; i++) {
+            const ClockSample& c = _samples[i];
+            if (c.resolution < resolutionMs) continue;
+            if (slot < 0 || c.resolution > _samples[slot].resolution ||
+                (c.resolution == _samples[slot].resolution && c.local < _samples[slot].local)) {
+                slot = i;
+            }
+        }
+        if (slot < 0) return;
+    } else {
+        _count++;
+    }
+    ClockSample& s = _samples[slot];
+    s.local = localSend + (localRecv - localSend) / 2;
+    s.offset = (int64_t)serverMs - (int64_t)s.local;
+    s.uncertainty = (uint32_t)((localRecv - localSend) / 2) + resolutionMs;
+    s.resolution = resolutionMs;
+    estimateDrift();
+}
+
+int ClockSync::goodCount() const {
+    int n = 0;
+    for (int i = 0; i < _count; i++) {
+        if (_samples[i].uncertainty <= CLOCK_GOOD_SAMPLE_MS) n++;
+    }
+    return n;
+}
+
+// 樣本隨時間老化：除了已估計的漂移外，再保留晶振 100 ppm 的誤差
+uint32_t ClockSync::sampleUncertainty(const ClockSample& s, uint64_t local) const {
+    uint64_t age = local > s.local ? local - s.local : s.local - local;
+    return s.uncertainty + (uint32_t)(age / 10000);
+}
+
+int ClockSync::best(uint64_t local) const {
+    int pick = -1;
+    uint32_t bestU = 0;
+    for (int i = 0; i < _count; i++) {
+        uint32_t u = sampleUncertainty(_samples[i], local);
+        if (pick < 0 || u < bestU) {
+            pick = i;
+            bestU = u;
+        }
+    }
+    return pick;
+}
+
+int64_t ClockSync::offsetMs(uint64_t local) const {
+    int i = best(local);
+    if (i < 0) return 0;
+    const ClockSample& s = _samples[i];
+    return s.offset + (int64_t)(_drift * ((double)local - (double)s.local));
+}
+
+uint32_t ClockSync::uncertaintyMs(uint64_t local) const {
+    int i = best(local);
+    return i < 0 ? UINT32_MAX : sampleUncertainty(_samples[i], local);
+}
+
+uint64_t ClockSync::nowMs(uint64_t local) {
+    if (_count == 0) return 0;
+    uint64_t est = (uint64_t)((int64_t)local + offsetMs(local));
+    if (_lastNow && est < _lastNow + (local - _lastLocal)) {
+        // 往回修正：半速前進，保持單調
+        uint64_t slewed = _lastNow + (local - _lastLocal) / 2;
+        if (est < slewed) est = slewed;
+    }
+    _lastNow = est;
+    _lastLocal = local;
+    return est;
+}
+
+// 以精確樣本的 offset 對本地時間做最小平方法，斜率即漂移
+void ClockSync::estimateDrift() {
+    double sx = 0, sy = 0, sxx = 0, sxy = 0;
+    int n = 0;
+    uint64_t minL = UINT64_MAX, maxL = 0;
+    for (int i = 0; i < _count; i++) {
+        if (_samples[i].uncertainty > CLOCK_GOOD_SAMPLE_MS) continue;
+        if (_samples[i].local < minL) minL = _samples[i].local;
+        if (_samples[i].local > maxL) maxL = _samples[i].local;
+    }
+    if (maxL < minL || maxL - minL < CLOCK_DRIFT_MIN_SPAN_MS) return;
+    for (int i = 0; i < _count; i++) {
+        const ClockSample& s = _samples[i];
+        if (s.uncertainty > CLOCK_GOOD_SAMPLE_MS) continue;
+        double x = (double)(s.local - minL);
+        double y = (double)s.offset;
+        sx += x; sy += y; sxx += x * x; sxy += x * y;
+        n++;
+    }
+    double den = n * sxx - sx * sx;
+    if (n < 2 || den == 0) return;
+    double slope = (n * sxy - sx * sy) / den;
+    double limit = CLOCK_MAX_DRIFT_PPM * 1e-6;
+    if (slope > limit) slope = limit;
+    if (slope < -limit) slope = -limit;
+    _drift = slope;
+}
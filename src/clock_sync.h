@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stdint.h>
+
+// --- 交易所時鐘同步 ---
+// 以 /api/v3/time、HTTP Date 標頭或 SNTP 取樣，估計本地時鐘與交易所的偏移與漂移，
+// 提供單調遞增的「交易所時間」。純邏輯：本地時間由呼叫端傳入 (ms，64 位元不會溢位)。
+
+#define CLOCK_SAMPLES 8
+#define CLOCK_MAX_DRIFT_PPM 500
+#define CLOCK_DRIFT_MIN_SPAN_MS 600000   // 樣本跨度至少 10 分鐘才估計漂移
+#define CLOCK_GOOD_SAMPLE_MS 100         // 不確定度在此以內的樣本才用來估計漂移
+
+struct ClockSample {
+    uint64_t local;        // 樣本對應的本地時間 (送出與收到的中點)
+    int64_t offset;        // 交易所時間 - 本地時間
+    uint32_t uncertainty;  // 取樣當下的誤差上限 (RTT/2 + 來源本身的解析度)
+    uint32_t resolution;   // 來源本身的解析度：/api/v3/time 為 0、SNTP 50、Date 標頭 500
+};
+
+class ClockSync {
+public:
+    // RTT 補償：假設請求與回應路徑對稱，伺服器時間對應 localSend 與 localRecv 的中點。
+    // 滿了之後新樣本只取代解析度相同或更差的樣本 (最差的優先，其次最舊)，頻繁的 Date 樣本不會擠掉精確樣本
+    void addSample(uint64_t localSend, uint64_t localRecv, uint64_t serverMs, uint32_t resolutionMs = 0);
+    bool synced() const { return _count > 0; }
+    // 單調遞增的交易所時間；估計值往回修正時以半速前進直到追上，不會倒退
+    uint64_t nowMs(uint64_t local);
+    int64_t offsetMs(uint64_t local) const;
+    uint32_t uncertaintyMs(uint64_t local) const;
+    double driftPpm() const { return _drift * 1e6; }
+    int count() const { return _count; }
+    // 不確定度在 CLOCK_GOOD_SAMPLE_MS 以內的樣本數
+    int goodCount() const;
+
+private:
+    int best(uint64_t local) const;
+    uint32_t sampleUncertainty(const ClockSample& s, uint64_t local) const;
+    void estimateDrift();
+
+    ClockSample _samples[CLOCK_SAMPLES];
+    int _count = 0;
+    double _drift = 0;        // 每 1 ms 本地時間的偏移變化量
+    uint64_t _lastNow = 0;
+    uint64_t _lastLocal = 0;
+};
@@ -0,0 +1,208 @@
+#include "dns_cache.h"
+
+#include <WiFi.h>
+#include <WiFiUdp.h>
+
+DnsCache dnsCache;
+
+DnsEntry* DnsCache::find(const char* host) {
+    for (int i = 0; i < DNS_CACHE_SIZE; i++) {
+        if (_entries[i].host[0] && strcmp(_entries[i].host, host) == 0) return &_entries[i];
+    }
+    return nullptr;
+}
+
+// 找空位；滿了就覆蓋最久沒解析的紀錄
+DnsEntry* DnsCache::slot(const char* host) {
+    DnsEntry* e = find(host);
+    if (e) return e;
+    DnsEntry* oldest = &_entries[0];
+    for (int i = 0; i < DNS_CACHE_SIZE; i++) {
+        if (!_entries[i].host[0]) {
+            oldest = &_entries[i];
+            break;
+        }
+        if (_entries[i].resolvedAt < oldest->resolvedAt) oldest = &_entries[i];
+    }
+    *oldest = DnsEntry();
+    strlcpy(oldest->host, host, sizeof(oldest->host));
+    return oldest;
+}
+
+bool DnsCache::needsRefresh(const DnsEntry& e, uint32_t now) const {
+    if (e.resolvedAt == 0) return true;
+    // TTL 剩下不到 1/5 就提前刷新
+    uint32_t ttlMs = e.ttl * 1000;
+    return now - e.resolvedAt > ttlMs - ttlMs / 5;
+}
+
+bool DnsCache::resolve(const char* host, IPAddress& out) {
+    uint32_t now = millis();
+    portENTER_CRITICAL(&_mux);
+    DnsEntry* e = find(host);
+    bool cached = e && e->resolvedAt && now - e->resolvedAt < e->ttl * 1000 + DNS_STALE_GRACE_MS;
+    if (cached) {
+        e->hits++;
+        out = e->ip;
+    }
+    portEXIT_CRITICAL(&_mux);
+    return cached || lookup(host, out);
+}
+
+void DnsCache::prefetch(const char* host) {
+    portENTER_CRITICAL(&_mux);
+    DnsEntry* e = find(host);
+    bool stale = !e || needsRefresh(*e, millis());
+    portEXIT_CRITICAL(&_mux);
+    IPAddress ip;
+    if (stale) lookup(host, ip);
+}
+
+void DnsCache::refresh() {
+    if (WiFi.status() != WL_CONNECTED) return;
+    char host[sizeof(DnsEntry::host)] = "";
+    uint32_t now = millis();
+    portENTER_CRITICAL(&_mux);
+    for (int i = 0; i < DNS_CACHE_SIZE; i++) {
+        DnsEntry& e = _entries[i];
+        if (!e.host[0] || !needsRefresh(e, now)) continue;
+        // 連續失敗時不要每輪都重試
+        if (e.failures && (int32_t)(now - e.retryAt) < 0) continue;
+        memcpy(host, e.host, sizeof(host));
+        break;
+    }
+    portEXIT_CRITICAL(&_mux);
+    IPAddress ip;
+    if (host[0]) lookup(host, ip);
+}
+
+// 查詢在鎖外進行 (最多 DNS_QUERY_TIMEOUT_MS)，結果再寫回表中；紀錄在查詢期間被換掉也只是重新佔一格
+bool DnsCache::lookup(const char* host, IPAddress& out) {
+    uint32_t start = millis();
+    IPAddress ip;
+    uint32_t ttl = 0;
+    bool ok = query(host, ip, ttl);
+    if (!ok) {
+        // 自己的查詢失敗時退回系統解析器，拿不到 TTL 就用預設值
+        ok = WiFi.hostByName(host, ip) == 1;
+        ttl = DNS_FALLBACK_TTL_S;
+    }
+    uint32_t now = millis();
+    portENTER_CRITICAL(&_mux);
+    DnsEntry& e = *slot(host);
+    e.lookups++;
+    e.lastLatencyMs = now - start;
+    if (ok) {
+        e.failures = 0;
+        e.ip = ip;
+        e.ttl = constrain(ttl, DNS_TTL_MIN_S, DNS_TTL_MAX_S);
+        e.resolvedAt = now;
+    } else {
+        e.failures++;
+        // 失敗時保留舊 IP，讓 refresh() 稍後再試
+        e.retryAt = now + DNS_RETRY_MS;
+    }
+    portEXIT_CRITICAL(&_mux);
+    if (ok) out = ip;
+    return ok;
+}
+
+// 直接向 DHCP 給的 DNS 伺服器送 A 查詢，以取得 TTL (系統解析器不提供)
+bool DnsCache::query(const char* host, IPAddress& ip, uint32_t& ttl) {
+    IPAddress server = WiFi.dnsIP(0);
+    if (server == IPAddress(0, 0, 0, 0)) return false;
+
+    uint8_t pkt[512];
+    uint16_t id = (uint16_t)esp_random();
+    size_t n = 0;
+    pkt[n++] = id >> 8; pkt[n++] = id & 0xff;
+    pkt[n++] = 0x01; pkt[n++] = 0x00;          // RD
+    pkt[n++] = 0; pkt[n++] = 1;                // QDCOUNT
+    memset(pkt + n, 0, 6); n += 6;             // AN / NS / AR
+    const char* label = host;
+    while (*label) {
+        const char* dot = strchr(label, '.');
+        size_t len = dot ? (size_t)(dot - label) : strlen(label);
+        if (len == 0 || len > 63 || n + len + 6 > sizeof(pkt)) return false;
+        pkt[n++] = len;
+        memcpy(pkt + n, label, len);
+        n += len;
+        label += len + (dot ? 1 : 0);
+    }
+    pkt[n++] = 0;
+    pkt[n++] = 0; pkt[n++] = 1;                // QTYPE A
+    pkt[n++] = 0; pkt[n++] = 1;                // QCLASS IN
+
+    WiFiUDP udp;
+    if (!udp.begin(0)) return false;
+    udp.beginPacket(server, 53);
+    udp.write(pkt, n);
+    udp.endPacket();
+
+    uint32_t start = millis();
+    int len = 0;
+    while (millis() - start < DNS_QUERY_TIMEOUT_MS) {
+        if (udp.parsePacket() > 0) {
+            len = udp.read(pkt, sizeof(pkt));
+            if (len >= 12 && pkt[0] == (id >> 8) && pkt[1] == (id & 0xff)) break;
+            len = 0;
+        }
+        delay(5);
+    }
+    udp.stop();
+    if (len < 12 || (pkt[3] & 0x0f) != 0) return false;   // RCODE != 0
+
+    uint16_t qd = (pkt[4] << 8) | pkt[5];
+    uint16_t an = (pkt[6] << 8) | pkt[7];
+    size_t p = 12;
+    // 跳過名稱：一般標籤或 0xC0 壓縮指標
+    auto skipName = [&]() -> bool {
+        while (p < (size_t)len) {
+            uint8_t l = pkt[p];
+            if ((l & 0xc0) == 0xc0) { p += 2; return p <= (size_t)len; }
+            p++;
+            if (l == 0) return true;
+            p += l;
+        }
+        return false;
+    };
+    for (int i = 0; i < qd; i++) {
+        if (!skipName()) return false;
+        p += 4;
+    }
+    bool found = false;
+    uint32_t minTtl = UINT32_MAX;
+    for (int i = 0; i < an; i++) {
+        if (!skipName() || p + 10 > (size_t)len) return false;
+        uint16_t type = (pkt[p] << 8) | pkt[p + 1];
+        uint32_t rrTtl = ((uint32_t)pkt[p + 4] << 24) | ((uint32_t)pkt[p + 5] << 16) | (pkt[p + 6] << 8) | pkt[p + 7];
+        uint16_t rdlen = (pkt[p + 8] << 8) | pkt[p + 9];
+        p += 10;
+        if (p + rdlen > (size_t)len) return false;
+        // CNAME 鏈上的 TTL 也要算進去，取最小值
+        if (rrTtl < minTtl) minTtl = rrTtl;
+        if (type == 1 && rdlen == 4 && !found) {
+            ip = IPAddress(pkt[p], pkt[p + 1], pkt[p + 2], pkt[p + 3]);
+            found = true;
+        }
+        p += rdlen;
+    }
+    if (!found) return false;
+    ttl = minTtl;
+    return true;
+}
+
+void DnsCache::printStats(Print& out) const {
+    // 先複製一份，不在 critical section 內印 Serial
+    DnsEntry entries[DNS_CACHE_SIZE];
+    portENTER_CRITICAL(&_mux);
+    for (int i = 0; i < DNS_CACHE_SIZE; i++) entries[i] = _entries[i];
+    portEXIT_CRITICAL(&_mux);
+    for (int i = 0; i < DNS_CACHE_SIZE; i++) {
+        const DnsEntry& e = entries[i];
+        if (!e.host[0]) continue;
+        uint32_t age = (millis() - e.resolvedAt) / 1000;
+        out.printf("[dns] %s -> %s ttl=%us age=%us lookups=%u hits=%u fail=%u last=%ums\n",
+                   e.host, e.ip.toString().c_str(), e.ttl, age, e.lookups, e.hits, e.failures, e.lastLatencyMs);
+    }
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <Arduino.h>
+#include <IPAddress.h>
+
+// --- DNS 快取：依 TTL 保存解析結果，到期前在背景重新解析 ---
+// 熱路徑 (建立連線) 只查表；過期但仍在寬限期內的紀錄照常使用，同時排入背景刷新。
+// 網路 task 與 exchange_set 的 worker 會同時使用：查表與寫入在 critical section 內，查詢本身在鎖外。
+
+#define DNS_CACHE_SIZE 8
+#define DNS_TTL_MIN_S 10
+#define DNS_TTL_MAX_S 3600
+#define DNS_FALLBACK_TTL_S 60      // 只能用系統解析器 (拿不到 TTL) 時的假定 TTL
+#define DNS_STALE_GRACE_MS 300000  // 過期後仍可沿用的時間，避免熱路徑等待 DNS
+#define DNS_QUERY_TIMEOUT_MS 1500
+#define DNS_RETRY_MS 10000
+
+struct DnsEntry {
+    char host[64];
+    IPAddress ip;
+    uint32_t ttl;           // 秒
+    uint32_t resolvedAt;    // millis()
+    uint32_t retryAt;       // 失敗後下次重試的 millis()
+    uint32_t lastLatencyMs;
+    uint32_t lookups;       // 實際送出的查詢次數
+    uint32_t hits;          // 直接由快取回答
+    uint32_t failures;
+};
+
+class DnsCache {
+public:
+    // 有快取 (含寬限期內的過期紀錄) 立即回傳；完全沒有紀錄時才同步查詢
+    bool resolve(const char* host, IPAddress& out);
+    // 預先解析，之後的 resolve() 不會阻塞
+    void prefetch(const char* host);
+    // 由網路 task 閒置時呼叫：每次最多刷新一筆快到期的紀錄
+    void refresh();
+    void printStats(Print& out) const;
+
+private:
+    DnsEntry* find(const char* host);
+    DnsEntry* slot(const char* host);
+    bool lookup(const char* host, IPAddress& out);
+    bool query(const char* host, IPAddress& ip, uint32_t& ttl);
+    bool needsRefresh(const DnsEntry& e, uint32_t now) const;
+
+    DnsEntry _entries[DNS_CACHE_SIZE] = {};
+    mutable portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+};
+
+extern DnsCache dnsCache;
@@ -0,0 +1,118 @@
+#include "endpoint_pool.h"
+
+#include <string.h>
+#include <stdlib.h>
+
+int EndpointPool::begin(const char* list, uint16_t defaultPort) {
+    _count = 0;
+    _picks = 0;
+    _explorePending = false;
+    const char* p = list;
+    while (*p && _count < POOL_MAX_ENDPOINTS) {
+        const char* end = strchr(p, ',');
+        size_t len = end ? (size_t)(end - p) : strlen(p);
+        while (len && *p == ' ') { p++; len--; }
+        if (len) {
+            Endpoint& e = _eps[_count];
+            memset(&e, 0, sizeof(e));
+            const char* colon = (const char*)memchr(p, ':', len);
+            size_t hostLen = colon ? (size_t)(colon - p) : len;
+            if (hostLen >= POOL_HOST_LEN) hostLen = POOL_HOST_LEN - 1;
+            memcpy(e.host, p, hostLen);
+            e.host[hostLen] = '\0';
+            e.port = colon ? (uint16_t)atoi(colon + 1) : defaultPort;
+            e.openMs = POOL_OPEN_MIN_MS;
+            _count++;
+        }
+        if (!end) break;
+        p = end + 1;
+    }
+    return _count;
+}
+
+float EndpointPool::score(int idx) const {
+    const Endpoint& e = _eps[idx];
+    float latency = e.latencyMs > 0 ? e.latencyMs : POOL_PRIOR_LATENCY_MS;
+    return latency + e.errorScore * POOL_ERROR_PENALTY_MS;
+}
+
+// 斷路器：冷卻期過了就進入半開，放一個請求過去試探
+bool EndpointPool::usable(int idx, uint64_t now) {
+    Endpoint& e = _eps[idx];
+    if (e.state == BREAKER_OPEN && now >= e.openUntil) e.state = BREAKER_HALF_OPEN;
+    return e.state != BREAKER_OPEN;
+}
+
+int EndpointPool::pick(uint64_t now, int current, int exclude, bool keepAlive) {
+    if (_count == 0) return -1;
+    _picks++;
+
+    int best = -1;
+    int stalest = -1;
+    int probe = -1;
+    for (int i = 0; i < _count; i++) {
+        if (i == exclude || !usable(i, now)) continue;
+        if (_eps[i].state == BREAKER_HALF_OPEN) {
+            if (probe < 0) probe = i;
+            continue;
+        }
+        if (best < 0 || score(i) < score(best)) best = i;
+        if (stalest < 0 || _eps[i].lastUsed < _eps[stalest].lastUsed) stalest = i;
+    }
+    bool healthy = keepAlive && current >= 0 && current != exclude && _eps[current].state == BREAKER_CLOSED;
+    // 半開的端點要放一個請求過去試探，確認恢復後才能重新排進來；
+    // 與量測相同，目前的 keep-alive 還健康時不為此重新握手，等連線斷了再試
+    if (probe >= 0 && !healthy) return probe;
+    if (best < 0) {
+        // 全部跳脫：挑最快結束冷卻的那台，總比完全不請求好
+        for (int i = 0; i < _count; i++) {
+            if (i == exclude && _count > 1) continue;
+            if (best < 0 || _eps[i].openUntil < _eps[best].openUntil) best = i;
+        }
+        return best;
+    }
+    // 偶爾用最久沒用的端點量測一次，讓延遲分數跟得上網路變化；
+    // 目前的 keep-alive 還健康時先記著，等連線斷了本來就要重新握手時再換
+    if (_picks % POOL_EXPLORE_EVERY == 0) _explorePending = true;
+    if (_explorePending && !healthy && stalest >= 0) {
+        _explorePending = false;
+        return stalest;
+    }
+    // 遲滯：目前的連線還可用且差距不大就不換，避免來回重新握手
+    if (current >= 0 && current != exclude && current != best && _eps[current].state == BREAKER_CLOSED &&
+        score(best) > score(current) * POOL_SWITCH_RATIO) {
+        return current;
+    }
+    return best;
+}
+
+void EndpointPool::onSuccess(int idx, uint32_t latencyMs, uint64_t now) {
+    if (idx < 0 || idx >= _count) return;
+    Endpoint& e = _eps[idx];
+    e.requests++;
+    e.lastUsed = now;
+    e.latencyMs = e.latencyMs > 0 ? e.latencyMs + POOL_EWMA_ALPHA * (latencyMs - e.latencyMs) : latencyMs;
+    e.errorScore *= POOL_ERROR_DECAY;
+    e.consecutiveFailures = 0;
+    e.state = BREAKER_CLOSED;
+    e.openMs = POOL_OPEN_MIN_MS;
+}
+
+void EndpointPool::onFailure(int idx, uint64_t now) {
+    if (idx < 0 || idx >= _count) return;
+    Endpoint& e = _eps[idx];
+    e.requests++;
+    e.failures++;
+    e.lastUsed = now;
+    e.errorScore += 1.0f;
+    e.consecutiveFailures++;
+    if (e.state == BREAKER_HALF_OPEN) {
+        // 試探失敗：重新跳脫，冷卻時間加倍
+        e.openMs = e.openMs * 2 > POOL_OPEN_MAX_MS ? POOL_OPEN_MAX_MS : e.openMs * 2;
+    } else if (e.consecutiveFailures < POOL_TRIP_FAILURES) {
+        return;
+    }
+    e.state = BREAKER_OPEN;
+    e.openUntil = now + e.openMs;
+    e.trips++;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <stdint.h>
+
+// --- 多端點選路：依延遲與錯誤分數挑選 REST 主機，每台主機各自有斷路器 ---
+// 純邏輯，不呼叫 millis()：時間由呼叫端傳入，可在主機上以假時鐘與假延遲驗證。
+
+#define POOL_MAX_ENDPOINTS 8
+#define POOL_HOST_LEN 40
+#define POOL_EWMA_ALPHA 0.25f         // 新延遲樣本的權重
+#define POOL_PRIOR_LATENCY_MS 400     // 還沒量過的端點假定延遲
+#define POOL_ERROR_PENALTY_MS 1000    // 錯誤分數 1.0 相當於多 1 秒延遲
+#define POOL_ERROR_DECAY 0.5f         // 成功一次錯誤分數減半
+#define POOL_SWITCH_RATIO 0.8f        // 別的端點要快 20% 以上才換 (換主機要重新握手)
+#define POOL_EXPLORE_EVERY 32         // 每 32 次請求改用最久沒用的端點重新量測 (等到需要重新連線時才換)
+#define POOL_TRIP_FAILURES 3          // 連續失敗幾次跳脫
+#define POOL_OPEN_MIN_MS 10000        // 跳脫後冷卻時間，半開試探再失敗就加倍
+#define POOL_OPEN_MAX_MS 300000
+
+enum BreakerState : uint8_t { BREAKER_CLOSED, BREAKER_OPEN, BREAKER_HALF_OPEN };
+
+struct Endpoint {
+    char host[POOL_HOST_LEN];
+    uint16_t port;
+    float latencyMs;          // EWMA，0 表示還沒量過
+    float errorScore;         // 失敗 +1，成功減半
+    BreakerState state;
+    uint8_t consecutiveFailures;
+    uint32_t openMs;          // 目前的冷卻時間
+    uint64_t openUntil;
+    uint64_t lastUsed;
+    uint32_t requests;
+    uint32_t failures;
+    uint32_t trips;
+};
+
+class EndpointPool {
+public:
+    // list 為 "host[:port],host[:port],..."，沒寫埠號就用 defaultPort
+    int begin(const char* list, uint16_t defaultPort);
+    // 挑選這次請求要用的端點；current 為目前連線中的端點 (-1 表示沒有)，
+    // keepAlive 表示 current 的連線還開著：此時不為了量測而換主機，省下一次握手
+    int pick(uint64_t now, int current, int exclude = -1, bool keepAlive = false);
+    void onSuccess(int idx, uint32_t latencyMs, uint64_t now);
+    void onFailure(int idx, uint64_t now);
+    float score(int idx) const;
+    int count() const { return _count; }
+    const Endpoint& at(int idx) const { return _eps[idx]; }
+
+private:
+    bool usable(int idx, uint64_t now);
+
+    Endpoint _eps[POOL_MAX_ENDPOINTS] = {};
+    int _count = 0;
+    uint32_t _picks = 0;
+    bool _explorePending = false;
+};
@@ -0,0 +1,118 @@
+#include "exchange.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// --- Binance：/api/v3/klines 由舊到新，可用 startTime 增量抓取 ---
+static const TickerLayout BINANCE_TICKER = {"price", 1, -1};
+
+class BinanceAdapter : public ExchangeAdapter {
+public:
+    BinanceAdapter() : ExchangeAdapter("binance", BINANCE_HOSTS, BINANCE_KLINE_LAYOUT, BINANCE_TICKER) {}
+    bool klinePath(char* buf, size_t len, int idx, const KLineSeries& s, bool& incremental) const override {
+        incremental = s.full();
+        size_t n;
+        if (incremental) {
+            n = snprintf(buf, len, "/api/v3/klines?symbol=BTCUSDT&interval=%s&startTime=%llu&limit=%d",
+                         intervals[idx], (unsigned long long)s.lastOpenTime(), incrementalLimit());
+        } else {
+            n = snprintf(buf, len, "/api/v3/klines?symbol=BTCUSDT&interval=%s&limit=%d", intervals[idx], KLINE_COUNT);
+        }
+        return n < len;
+    }
+    bool tickerPath(char* buf, size_t len) const override {
+        return (size_t)snprintf(buf, len, "/api/v3/ticker/price?symbol=BTCUSDT") < len;
+    }
+};
+
+// --- Coinbase Exchange：[[time(s), low, high, open, close, volume], ...] 由新到舊、數字不加引號。
+// 固定回 300 列，沒有 limit 參數；沒有 4h (只有 6h)
+static const KLineLayout COINBASE_KLINES = {2, 0, 3, 2, 1, 4, 1000, true};
+static const TickerLayout COINBASE_TICKER = {"price", 1, -1};
+static const uint32_t coinbaseGranularity[INTERVAL_COUNT] = {60, 300, 3600, 0, 86400};
+
+class CoinbaseAdapter : public ExchangeAdapter {
+public:
+    CoinbaseAdapter() : ExchangeAdapter("coinbase", COINBASE_HOSTS, COINBASE_KLINES, COINBASE_TICKER) {}
+    bool klinePath(char* buf, size_t len, int idx, const KLineSeries& s, bool& incremental) const override {
+        incremental = false;
+        if (!supports(idx)) return false;
+        return (size_t)snprintf(buf, len, "/products/BTC-USD/candles?granularity=%u", coinbaseGranularity[idx]) < len;
+    }
+    bool supports(int idx) const override { return coinbaseGranularity[idx] != 0; }
+    bool tickerPath(char* buf, size_t len) const override {
+        return (size_t)snprintf(buf, len, "/products/BTC-USD/ticker") < len;
+    }
+};
+
+// --- Kraken：{"error":[],"result":{"XBTUSDT":[[time(s),"o","h","l","c","vwap","vol",n], ...],"last":t}}
+// 由舊到新，一次最多 720 列；since (秒) 之後的增量
+static const KLineLayout KRAKEN_KLINES = {4, 0, 1, 2, 3, 4, 1000, false};
+static const TickerLayout KRAKEN_TICKER = {"c", 3, 0};   // "c": [最新成交價, 成交量]
+static const uint16_t krakenMinutes[INTERVAL_COUNT] = {1, 5, 60, 240, 1440};
+
+class KrakenAdapter : public ExchangeAdapter {
+public:
+    KrakenAdapter() : ExchangeAdapter("kraken", KRAKEN_HOSTS, KRAKEN_KLINES, KRAKEN_TICKER) {}
+    bool klinePath(char* buf, size_t len, int idx, const KLineSeries& s, bool& incremental) const override {
+        incremental = s.full();
+        size_t n;
+        if (incremental) {
+            // since 不含本身，往前退一秒讓最後一根 (未收盤) 也一起回來
+            n = snprintf(buf, len, "/0/public/OHLC?pair=XBTUSDT&interval=%u&since=%llu", krakenMinutes[idx],
+                         (unsigned long long)(s.lastOpenTime() / 1000 - 1));
+        } else {
+            n = snprintf(buf, len, "/0/public/OHLC?pair=XBTUSDT&interval=%u", krakenMinutes[idx]);
+        }
+        return n < len;
+    }
+    bool tickerPath(char* buf, size_t len) const override {
+        return (size_t)snprintf(buf, len, "/0/public/Ticker?pair=XBTUSDT") < len;
+    }
+    int incrementalLimit() const override { return 720; }
+};
+
+// --- OKX：{"code":"0","data":[["ts(ms)","o","h","l","c",...], ...]} 由新到舊。
+// 日線用 1Dutc 才會和其他交易所一樣以 UTC 0 點為界
+static const KLineLayout OKX_KLINES = {3, 0, 1, 2, 3, 4, 1, true};
+static const TickerLayout OKX_TICKER = {"last", 3, -1};
+static const char* const okxBars[INTERVAL_COUNT] = {"1m", "5m", "1H", "4H", "1Dutc"};
+
+class OkxAdapter : public ExchangeAdapter {
+public:
+    OkxAdapter() : ExchangeAdapter("okx", OKX_HOSTS, OKX_KLINES, OKX_TICKER) {}
+    bool klinePath(char* buf, size_t len, int idx, const KLineSeries& s, bool& incremental) const override {
+        incremental = false;
+        return (size_t)snprintf(buf, len, "/api/v5/market/candles?instId=BTC-USDT&bar=%s&limit=%d", okxBars[idx],
+                                KLINE_COUNT) < len;
+    }
+    bool tickerPath(char* buf, size_t len) const override {
+        return (size_t)snprintf(buf, len, "/api/v5/market/ticker?instId=BTC-USDT") < len;
+    }
+};
+
+static const BinanceAdapter binanceAdapter;
+static const CoinbaseAdapter coinbaseAdapter;
+static const KrakenAdapter krakenAdapter;
+static const OkxAdapter okxAdapter;
+
+const ExchangeAdapter* const exchanges[EXCHANGE_COUNT] = {&binanceAdapter, &coinbaseAdapter, &krakenAdapter,
+                                                           &okxAdapter};
+
+bool TickerFetch::write(const uint8_t* data, size_t len) {
+    _parser.feed(data, len);
+    return !_parser.error();
+}
+
+void TickerFetch::onKey(int depth, const char* key) {
+    if (depth == _layout.depth) _match = strcmp(key, _layout.key) == 0;
+}
+
+void TickerFetch::onValue(int depth, int index, const char* value, bool isString) {
+    if (!_match) return;
+    if (_layout.index < 0 ? depth == _layout.depth : depth == _layout.depth + 1 && index == _layout.index) {
+        _price = strtof(value, nullptr);
+        _match = false;
+    }
+}
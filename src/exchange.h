@@ -0,0 +1,92 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "transport.h"
+#include "json_stream.h"
+#include "kline_parser.h"
+
+// --- 交易所轉接層：同一套 K線 / 價格流程對接 Binance、Coinbase、Kraken、OKX ---
+// 每個轉接器只描述 REST 路徑與回應欄位的對應，抓取與解析共用 KLineFetch / TickerFetch。
+// 不依賴 Arduino，可在主機上對著 tools/mock_binance.py 回放的回應驗證。
+
+enum ExchangeId : uint8_t { EXCHANGE_BINANCE, EXCHANGE_COINBASE, EXCHANGE_KRAKEN, EXCHANGE_OKX, EXCHANGE_COUNT };
+
+// --- 各交易所的 API 位址 (可用 build_flags 指向本地 TLS 測試伺服器) ---
+// BINANCE_HOSTS 為端點清單 "host[:port],..."；只設定 BINANCE_HOST 時清單就只有那一台
+#ifndef BINANCE_HOSTS
+#ifdef BINANCE_HOST
+#define BINANCE_HOSTS BINANCE_HOST
+#else
+#define BINANCE_HOSTS "api.binance.com,api1.binance.com,api2.binance.com,api3.binance.com,api4.binance.com,data-api.binance.vision"
+#endif
+#endif
+#ifndef BINANCE_HOST
+#define BINANCE_HOST "api.binance.com"
+#endif
+#ifndef BINANCE_PORT
+#define BINANCE_PORT 443
+#endif
+#ifndef COINBASE_HOSTS
+#define COINBASE_HOSTS "api.exchange.coinbase.com"
+#endif
+#ifndef KRAKEN_HOSTS
+#define KRAKEN_HOSTS "api.kraken.com"
+#endif
+#ifndef OKX_HOSTS
+#define OKX_HOSTS "www.okx.com,aws.okx.com"
+#endif
+
+// 價格欄位的位置：key 所在的層數；index >= 0 表示 key 的值是陣列，取其中第 index 個
+struct TickerLayout {
+    const char* key;
+    uint8_t depth;
+    int8_t index;
+};
+
+class ExchangeAdapter {
+public:
+    ExchangeAdapter(const char* name, const char* hosts, const KLineLayout& klines, const TickerLayout& ticker)
+        : _name(name), _hosts(hosts), _klines(klines), _ticker(ticker) {}
+    virtual ~ExchangeAdapter() {}
+    const char* name() const { return _name; }
+    // 端點清單 "host[:port],..."，交給 EndpointPool
+    const char* hosts() const { return _hosts; }
+    const KLineLayout& klineLayout() const { return _klines; }
+    const TickerLayout& tickerLayout() const { return _ticker; }
+    // 該週期的 K線路徑；交易所沒有這個週期時回傳 false。
+    // incremental 表示只抓序列最後一根之後的資料 (回滿一頁代表中間有缺口)
+    virtual bool klinePath(char* buf, size_t len, int intervalIdx, const KLineSeries& series,
+                           bool& incremental) const = 0;
+    virtual bool tickerPath(char* buf, size_t len) const = 0;
+    virtual bool supports(int intervalIdx) const { return true; }
+    // 增量請求一次最多回幾列：回滿才可能還有沒抓到的 K線。
+    // 回應含序列最後一根本身，要求 KLINE_COUNT + 1 列時剛好補滿一整組還不算缺口
+    virtual int incrementalLimit() const { return KLINE_COUNT + 1; }
+
+private:
+    const char* _name;
+    const char* _hosts;
+    const KLineLayout& _klines;
+    const TickerLayout& _ticker;
+};
+
+extern const ExchangeAdapter* const exchanges[EXCHANGE_COUNT];
+
+// 一次價格請求：body 串流解析，只取出 layout 指定的欄位
+class TickerFetch : public BodySink, private JsonStreamHandler {
+public:
+    explicit TickerFetch(const ExchangeAdapter& adapter) : _layout(adapter.tickerLayout()), _parser(*this) {}
+    bool write(const uint8_t* data, size_t len) override;
+    bool parsed() { return _parser.done() && _price > 0; }
+    float price() const { return _price; }
+
+private:
+    void onKey(int depth, const char* key) override;
+    void onValue(int depth, int index, const char* value, bool isString) override;
+
+    const TickerLayout& _layout;
+    JsonStreamParser _parser;
+    bool _match = false;
+    float _price = 0;
+};
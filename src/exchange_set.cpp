@@ -0,0 +1,176 @@
+#include "exchange_set.h"
+
+#include "tls_ca.h"
+
+ExchangeSet exchangeSet;
+
+// 各交易所的 TLS session 分開存，互不覆蓋
+static const char* const sessionNs[EXCHANGE_COUNT] = {"tls", "tls-cb", "tls-kr", "tls-okx"};
+
+void ExchangeSet::begin() {
+    for (int ex = 1; ex < EXCHANGE_COUNT; ex++) {
+        if (!(EXCHANGE_ENABLED & (1 << ex))) continue;
+        _conns[ex] = new RestConn();
+        _conns[ex]->begin(exchanges[ex]->hosts(), 443, BINANCE_CA_BUNDLE, EXCHANGE_CA_BUNDLE, sessionNs[ex]);
+        // ticker 回應只有幾百 bytes，不值得每條連線各配一組解壓視窗 (32 KB + 約 11 KB)
+        _conns[ex]->setGzip(false);
+    }
+    if (!(EXCHANGE_ENABLED & ~1)) return;
+    _jobs = xQueueCreate(EXCHANGE_COUNT, sizeof(uint8_t));
+    for (int i = 0; i < EXCHANGE_WORKERS; i++) {
+        xTaskCreatePinnedToCore(worker, "exch", EXCHANGE_TASK_STACK, this, 1, nullptr, 0);
+    }
+}
+
+void ExchangeSet::worker(void* arg) {
+    ExchangeSet* self = (ExchangeSet*)arg;
+    uint8_t ex;
+    for (;;) {
+        if (xQueueReceive(self->_jobs, &ex, portMAX_DELAY) == pdTRUE) self->fetchTicker(ex);
+    }
+}
+
+// 由 poll() 搶到 _busy 之後才會排進佇列，同一個交易所同時只有一個 worker 在用
+void ExchangeSet::fetchTicker(int ex) {
+    RestConn& conn = *_conns[ex];
+    char path[96];
+    TickerFetch fetch(*exchanges[ex]);
+    makeRoom(ex);
+    uint32_t t0 = millis();
+    int httpCode = exchanges[ex]->tickerPath(path, sizeof(path)) ? conn.get(path, fetch) : HTTPC_ERROR_NOT_CONNECTED;
+    ExchangeStats& st = _stats[ex];
+    st.lastCode = httpCode;
+    st.lastMs = millis() - t0;
+    if (httpCode == HTTP_CODE_OK && fetch.parsed()) {
+        st.ok++;
+        report(ex, fetch.price(), millis());
+    } else {
+        st.failures++;
+        // 失敗才關閉；成功時保留 keep-alive，每 15 秒一次的請求不必重新握手
+        conn.close();
+    }
+    release(ex);
+}
+
+// 呼叫端已持有 ex：ex 還沒連線且開著的連線已達 EXCHANGE_WORKERS 時，關掉最久沒用的閒置連線。
+// 使用中的連線不能關，全部都在使用中時就先超過上限 (最多多出 net task 借用的那一條)
+void ExchangeSet::makeRoom(int ex) {
+    if (_open[ex]) return;
+    for (;;) {
+        int open = 0, victim = -1;
+        uint32_t now = millis();
+        for (int o = 1; o < EXCHANGE_COUNT; o++) {
+            if (o == ex || !_open[o]) continue;
+            open++;
+            if (_busy[o]) continue;
+            if (victim < 0 || now - _usedAt[o] > now - _usedAt[victim]) victim = o;
+        }
+        if (open < EXCHANGE_WORKERS || victim < 0) return;
+        bool idle = false;
+        if (!_busy[victim].compare_exchange_strong(idle, true)) continue;
+        _conns[victim]->close();
+        _open[victim] = false;
+        _busy[victim] = false;
+    }
+}
+
+void ExchangeSet::release(int ex) {
+    _open[ex] = _conns[ex]->connected();
+    _usedAt[ex] = millis();
+    _busy[ex] = false;
+}
+
+void ExchangeSet::poll(uint32_t now) {
+    if (!_jobs || WiFi.status() != WL_CONNECTED) return;
+    for (uint8_t ex = 1; ex < EXCHANGE_COUNT; ex++) {
+        if (!_conns[ex] || now - _polledAt[ex] < EXCHANGE_POLL_MS) continue;
+        bool idle = false;
+        if (!_busy[ex].compare_exchange_strong(idle, true)) continue;
+        _polledAt[ex] = now;
+        if (xQueueSend(_jobs, &ex, 0) != pdTRUE) _busy[ex] = false;
+    }
+}
+
+void ExchangeSet::report(int ex, float price, uint32_t now) {
+    if (price <= 0) return;
+    portENTER_CRITICAL(&_mux);
+    _prices[ex] = price;
+    _quotedAt[ex] = now;
+    portEXIT_CRITICAL(&_mux);
+}
+
+bool ExchangeSet::price(float& out, uint32_t now) const {
+    float fresh[EXCHANGE_COUNT];
+    int n = 0;
+    uint32_t newest = UINT32_MAX;
+    portENTER_CRITICAL(&_mux);
+    bool binanceFresh = _quotedAt[EXCHANGE_BINANCE] && now - _quotedAt[EXCHANGE_BINANCE] <= EXCHANGE_FRESH_MS;
+    if (PRICE_SELECT == PRICE_BINANCE && binanceFresh) {
+        fresh[n++] = _prices[EXCHANGE_BINANCE];
+    }
+    for (int ex = 0; ex < EXCHANGE_COUNT && !n; ex++) {
+        if (!_quotedAt[ex] || now - _quotedAt[ex] > EXCHANGE_FRESH_MS) continue;
+        if (PRICE_SELECT == PRICE_FRESHEST) {
+            if (now - _quotedAt[ex] < newest) {
+                newest = now - _quotedAt[ex];
+                fresh[0] = _prices[ex];
+                n = 1;
+            }
+        } else {
+            fresh[n++] = _prices[ex];
+        }
+    }
+    portEXIT_CRITICAL(&_mux);
+    if (!n) return false;
+    // 最多四筆，插入排序即可
+    for (int i = 1; i < n; i++) {
+        for (int j = i; j > 0 && fresh[j] < fresh[j - 1]; j--) std::swap(fresh[j], fresh[j - 1]);
+    }
+    out = n % 2 ? fresh[n / 2] : (fresh[n / 2 - 1] + fresh[n / 2]) / 2;
+    return true;
+}
+
+int ExchangeSet::healthiest(uint32_t now, int exclude) const {
+    int best = -1;
+    uint32_t bestAge = EXCHANGE_FRESH_MS;
+    portENTER_CRITICAL(&_mux);
+    for (int ex = 0; ex < EXCHANGE_COUNT; ex++) {
+        if (ex == exclude || !enabled(ex) || !_quotedAt[ex]) continue;
+        if (now - _quotedAt[ex] <= bestAge) {
+            bestAge = now - _quotedAt[ex];
+            best = ex;
+        }
+    }
+    portEXIT_CRITICAL(&_mux);
+    return best;
+}
+
+RestConn* ExchangeSet::acquire(int ex) {
+    if (!_conns[ex]) return nullptr;
+    bool idle = false;
+    if (!_busy[ex].compare_exchange_strong(idle, true)) return nullptr;
+    makeRoom(ex);
+    return _conns[ex];
+}
+
+bool ExchangeSet::busy() const {
+    for (int ex = 0; ex < EXCHANGE_COUNT; ex++) {
+        if (_busy[ex]) return true;
+    }
+    return false;
+}
+
+// [exch] 各交易所：最新報價 / 報價年齡 / 成功 / 失敗 / 最近狀態碼與耗時，最後是選出的價格
+void ExchangeSet::printStats(Print& out, uint32_t now) const {
+    out.print("[exch]");
+    for (int ex = 0; ex < EXCHANGE_COUNT; ex++) {
+        if (!enabled(ex)) continue;
+        const ExchangeStats& st = _stats[ex];
+        out.printf(" %s=%.1f(%us) ok=%u fail=%u last=%d/%ums", exchanges[ex]->name(), _prices[ex],
+                   _quotedAt[ex] ? (now - _quotedAt[ex]) / 1000 : 0, st.ok, st.failures, st.lastCode, st.lastMs);
+    }
+    float p;
+    static const char* const selectNames[] = {"binance", "median", "freshest"};
+    if (price(p, now)) out.printf(" -> %s %.1f", selectNames[PRICE_SELECT], p);
+    out.println();
+}
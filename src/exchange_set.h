@@ -0,0 +1,77 @@
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+#include "rest_conn.h"
+#include "exchange.h"
+
+// --- 多交易所報價 (預設關閉)：Binance 之外的交易所由背景 worker 並行抓價格，作為備援與交叉比對 ---
+// Binance 的價格由網路 task 的主流程 (串流 / ticker / K線) 回報；Binance 被封鎖或斷線時，
+// K線也可借用其他交易所的連線抓取，餵進同一組序列。
+// 只有價格是並行抓取再合併 (中位數 / 最新)；K線同時只有一個來源，不把多家的 K線合併成一組：
+// 各家的開高低收略有差異，混在一起會讓圖形在來源之間跳動，換來源時整組重抓。
+
+// 同時進行的請求數，也是其他交易所同時開著的 TLS 連線上限 (每條約 40 KB heap)：
+// 成功後保留 keep-alive，但要開新連線時若已達上限，先關掉最久沒用的閒置連線
+#ifndef EXCHANGE_WORKERS
+#define EXCHANGE_WORKERS 2
+#endif
+// 啟用的其他交易所 (位元遮罩，以 ExchangeId 為位元)；預設 0 只用 Binance，不建立 worker。
+// 例如 -D EXCHANGE_ENABLED="((1 << EXCHANGE_COINBASE) | (1 << EXCHANGE_KRAKEN) | (1 << EXCHANGE_OKX))"
+#ifndef EXCHANGE_ENABLED
+#define EXCHANGE_ENABLED 0
+#endif
+#define EXCHANGE_POLL_MS 15000     // 其他交易所的價格刷新間隔
+#define EXCHANGE_FRESH_MS 45000    // 超過這麼久的報價不參與選價
+#define EXCHANGE_TASK_STACK 10240
+
+// PRICE_BINANCE：Binance 的即時價格 (串流 / ticker) 新鮮時就用它，過期時才取其他交易所的中位數；
+// PRICE_MEDIAN / PRICE_FRESHEST：所有新鮮報價的中位數 / 最新的一筆 (USD 與 USDT 報價混在一起)
+enum PriceSelect : uint8_t { PRICE_BINANCE, PRICE_MEDIAN, PRICE_FRESHEST };
+#ifndef PRICE_SELECT
+#define PRICE_SELECT PRICE_BINANCE
+#endif
+
+struct ExchangeStats {
+    uint32_t ok;
+    uint32_t failures;
+    int lastCode;            // 最近一次的 HTTP 狀態碼或傳輸層錯誤
+    uint32_t lastMs;         // 最近一次請求耗時
+};
+
+class ExchangeSet {
+public:
+    void begin();
+    // 網路 task 每輪呼叫：到期且沒有在抓的交易所排進工作佇列
+    void poll(uint32_t now);
+    void report(int ex, float price, uint32_t now);
+    // 依 PRICE_SELECT 從新鮮的報價中選出價格；一筆都沒有時回傳 false
+    bool price(float& out, uint32_t now) const;
+    // 最近成功回報價格的交易所 (不含 exclude)，K線改用其他來源時的首選；都沒有時回傳 -1
+    int healthiest(uint32_t now, int exclude) const;
+    bool enabled(int ex) const { return ex == EXCHANGE_BINANCE || _conns[ex] != nullptr; }
+    // 借用某交易所的連線抓 K線，與背景 worker 互斥；正在使用中回傳 nullptr
+    RestConn* acquire(int ex);
+    // 歸還連線 (不關閉，保留 keep-alive)
+    void release(int ex);
+    bool busy() const;
+    void printStats(Print& out, uint32_t now) const;
+
+private:
+    static void worker(void* arg);
+    void fetchTicker(int ex);
+    void makeRoom(int ex);
+
+    RestConn* _conns[EXCHANGE_COUNT] = {};   // Binance 用網路 task 自己的連線，這裡不建立
+    float _prices[EXCHANGE_COUNT] = {};
+    uint32_t _quotedAt[EXCHANGE_COUNT] = {};
+    mutable portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+    std::atomic<bool> _busy[EXCHANGE_COUNT];
+    std::atomic<bool> _open[EXCHANGE_COUNT];       // 歸還時連線還開著 (使用中的也算開著)
+    std::atomic<uint32_t> _usedAt[EXCHANGE_COUNT]; // 最近一次歸還的 millis()
+    uint32_t _polledAt[EXCHANGE_COUNT] = {};
+    QueueHandle_t _jobs = nullptr;
+    ExchangeStats _stats[EXCHANGE_COUNT] = {};
+};
+
+extern ExchangeSet exchangeSet;
@@ -0,0 +1,89 @@
+#include "fetch_queue.h"
+
+void FetchQueue::begin(uint32_t seed) {
+    for (int i = 0; i < FETCH_MAX_KEYS; i++) _jobs[i] = {};
+    _rng = seed ? seed : 1;
+    _stats = {};
+}
+
+// 退避上限為 base * 2^(attempts-1)，實際等待取上限的 1/2 ~ 1 倍 (xorshift32 抖動)，
+// 避免多台裝置在同一次故障後同時重試
+uint32_t FetchQueue::backoff(uint8_t attempts) {
+    uint32_t cap = FETCH_RETRY_BASE_MS;
+    for (int i = 1; i < attempts && cap < FETCH_RETRY_MAX_MS; i++) cap *= 2;
+    if (cap > FETCH_RETRY_MAX_MS) cap = FETCH_RETRY_MAX_MS;
+    _rng ^= _rng << 13;
+    _rng ^= _rng >> 17;
+    _rng ^= _rng << 5;
+    return cap / 2 + _rng % (cap / 2 + 1);
+}
+
+bool FetchQueue::enqueue(int key, RatePriority prio, uint64_t now) {
+    if (key < 0 || key >= FETCH_MAX_KEYS) return false;
+    Job& j = _jobs[key];
+    bool recent = j.doneAt && now - j.doneAt < FETCH_COALESCE_MS;
+    if (j.queued || j.inFlight || recent) {
+        // 排隊中的低優先請求被使用者點到時提升為高優先，並取消退避等待
+        if (j.queued && prio < j.prio) {
+            j.prio = prio;
+            j.nextAt = now;
+        }
+        _stats.coalesced++;
+        return false;
+    }
+    j.queued = true;
+    j.prio = prio;
+    j.attempts = 0;
+    j.nextAt = now;
+    _stats.enqueued++;
+    return true;
+}
+
+int FetchQueue::next(uint64_t now, RatePriority* prio) {
+    int best = -1;
+    for (int i = 0; i < FETCH_MAX_KEYS; i++) {
+        const Job& j = _jobs[i];
+        if (!j.queued || j.inFlight || now < j.nextAt) continue;
+        if (best < 0 || j.prio < _jobs[best].prio ||
+            (j.prio == _jobs[best].prio && j.nextAt < _jobs[best].nextAt)) {
+            best = i;
+        }
+    }
+    if (best < 0) return -1;
+    _jobs[best].inFlight = true;
+    if (prio) *prio = _jobs[best].prio;
+    return best;
+}
+
+void FetchQueue::complete(int key, FetchOutcome outcome, bool retryable, uint64_t now) {
+    if (key < 0 || key >= FETCH_MAX_KEYS) return;
+    Job& j = _jobs[key];
+    j.inFlight = false;
+    _stats.outcomes[outcome]++;
+    if (outcome == FETCH_OK) {
+        j.queued = false;
+        j.doneAt = now;
+        return;
+    }
+    if (outcome == FETCH_DEFERRED) {
+        j.nextAt = now + FETCH_DEFER_MS;
+        return;
+    }
+    j.attempts++;
+    if (!retryable || j.attempts >= FETCH_MAX_ATTEMPTS) {
+        j.queued = false;
+        _stats.dropped++;
+        return;
+    }
+    j.nextAt = now + backoff(j.attempts);
+    _stats.retries++;
+}
+
+bool FetchQueue::pending(int key) const {
+    return key >= 0 && key < FETCH_MAX_KEYS && (_jobs[key].queued || _jobs[key].inFlight);
+}
+
+const char* FetchQueue::outcomeName(FetchOutcome outcome) {
+    static const char* names[] = {"ok", "dns", "connect", "tls", "read", "http", "parse", "deferred"};
+    return outcome < FETCH_OUTCOME_COUNT ? names[outcome] : "?";
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <stdint.h>
+#include "rate_budget.h"
+
+// --- REST 請求佇列：合併重複請求，暫時性失敗以指數退避 + 抖動重試 ---
+// 每個 key (K線週期) 最多只有一筆排隊或進行中的請求，優先權沿用權重預算的高 / 低。
+// 純邏輯，時間由呼叫端傳入。
+
+#define FETCH_MAX_KEYS 8
+#define FETCH_RETRY_BASE_MS 1000
+#define FETCH_RETRY_MAX_MS 30000
+#define FETCH_MAX_ATTEMPTS 5
+#define FETCH_DEFER_MS 1000          // 權重預算不足時多久後再試 (不算重試次數)
+#define FETCH_COALESCE_MS 1000       // 剛成功完成的 key 在這段時間內再被請求，直接視為已滿足
+
+// 請求結果分類，各自計數
+enum FetchOutcome : uint8_t {
+    FETCH_OK,
+    FETCH_DNS,        // 解析主機名稱失敗
+    FETCH_CONNECT,    // TCP 連線失敗
+    FETCH_TLS,        // TLS 握手失敗
+    FETCH_READ,       // 連線後讀寫失敗 / 逾時
+    FETCH_HTTP,       // 非 200 的 HTTP 狀態碼
+    FETCH_PARSE,      // 回應不完整或格式錯誤
+    FETCH_DEFERRED,   // 權重預算不足，沒有送出
+    FETCH_OUTCOME_COUNT
+};
+
+struct FetchStats {
+    uint32_t enqueued;
+    uint32_t coalesced;      // 重複請求被合併
+    uint32_t retries;
+    uint32_t dropped;        // 重試用完或不可重試而放棄
+    uint32_t outcomes[FETCH_OUTCOME_COUNT];
+};
+
+class FetchQueue {
+public:
+    void begin(uint32_t seed);
+    // 回傳 false 表示已有相同請求排隊 / 進行中 / 剛完成而被合併 (會提升成較高的優先權)
+    bool enqueue(int key, RatePriority prio, uint64_t now);
+    // 取出已到期、優先權最高的請求並標記為進行中；沒有則回傳 -1
+    int next(uint64_t now, RatePriority* prio = nullptr);
+    // retryable 為 false 的失敗 (例如 4xx) 直接放棄
+    void complete(int key, FetchOutcome outcome, bool retryable, uint64_t now);
+    bool pending(int key) const;
+    const FetchStats& stats() const { return _stats; }
+    static const char* outcomeName(FetchOutcome outcome);
+
+private:
+    struct Job {
+        bool queued;
+        bool inFlight;
+        RatePriority prio;
+        uint8_t attempts;
+        uint64_t nextAt;
+        uint64_t doneAt;
+    };
+
+    uint32_t backoff(uint8_t attempts);
+
+    Job _jobs[FETCH_MAX_KEYS] = {};
+    uint32_t _rng = 1;
+    FetchStats _stats = {};
+};
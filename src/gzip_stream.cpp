@@ -0,0 +1,142 @@
+#include "gzip_stream.h"
+
+#include <stdlib.h>
+
+#include "esp32/rom/crc.h"
+#include "esp32/rom/miniz.h"
+
+#define GZ_FHCRC 0x02
+#define GZ_FEXTRA 0x04
+#define GZ_FNAME 0x08
+#define GZ_FCOMMENT 0x10
+
+GzipInflater::~GzipInflater() {
+    free(_decomp);
+    free(_dict);
+}
+
+bool GzipInflater::begin(BodySink& out) {
+    if (!_decomp) _decomp = calloc(1, sizeof(tinfl_decompressor));
+    if (!_dict) _dict = (uint8_t*)malloc(TINFL_LZ_DICT_SIZE);
+    if (!_decomp || !_dict) {
+        _state = ST_ERROR;
+        return false;
+    }
+    tinfl_init((tinfl_decompressor*)_decomp);
+    _sink = &out;
+    _dictOfs = 0;
+    _state = ST_HEADER;
+    _need = sizeof(_hdr);
+    _crc = 0;
+    _in = 0;
+    _out = 0;
+    return true;
+}
+
+// 固定 10 位元組標頭之後依 FLG 決定還有哪些選用欄位
+void GzipInflater::nextHeaderField() {
+    if (_state == ST_HEADER && (_flags & GZ_FEXTRA)) { _state = ST_EXTRA_LEN; _need = 2; return; }
+    if (_state <= ST_EXTRA && (_flags & GZ_FNAME)) { _state = ST_NAME; return; }
+    if (_state <= ST_NAME && (_flags & GZ_FCOMMENT)) { _state = ST_COMMENT; return; }
+    if (_state <= ST_COMMENT && (_flags & GZ_FHCRC)) { _state = ST_HCRC; _need = 2; return; }
+    _state = ST_DATA;
+}
+
+size_t GzipInflater::header(const uint8_t* buf, size_t len) {
+    size_t used = 0;
+    while (used < len && _state < ST_DATA) {
+        uint8_t c = buf[used++];
+        switch (_state) {
+            case ST_HEADER:
+                _hdr[sizeof(_hdr) - _need] = c;
+                if (--_need == 0) {
+                    if (_hdr[0] != 0x1f || _hdr[1] != 0x8b || _hdr[2] != 8) {
+                        _state = ST_ERROR;
+                        return used;
+                    }
+                    _flags = _hdr[3];
+                    nextHeaderField();
+                }
+                break;
+            case ST_EXTRA_LEN:
+                // XLEN 為 little-endian，先收低位元組
+                if (_need == 2) {
+                    _hdr[0] = c;
+                    _need = 1;
+                } else {
+                    _need = _hdr[0] | (c << 8);
+                    _state = ST_EXTRA;
+                    if (_need == 0) nextHeaderField();
+                }
+                break;
+            case ST_EXTRA:
+            case ST_HCRC:
+                if (--_need == 0) nextHeaderField();
+                break;
+            case ST_NAME:
+            case ST_COMMENT:
+                if (c == 0) nextHeaderField();
+                break;
+            default:
+                break;
+        }
+    }
+    return used;
+}
+
+size_t GzipInflater::inflate(const uint8_t* buf, size_t len) {
+    tinfl_decompressor* decomp = (tinfl_decompressor*)_decomp;
+    size_t used = 0;
+    for (;;) {
+        size_t inSize = len - used;
+        size_t outSize = TINFL_LZ_DICT_SIZE - _dictOfs;
+        tinfl_status status = tinfl_decompress(decomp, buf + used, &inSize, _dict, _dict + _dictOfs, &outSize,
+                                               TINFL_FLAG_HAS_MORE_INPUT);
+        used += inSize;
+        if (outSize) {
+            // 下游拒收 (解析錯誤或寫入不完整) 就停止解壓，不再送出後面的資料
+            if (!_sink->write(_dict + _dictOfs, outSize)) {
+                _state = ST_ERROR;
+                return used;
+            }
+            _crc = crc32_le(_crc, _dict + _dictOfs, outSize);
+            _out += outSize;
+            _dictOfs = (_dictOfs + outSize) & (TINFL_LZ_DICT_SIZE - 1);
+        }
+        if (status == TINFL_STATUS_DONE) {
+            _state = ST_TRAILER;
+            _need = sizeof(_trailer);
+            return used;
+        }
+        if (status < 0) {
+            _state = ST_ERROR;
+            return used;
+        }
+        // NEEDS_MORE_INPUT：這段輸入已用完，等下一段
+        if (status != TINFL_STATUS_HAS_MORE_OUTPUT && used >= len) return used;
+    }
+}
+
+bool GzipInflater::write(const uint8_t* buf, size_t len) {
+    size_t used = 0;
+    while (used < len && _state != ST_ERROR) {
+        if (_state < ST_DATA) {
+            used += header(buf + used, len - used);
+        } else if (_state == ST_DATA) {
+            used += inflate(buf + used, len - used);
+        } else if (_state == ST_TRAILER) {
+            // CRC32 + ISIZE，皆為 little-endian
+            _trailer[sizeof(_trailer) - _need] = buf[used++];
+            if (--_need == 0) {
+                uint32_t crc = _trailer[0] | (_trailer[1] << 8) | (_trailer[2] << 16) | ((uint32_t)_trailer[3] << 24);
+                uint32_t isize = _trailer[4] | (_trailer[5] << 8) | (_trailer[6] << 16) | ((uint32_t)_trailer[7] << 24);
+                _state = crc == _crc && isize == _out ? ST_DONE : ST_ERROR;
+            }
+        } else {
+            // 完成後的多餘資料直接丟棄
+            break;
+        }
+    }
+    _in += used;
+    return _state != ST_ERROR;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "transport.h"
+
+// --- gzip (RFC 1952) 串流解壓 ---
+// 以 ROM 內建的 miniz tinfl 搭配固定 32 KB 視窗逐段解壓，解出的資料直接寫給下游 BodySink，
+// 不緩衝整份壓縮或解壓後的 body。解壓器與視窗只在第一次使用時配置，之後重複使用。
+// 結尾的 CRC32 與 ISIZE 都會核對。不依賴 Arduino：主機上以 tools/host_rom 的 zlib 替身編譯。
+
+class GzipInflater : public BodySink {
+public:
+    ~GzipInflater();
+    // 開始一份新的 gzip body，解壓結果寫到 out
+    bool begin(BodySink& out);
+    // 格式錯誤、CRC32 / 長度不符或下游拒收時回傳 false，之後不再解壓
+    bool write(const uint8_t* data, size_t len) override;
+    bool done() const { return _state == ST_DONE; }
+    bool error() const { return _state == ST_ERROR; }
+    uint32_t inputBytes() const { return _in; }
+    uint32_t outputBytes() const { return _out; }
+
+private:
+    enum State { ST_HEADER, ST_EXTRA_LEN, ST_EXTRA, ST_NAME, ST_COMMENT, ST_HCRC, ST_DATA, ST_TRAILER, ST_DONE, ST_ERROR };
+
+    size_t header(const uint8_t* buf, size_t len);
+    size_t inflate(const uint8_t* buf, size_t len);
+    void nextHeaderField();
+
+    BodySink* _sink = nullptr;
+    void* _decomp = nullptr;      // tinfl_decompressor
+    uint8_t* _dict = nullptr;     // TINFL_LZ_DICT_SIZE 循環視窗
+    size_t _dictOfs = 0;
+    State _state = ST_DONE;
+    uint8_t _hdr[10];
+    uint8_t _flags = 0;
+    uint16_t _need = 0;           // 目前欄位還需要的位元組數
+    uint8_t _trailer[8];
+    uint32_t _crc = 0;            // 解壓結果的 CRC32
+    uint32_t _in = 0;
+    uint32_t _out = 0;
+};
@@ -0,0 +1,111 @@
+#include "json_stream.h"
+
+void JsonStreamParser::reset() {
+    _len = 0;
+    _depth = 0;
+    _inString = false;
+    _escape = false;
+    _started = false;
+    _error = false;
+    for (int i = 0; i <= JSON_STREAM_MAX_DEPTH; i++) {
+        _isArray[i] = false;
+        _expectKey[i] = false;
+        _index[i] = 0;
+    }
+}
+
+bool JsonStreamParser::done() {
+    if (_depth == 0 && !_inString) flushLiteral();
+    return _started && _depth == 0 && !_inString && !_error;
+}
+
+void JsonStreamParser::append(char c) {
+    if (_len >= JSON_STREAM_TOKEN - 1) {
+        _error = true;
+        return;
+    }
+    _token[_len++] = c;
+}
+
+// 數字 / true / false / null 沒有結束符號，遇到分隔字元時才送出
+void JsonStreamParser::flushLiteral() {
+    if (_len == 0) return;
+    _token[_len] = 0;
+    _handler.onValue(_depth, _index[_depth], _token, false);
+    _len = 0;
+}
+
+void JsonStreamParser::feed(const uint8_t* data, size_t len) {
+    for (size_t i = 0; i < len && !_error; i++) {
+        char c = (char)data[i];
+        if (_inString) {
+            if (_escape) {
+                // 行情資料不會用到 \uXXXX，其餘跳脫字元保留原字元即可
+                append(c);
+                _escape = false;
+            } else if (c == '\\') {
+                _escape = true;
+            } else if (c == '"') {
+                _inString = false;
+                _token[_len] = 0;
+                if (_depth > 0 && !_isArray[_depth] && _expectKey[_depth]) {
+                    _handler.onKey(_depth, _token);
+                } else {
+                    _handler.onValue(_depth, _index[_depth], _token, true);
+                }
+                _len = 0;
+            } else {
+                append(c);
+            }
+            continue;
+        }
+        switch (c) {
+            case '[':
+            case '{':
+                if (_depth >= JSON_STREAM_MAX_DEPTH) {
+                    _error = true;
+                    break;
+                }
+                _started = true;
+                _depth++;
+                _isArray[_depth] = c == '[';
+                _expectKey[_depth] = c == '{';
+                _index[_depth] = 0;
+                _handler.onBegin(_depth, _isArray[_depth]);
+                break;
+            case ']':
+            case '}':
+                flushLiteral();
+                if (_depth == 0 || _isArray[_depth] != (c == ']')) {
+                    _error = true;
+                    break;
+                }
+                _handler.onEnd(_depth, _isArray[_depth]);
+                _depth--;
+                break;
+            case '"':
+                _started = true;
+                _inString = true;
+                _len = 0;
+                break;
+            case ':':
+                _expectKey[_depth] = false;
+                break;
+            case ',':
+                flushLiteral();
+                _index[_depth]++;
+                if (!_isArray[_depth]) _expectKey[_depth] = true;
+                break;
+            case ' ':
+            case '\t':
+            case '\r':
+            case '\n':
+                flushLiteral();
+                break;
+            default:
+                _started = true;
+                append(c);
+                break;
+        }
+    }
+}
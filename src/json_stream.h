@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// --- 串流 JSON 解析 ---
+// 逐位元組餵入，不建立 DOM，只用固定大小的 token 緩衝區，峰值記憶體與回應長度無關。
+// 核心不依賴 Arduino，可在主機上直接編譯做效能比較。
+
+#define JSON_STREAM_MAX_DEPTH 8
+#define JSON_STREAM_TOKEN 48
+
+// depth 為值所在容器的層數 (最外層容器內為 1)；index 為陣列元素序號或物件欄位序號
+class JsonStreamHandler {
+public:
+    virtual ~JsonStreamHandler() {}
+    virtual void onBegin(int depth, bool isArray) {}
+    virtual void onEnd(int depth, bool isArray) {}
+    virtual void onKey(int depth, const char* key) {}
+    virtual void onValue(int depth, int index, const char* value, bool isString) = 0;
+};
+
+class JsonStreamParser {
+public:
+    explicit JsonStreamParser(JsonStreamHandler& handler) : _handler(handler) { reset(); }
+    void reset();
+    void feed(const uint8_t* data, size_t len);
+    // token 超過緩衝區或括號不成對
+    bool error() const { return _error; }
+    // body 結束時呼叫：最外層的數字 / true / false / null 沒有結束符號，在這裡送出
+    bool done();
+
+private:
+    void flushLiteral();
+    void append(char c);
+
+    JsonStreamHandler& _handler;
+    char _token[JSON_STREAM_TOKEN];
+    uint8_t _len = 0;
+    uint8_t _depth = 0;
+    bool _isArray[JSON_STREAM_MAX_DEPTH + 1];
+    bool _expectKey[JSON_STREAM_MAX_DEPTH + 1];
+    int _index[JSON_STREAM_MAX_DEPTH + 1];
+    bool _inString = false;
+    bool _escape = false;
+    bool _started = false;
+    bool _error = false;
+};
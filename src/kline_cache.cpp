@@ -0,0 +1,58 @@
+#include "kline_cache.h"
+
+// 依週期長短設定刷新間隔；未收盤 K線之間的價格變化由 ticker 補上
+static const uint32_t maxAgeMs[INTERVAL_COUNT] = {
+    60000,     // 1m
+    120000,    // 5m
+    300000,    // 1h
+    600000,    // 4h
+    1800000,   // 1d
+};
+
+uint32_t cacheMaxAgeMs(int idx) {
+    return maxAgeMs[idx];
+}
+
+bool cacheCandleClosed(const KLineSeries& s, int idx, uint64_t serverNow) {
+    if (serverNow == 0 || s.count == 0) return false;
+    return serverNow >= s.lastOpenTime() + (uint64_t)intervalSeconds[idx] * 1000;
+}
+
+bool cacheIsStale(const KLineSeries& s, int idx, uint32_t now, uint64_t serverNow) {
+    if (s.count == 0 || s.refreshedAt == 0) return true;
+    if (cacheCandleClosed(s, idx, serverNow)) return true;
+    return now - s.refreshedAt > cacheMaxAgeMs(idx);
+}
+
+CacheLookup cacheLookup(const KLineSeries& s, int idx, uint32_t now, CacheStats& stats) {
+    if (s.count == 0) {
+        stats.misses++;
+        return CACHE_MISS;
+    }
+    if (cacheIsStale(s, idx, now)) {
+        stats.staleHits++;
+        return CACHE_STALE;
+    }
+    stats.hits++;
+    return CACHE_HIT;
+}
+
+int cachePickStale(const KLineSeries* series, int viewIdx, uint32_t now, uint64_t serverNow) {
+    if (cacheIsStale(series[viewIdx], viewIdx, now, serverNow)) return viewIdx;
+    int pick = -1;
+    uint32_t oldest = 0;
+    for (int i = 0; i < INTERVAL_COUNT; i++) {
+        if (i == viewIdx || !cacheIsStale(series[i], i, now, serverNow)) continue;
+        uint32_t age = series[i].refreshedAt ? now - series[i].refreshedAt : UINT32_MAX;
+        if (pick < 0 || age > oldest) {
+            pick = i;
+            oldest = age;
+        }
+    }
+    return pick;
+}
+
+void printCacheStats(Print& out, const char* tag, const CacheStats& stats) {
+    out.printf("[%s] hit=%u stale=%u miss=%u prefetch=%u\n",
+               tag, stats.hits, stats.staleHits, stats.misses, stats.prefetches);
+}
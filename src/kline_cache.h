@@ -0,0 +1,24 @@
+#pragma once
+
+#include <Arduino.h>
+#include "kline_store.h"
+
+// --- 五個週期的 K線快取策略：每個週期有自己的最大資料年齡 ---
+
+struct CacheStats {
+    uint32_t hits;        // 點選時快取夠新，直接顯示
+    uint32_t staleHits;   // 有快取但過期：先顯示，再背景刷新
+    uint32_t misses;      // 沒有快取，只能等網路
+    uint32_t prefetches;  // 背景預抓次數
+};
+
+enum CacheLookup { CACHE_HIT, CACHE_STALE, CACHE_MISS };
+
+uint32_t cacheMaxAgeMs(int idx);
+// 跨過 K線邊界 (最後一根已收盤) 也算過期；serverNow 為 0 表示尚不知道交易所時間
+bool cacheCandleClosed(const KLineSeries& s, int idx, uint64_t serverNow);
+bool cacheIsStale(const KLineSeries& s, int idx, uint32_t now, uint64_t serverNow = 0);
+CacheLookup cacheLookup(const KLineSeries& s, int idx, uint32_t now, CacheStats& stats);
+// 挑出下一個要預抓的週期：優先目前顯示的週期，其次最舊的；都夠新回傳 -1
+int cachePickStale(const KLineSeries* series, int viewIdx, uint32_t now, uint64_t serverNow = 0);
+void printCacheStats(Print& out, const char* tag, const CacheStats& stats);
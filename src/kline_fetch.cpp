@@ -0,0 +1,10 @@
+#include "kline_fetch.h"
+
+bool KLineFetch::path(char* buf, size_t len, int intervalIdx) {
+    return _adapter.klinePath(buf, len, intervalIdx, _series, _incremental);
+}
+
+bool KLineFetch::write(const uint8_t* data, size_t len) {
+    _parser.feed(data, len);
+    return !_parser.error();
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "transport.h"
+#include "json_stream.h"
+#include "kline_parser.h"
+#include "exchange.h"
+
+// 一次 K線請求：由交易所轉接器組出路徑，body 以 BodySink 串流解析並逐列合併進序列。
+// 不依賴 Arduino，裝置與主機共用同一套流程。
+class KLineFetch : public BodySink {
+public:
+    explicit KLineFetch(KLineSeries& series, const ExchangeAdapter& adapter = *exchanges[EXCHANGE_BINANCE])
+        : _series(series), _adapter(adapter), _handler(series, adapter.klineLayout()), _parser(_handler) {}
+    // 交易所支援增量時，已有完整 KLINE_COUNT 根只從最後一根往後抓；沒有這個週期回傳 false
+    bool path(char* buf, size_t len, int intervalIdx);
+    bool write(const uint8_t* data, size_t len) override;
+    bool parsed() { return _parser.done(); }
+    int rows() const { return _handler.rows(); }
+    // 增量請求回到交易所的列數上限代表中間斷太久，呼叫端應清空序列改抓完整的最新一頁
+    bool gap() const { return _incremental && _handler.rows() >= _adapter.incrementalLimit(); }
+
+private:
+    KLineSeries& _series;
+    const ExchangeAdapter& _adapter;
+    KLineJsonHandler _handler;
+    JsonStreamParser _parser;
+    bool _incremental = false;
+};
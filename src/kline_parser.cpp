@@ -0,0 +1,35 @@
+#include "kline_parser.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+const KLineLayout BINANCE_KLINE_LAYOUT = {2, 0, 1, 2, 3, 4, 1, false};
+
+void KLineJsonHandler::onBegin(int depth, bool isArray) {
+    if (depth == _layout.rowDepth) {
+        memset(&_k, 0, sizeof(_k));
+        _fields = 0;
+    }
+}
+
+// 數字欄位可能是字串 ("64000.1") 也可能是數字 (Coinbase)，strtof 兩者皆可
+void KLineJsonHandler::onValue(int depth, int index, const char* value, bool isString) {
+    if (depth != _layout.rowDepth) return;
+    if (index == _layout.time) _k.openTime = strtoull(value, nullptr, 10) * _layout.timeScale;
+    else if (index == _layout.open) _k.open = strtof(value, nullptr);
+    else if (index == _layout.high) _k.high = strtof(value, nullptr);
+    else if (index == _layout.low) _k.low = strtof(value, nullptr);
+    else if (index == _layout.close) _k.close = strtof(value, nullptr);
+    else return;
+    _fields++;
+}
+
+void KLineJsonHandler::onEnd(int depth, bool isArray) {
+    if (depth == _layout.rowDepth && _fields == 5) {
+        _rows++;
+        if (!_layout.descending) _series.merge(_k);
+        else if (_pendingCount < KLINE_COUNT) _pending[_pendingCount++] = _k;
+    } else if (depth == _layout.rowDepth - 1 && isArray && _pendingCount) {
+        while (_pendingCount) _series.merge(_pending[--_pendingCount]);
+    }
+}
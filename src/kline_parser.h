@@ -0,0 +1,36 @@
+#pragma once
+
+#include "json_stream.h"
+#include "kline_store.h"
+
+// 各交易所 K線回應的欄位對應：每列是一個陣列，rowDepth 為列內欄位所在的層數
+struct KLineLayout {
+    uint8_t rowDepth;
+    uint8_t time, open, high, low, close;   // 欄位在列中的序號
+    uint16_t timeScale;                     // 開盤時間換算成 ms 的倍數 (以秒為單位時為 1000)
+    bool descending;                        // 最新的一列在前
+};
+
+// Binance /api/v3/klines：[[openTime,"open","high","low","close",...], ...]
+extern const KLineLayout BINANCE_KLINE_LAYOUT;
+
+// 依 layout 取出每列的欄位並合併進序列，不保留整份回應。
+// 由舊到新的回應每解析完一列就合併；由新到舊的只暫存最新的 KLINE_COUNT 列，整個陣列結束後反向合併
+class KLineJsonHandler : public JsonStreamHandler {
+public:
+    explicit KLineJsonHandler(KLineSeries& series, const KLineLayout& layout = BINANCE_KLINE_LAYOUT)
+        : _series(series), _layout(layout) {}
+    void onBegin(int depth, bool isArray) override;
+    void onEnd(int depth, bool isArray) override;
+    void onValue(int depth, int index, const char* value, bool isString) override;
+    int rows() const { return _rows; }
+
+private:
+    KLineSeries& _series;
+    const KLineLayout& _layout;
+    KLine _k;
+    int _fields = 0;
+    int _rows = 0;
+    KLine _pending[KLINE_COUNT];
+    int _pendingCount = 0;
+};
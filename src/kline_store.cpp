@@ -0,0 +1,42 @@
+#include "kline_store.h"
+
+const char* intervals[INTERVAL_COUNT] = {"1m", "5m", "1h", "4h", "1d"};
+const uint32_t intervalSeconds[INTERVAL_COUNT] = {60, 300, 3600, 14400, 86400};
+
+void KLineSeries::clear() {
+    memset(items, 0, sizeof(items));
+    count = 0;
+    refreshedAt = 0;
+}
+
+// 合併一根 K線：同開盤時間則覆蓋，較新則附加 (滿了就捨棄最舊的)
+bool KLineSeries::merge(const KLine& k) {
+    if (count == 0 || k.openTime > items[count - 1].openTime) {
+        if (count == KLINE_COUNT) {
+            memmove(&items[0], &items[1], sizeof(KLine) * (KLINE_COUNT - 1));
+            count--;
+        }
+        items[count++] = k;
+        return true;
+    }
+    for (int i = count - 1; i >= 0; i--) {
+        if (items[i].openTime == k.openTime) {
+            if (memcmp(&items[i], &k, sizeof(KLine)) == 0) return false;
+            items[i] = k;
+            return true;
+        }
+        if (items[i].openTime < k.openTime) break;
+    }
+    return false;
+}
+
+// 以最新成交價更新尚未收盤的最後一根 (close / high / low)
+bool KLineSeries::applyPrice(float price) {
+    if (count == 0 || price <= 0) return false;
+    KLine& k = items[count - 1];
+    if (k.close == price) return false;
+    k.close = price;
+    if (price > k.high) k.high = price;
+    if (price < k.low) k.low = price;
+    return true;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+// --- 週期設定 ---
+#define INTERVAL_COUNT 5
+extern const char* intervals[INTERVAL_COUNT];
+extern const uint32_t intervalSeconds[INTERVAL_COUNT];
+
+// --- K線資料結構 ---
+#define KLINE_COUNT 30
+
+struct KLine {
+    uint64_t openTime;   // Binance 開盤時間 (ms)
+    float open;
+    float high;
+    float low;
+    float close;
+};
+
+// 依開盤時間排序的 K線序列，items[0] 最舊、items[count-1] 最新
+struct KLineSeries {
+    KLine items[KLINE_COUNT];
+    int count;
+    uint32_t refreshedAt;   // 最後一次由 REST 或串流更新的 millis()，0 表示從未更新
+
+    void clear();
+    bool full() const { return count >= KLINE_COUNT; }
+    const KLine* last() const { return count > 0 ? &items[count - 1] : nullptr; }
+    uint64_t lastOpenTime() const { return count > 0 ? items[count - 1].openTime : 0; }
+    bool merge(const KLine& k);
+    bool applyPrice(float price);
+};
+
+// 某一週期序列的完整快照，由網路 task 經 SpscRing 發布、UI task 取用
+#define SNAPSHOT_SLOTS 8
+struct KLineSnapshot {
+    uint8_t intervalIdx;
+    float price;
+    KLineSeries series;
+};
@@ -0,0 +1,105 @@
+#include "kline_stream.h"
+#include <ArduinoJson.h>
+#include "tls_session.h"
+#include "tls_ca.h"
+
+void KLineStream::begin(const char* symbol, const char* const* intervals, int count, KLineHandler handler) {
+    _handler = handler;
+    // 串流名稱須為小寫：btcusdt@kline_1h
+    size_t i = 0;
+    for (; symbol[i] && i < sizeof(_symbol) - 1; i++) _symbol[i] = tolower(symbol[i]);
+    _symbol[i] = 0;
+    _intervals = intervals;
+    _intervalCount = count;
+
+    _ws.onEvent([this](WStype_t type, uint8_t* payload, size_t length) { onEvent(type, payload, length); });
+    _ws.setReconnectInterval(5000);
+    // 每 15 秒送 ping，3 秒內沒收到 pong 累計 2 次就斷線重連
+    _ws.enableHeartbeat(15000, 3000, 2);
+#if KLINE_WS_TLS && TLS_VERIFY
+    _ws.beginSslWithCA(KLINE_WS_HOST, KLINE_WS_PORT, "/ws", BINANCE_CA_BUNDLE);
+#elif KLINE_WS_TLS
+    _ws.beginSSL(KLINE_WS_HOST, KLINE_WS_PORT, "/ws");
+#else
+    _ws.begin(KLINE_WS_HOST, KLINE_WS_PORT, "/ws");
+#endif
+}
+
+void KLineStream::loop() {
+    _ws.loop();
+}
+
+bool KLineStream::takeResync() {
+    bool r = _resync;
+    _resync = false;
+    return r;
+}
+
+void KLineStream::replay(const uint8_t* payload, size_t length, KLineHandler handler) {
+    _handler = handler;
+    handleText(payload, length);
+}
+
+// {"method":"SUBSCRIBE","params":["btcusdt@kline_1m","btcusdt@kline_5m",...],"id":1}
+void KLineStream::subscribe() {
+    String msg = "{\"method\":\"SUBSCRIBE\",\"params\":[";
+    for (int i = 0; i < _intervalCount; i++) {
+        if (i) msg += ',';
+        msg += '"';
+        msg += _symbol;
+        msg += "@kline_";
+        msg += _intervals[i];
+        msg += '"';
+    }
+    msg += "],\"id\":";
+    msg += ++_msgId;
+    msg += '}';
+    _ws.sendTXT(msg);
+}
+
+void KLineStream::onEvent(WStype_t type, uint8_t* payload, size_t length) {
+    switch (type) {
+        case WStype_CONNECTED:
+            _stats.connects++;
+            // 每次 (重新) 連線都要重新訂閱
+            subscribe();
+            _resync = true;
+            Serial.printf("[ws] connected, subscribed %d intervals of %s\n", _intervalCount, _symbol);
+            break;
+        case WStype_DISCONNECTED:
+            _stats.disconnects++;
+            Serial.println("[ws] disconnected");
+            break;
+        case WStype_TEXT:
+            if (_capture) _capture->write(PAYLOAD_STREAM, KLINE_WS_HOST, "/ws", payload, length, millis());
+            handleText(payload, length);
+            break;
+        default:
+            break;
+    }
+}
+
+// {"e":"kline","E":...,"s":"BTCUSDT","k":{"t":...,"i":"1h","o":"...","c":"...","h":"...","l":"...","x":false,...}}
+void KLineStream::handleText(const uint8_t* payload, size_t length) {
+    JsonDocument filter;
+    JsonObject f = filter["k"].to<JsonObject>();
+    f["t"] = true; f["i"] = true; f["o"] = true; f["h"] = true;
+    f["l"] = true; f["c"] = true; f["x"] = true;
+
+    JsonDocument doc;
+    if (deserializeJson(doc, payload, length, DeserializationOption::Filter(filter))) {
+        _stats.parseErrors++;
+        return;
+    }
+    JsonObject k = doc["k"];
+    if (k.isNull()) return;  // 訂閱回應 {"result":null,"id":1}
+
+    KLine kl;
+    kl.openTime = k["t"].as<uint64_t>();
+    kl.open = k["o"].as<float>();
+    kl.high = k["h"].as<float>();
+    kl.low = k["l"].as<float>();
+    kl.close = k["c"].as<float>();
+    _stats.events++;
+    if (_handler) _handler(k["i"] | "", kl, k["x"] | false);
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <Arduino.h>
+#include <WebSocketsClient.h>
+#include "kline_store.h"
+#include "payload_log.h"
+
+// --- Binance WebSocket K線串流 (可用 build_flags 指向本地 WebSocket 測試伺服器) ---
+#ifndef KLINE_WS_HOST
+#define KLINE_WS_HOST "stream.binance.com"
+#endif
+#ifndef KLINE_WS_PORT
+#define KLINE_WS_PORT 9443
+#endif
+#ifndef KLINE_WS_TLS
+#define KLINE_WS_TLS 1
+#endif
+
+// interval 為事件所屬週期 ("1m"...)，closed 表示該根 K線已收盤
+typedef void (*KLineHandler)(const char* interval, const KLine& k, bool closed);
+
+struct StreamStats {
+    uint32_t events;
+    uint32_t connects;
+    uint32_t disconnects;
+    uint32_t parseErrors;
+};
+
+class KLineStream {
+public:
+    // 一次訂閱所有週期，事件依 k.i 分派
+    void begin(const char* symbol, const char* const* intervals, int count, KLineHandler handler);
+    void loop();
+    bool connected() { return _ws.isConnected(); }
+    // 重新連上後回傳 true 一次，呼叫端應以 REST 補齊斷線期間的 K線
+    bool takeResync();
+    const StreamStats& stats() const { return _stats; }
+    // 記錄模式：收到的文字訊息寫進 writer；nullptr 關閉
+    void setCapture(PayloadWriter* writer) { _capture = writer; }
+    // 回放：記錄的訊息當成剛收到的一樣解析並分派 (不需要連線)
+    void replay(const uint8_t* payload, size_t length, KLineHandler handler);
+
+private:
+    void onEvent(WStype_t type, uint8_t* payload, size_t length);
+    void subscribe();
+    void handleText(const uint8_t* payload, size_t length);
+
+    WebSocketsClient _ws;
+    KLineHandler _handler = nullptr;
+    char _symbol[16];
+    const char* const* _intervals = nullptr;
+    int _intervalCount = 0;
+    uint32_t _msgId = 0;
+    bool _resync = false;
+    StreamStats _stats = {};
+    PayloadWriter* _capture = nullptr;
+};
@@ -0,0 +1,97 @@
+#include "lan_relay.h"
+
+#include <WiFi.h>
+
+LanRelay lanRelay;
+
+static const IPAddress group(RELAY_GROUP);
+
+void LanRelay::begin(int role, KLineSeries* series) {
+    _role = role;
+    _series = series;
+    if (role == RELAY_SOURCE) _sender.begin(esp_random());
+    if (role == RELAY_FOLLOWER) _receiver.begin(series, INTERVAL_COUNT);
+}
+
+// WiFi 重連後 multicast 成員資格會消失，斷線時關掉 socket，連上後重開
+bool LanRelay::ensureSocket() {
+    bool up = WiFi.status() == WL_CONNECTED;
+    if (_open && !up) {
+        _udp.stop();
+        _open = false;
+    } else if (!_open && up) {
+        // relay 只需要收 NACK (單播)；follower 加入群組
+        _open = _role == RELAY_SOURCE ? _udp.begin(RELAY_PORT) : _udp.beginMulticast(group, RELAY_PORT);
+    }
+    return _open;
+}
+
+void LanRelay::send(size_t len, IPAddress ip, uint16_t port) {
+    if (!len || !_udp.beginPacket(ip, port)) return;
+    _udp.write(_buf, len);
+    _udp.endPacket();
+}
+
+void LanRelay::publish(int idx, float price) {
+    if (_role != RELAY_SOURCE || !ensureSocket()) return;
+    send(_sender.encodeUpdate(_buf, sizeof(_buf), idx, _series[idx], price), group, RELAY_PORT);
+}
+
+uint32_t LanRelay::loop(float price) {
+    if (_role == RELAY_OFF || !ensureSocket()) return 0;
+    uint32_t now = millis();
+    uint32_t updated = 0;
+    if (_role == RELAY_SOURCE) {
+        if (now - _lastBeat >= RELAY_HEARTBEAT_MS) {
+            _lastBeat = now;
+            send(_sender.encodePrice(_buf, sizeof(_buf), price), group, RELAY_PORT);
+        }
+        if (now - _lastFull >= RELAY_FULL_MS) {
+            _lastFull = now;
+            send(_sender.encodeSeries(_buf, sizeof(_buf), _fullNext, _series[_fullNext], price), group, RELAY_PORT);
+            _fullNext = (_fullNext + 1) % INTERVAL_COUNT;
+        }
+        // 重送也走 multicast：多台漏掉同一個 frame 時一次補齊
+        while (int len = _udp.parsePacket()) {
+            uint8_t nack[32];
+            int n = _udp.read(nack, sizeof(nack));
+            if (n <= 0 || len > (int)sizeof(nack)) continue;
+            uint32_t seqs[RELAY_NACK_MAX];
+            bool all;
+            int count = _sender.onNack(nack, n, now, seqs, RELAY_NACK_MAX, all);
+            for (int i = 0; i < count; i++) {
+                send(_sender.encodeRepair(_buf, sizeof(_buf), seqs[i], _series, price), group, RELAY_PORT);
+            }
+            if (all && now - _lastAll >= RELAY_FULL_HOLDOFF_MS) {
+                _lastAll = now;
+                for (int i = 0; i < INTERVAL_COUNT; i++) {
+                    send(_sender.encodeSeries(_buf, sizeof(_buf), i, _series[i], price), group, RELAY_PORT);
+                }
+            }
+        }
+        return 0;
+    }
+    while (_udp.parsePacket()) {
+        int n = _udp.read(_buf, sizeof(_buf));
+        if (n <= 0) continue;
+        _relayIp = _udp.remoteIP();
+        _relayPort = _udp.remotePort();
+        _lastFrame = now;
+        updated |= _receiver.onFrame(_buf, n);
+    }
+    // NACK 直接單播給 relay；加抖動避免多台同時送
+    if (_relayPort && (int32_t)(now - _nextNack) >= 0) {
+        _nextNack = now + RELAY_NACK_MS + esp_random() % 100;
+        send(_receiver.encodeNack(_buf, sizeof(_buf)), _relayIp, _relayPort);
+    }
+    return updated;
+}
+
+// [relay] 送出 / 收到的 frame 與位元組、缺號 / 補回 / 遺失、NACK 與重送次數
+void LanRelay::printStats(Print& out) const {
+    const RelayStats& st = _role == RELAY_SOURCE ? _sender.stats() : _receiver.stats();
+    out.printf("[relay] role=%s frames=%u bytes=%u missing=%u repaired=%u lost=%u stale=%u nacks=%u repairs=%u epochs=%u%s\n",
+               _role == RELAY_SOURCE ? "relay" : "follower", st.frames, st.bytes, st.missing, st.repaired, st.lost,
+               st.stale, st.nacks, st.repairs, st.epochs,
+               _role == RELAY_FOLLOWER && !relayAlive() ? " (relay offline)" : "");
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <Arduino.h>
+#include <WiFiUdp.h>
+#include "relay_proto.h"
+
+// --- 區網轉發：同一個辦公室只讓一台 (relay) 連交易所，其他台 (follower) 從 UDP multicast 接收 ---
+// follower 不建立任何 TLS 連線，也不佔用 IP 的請求權重；缺號以 NACK 向 relay 要求重送。
+#define RELAY_OFF 0
+#define RELAY_SOURCE 1
+#define RELAY_FOLLOWER 2
+#ifndef RELAY_ROLE
+#define RELAY_ROLE RELAY_OFF
+#endif
+#ifndef RELAY_GROUP
+#define RELAY_GROUP 239, 255, 42, 99
+#endif
+#ifndef RELAY_PORT
+#define RELAY_PORT 42424
+#endif
+#define RELAY_HEARTBEAT_MS 1000    // relay：沒有更新時也每秒送一次價格，讓 follower 發現結尾的缺號
+#define RELAY_FULL_MS 5000         // relay：輪流送一個週期的完整序列
+#define RELAY_FULL_HOLDOFF_MS 1000 // relay：全部重送最多每秒一次
+#define RELAY_NACK_MS 150          // follower：NACK 間隔 (另加 0~100 ms 抖動)
+#define RELAY_TIMEOUT_MS 10000     // follower：超過這麼久沒收到任何 frame 視為 relay 離線
+
+class LanRelay {
+public:
+    void begin(int role, KLineSeries* series);
+    int role() const { return _role; }
+    // relay：某週期的序列發布後呼叫，依變動送單根或整組
+    void publish(int idx, float price);
+    // relay：心跳、輪流送完整序列、處理 NACK；follower：收 frame 並送 NACK。
+    // 回傳 follower 這一輪有更新的週期位元 (價格為 RELAY_PRICE_BIT)
+    uint32_t loop(float price);
+    float price() const { return _receiver.price(); }
+    bool relayAlive() const { return _lastFrame && millis() - _lastFrame < RELAY_TIMEOUT_MS; }
+    void printStats(Print& out) const;
+
+private:
+    bool ensureSocket();
+    void send(size_t len, IPAddress ip, uint16_t port);
+
+    int _role = RELAY_OFF;
+    KLineSeries* _series = nullptr;
+    WiFiUDP _udp;
+    bool _open = false;
+    RelaySender _sender;
+    RelayReceiver _receiver;
+    uint8_t _buf[RELAY_MAX_FRAME];
+    uint32_t _lastBeat = 0;
+    uint32_t _lastFull = 0;
+    uint32_t _lastAll = 0;
+    uint32_t _nextNack = 0;
+    uint32_t _lastFrame = 0;
+    int _fullNext = 0;
+    IPAddress _relayIp;
+    uint16_t _relayPort = 0;
+};
+
+extern LanRelay lanRelay;
@@ -1,11 +1,14 @@
 #include <Arduino.h>
 #include <TFT_eSPI.h>
 #include <WiFi.h>
-#include <HTTPClient.h>
-#include <WiFiClientSecure.h>
-#include <ArduinoJson.h>
 #include <XPT2046_Touchscreen.h>
 #include <SPI.h>
+#include "kline_store.h"
+#include "kline_cache.h"
+#include "net_task.h"
+#include "wifi_manager.h"
+#include "power_manager.h"
+#include "capture.h"
 
 // --- WiFi 設定 ---
 const char* ssid = "jwc";
@@ -23,21 +26,18 @@ XPT2046_Touchscreen touch(XPT2046_CS, XPT2046_IRQ);
 
 TFT_eSPI tft = TFT_eSPI();
 
-// --- K線資料結構與變數 ---
-struct KLine {
-    float open;
-    float high;
-    float low;
-    float close;
-};
-
-KLine klines[30];
-float currentPrice = 0;
-
 // --- 週期設定 ---
-const char* intervals[] = {"1m", "5m", "1h", "4h", "1d"};
 int currentIntervalIdx = 2; // 預設 1h
 
+// --- K線資料：UI 端的五個週期副本，由網路 task 的快照更新 ---
+KLineSeries series[INTERVAL_COUNT];
+float currentPrice = 0;
+bool chartDirty = false;
+unsigned long switchStart = 0;  // 等待網路資料時的觸控時間點
+CacheStats cacheStats;
+Watchlist watch = {};          // 自選清單，由網路 task 整批更新
+int watchIdx = 0;              // 右上角輪播中的交易對
+
 struct Button {
     int x, y, w, h;
     const char* label;
@@ -58,56 +58,8 @@ void initButtons() {
     }
 }
 
-void connectWiFi() {
-    tft.fillScreen(TFT_BLACK);
-    tft.setTextColor(TFT_WHITE);
-    tft.setTextDatum(MC_DATUM);
-    tft.drawString("WiFi Connecting...", tft.width()/2, tft.height()/2, 2);
-    WiFi.begin(ssid, password);
-    int counter = 0;
-    while (WiFi.status() != WL_CONNECTED && counter < 60) {
-        delay(500);
-        counter++;
-    }
-    if (WiFi.status() == WL_CONNECTED) {
-        tft.fillScreen(TFT_BLACK);
-        tft.setTextColor(TFT_GREEN);
-        tft.drawString("Connected!", tft.width()/2, tft.height()/2, 2);
-    } else {
-        tft.fillScreen(TFT_BLACK);
-        tft.setTextColor(TFT_RED);
-        tft.drawString("WiFi Failed!", tft.width()/2, tft.height()/2, 2);
-    }
-    delay(1000);
-}
-
-void fetchKLineData() {
-    if (WiFi.status() == WL_CONNECTED) {
-        WiFiClientSecure client;
-        client.setInsecure();
-        HTTPClient http;
-        String url = "https://api.binance.com/api/v3/klines?symbol=BTCUSDT&interval=" + String(intervals[currentIntervalIdx]) + "&limit=30";
-        if (http.begin(client, url)) {
-            int httpCode = http.GET();
-            if (httpCode == HTTP_CODE_OK) {
-                String payload = http.getString();
-                JsonDocument doc;
-                deserializeJson(doc, payload);
-                JsonArray arr = doc.as<JsonArray>();
-                for (int i = 0; i < arr.size() && i < 30; i++) {
-                    klines[i].open = arr[i][1].as<float>();
-                    klines[i].high = arr[i][2].as<float>();
-                    klines[i].low = arr[i][3].as<float>();
-                    klines[i].close = arr[i][4].as<float>();
-                }
-                currentPrice = klines[29].close;
-            }
-            http.end();
-        }
-    }
-}
-
 void drawKLines() {
+    const KLineSeries& klines = series[currentIntervalIdx];
     int screenW = tft.width();
     int screenH = tft.height();
     int chartX = 15;
@@ -116,15 +68,11 @@ void drawKLines() {
     int barWidth = (screenW - 50) / 30;
     int spacing = 1;
     float maxH = -1, minL = 1000000;
-    bool hasData = false;
-    for (int i = 0; i < 30; i++) {
-        if (klines[i].close > 0) {
-            if (klines[i].high > maxH) maxH = klines[i].high;
-            if (klines[i].low < minL) minL = klines[i].low;
-            hasData = true;
-        }
+    if (klines.count == 0) return;
+    for (int i = 0; i < klines.count; i++) {
+        if (klines.items[i].high > maxH) maxH = klines.items[i].high;
+        if (klines.items[i].low < minL) minL = klines.items[i].low;
     }
-    if (!hasData) return;
     float range = maxH - minL;
     if (range == 0) range = 1;
     maxH += range * 0.1; minL -= range * 0.1; range = maxH - minL;
@@ -133,14 +81,14 @@ void drawKLines() {
     tft.fillRect(0, 90, screenW, 120, TFT_BLACK);
     tft.drawRect(chartX - 5, chartY - chartHeight - 5, screenW - 40, chartHeight + 10, TFT_DARKGREY);
     
-    for (int i = 0; i < 30; i++) {
-        if (klines[i].close == 0) continue;
+    for (int i = 0; i < klines.count; i++) {
+        const KLine& k = klines.items[i];
         int x = chartX + i * (barWidth + spacing);
-        int yOpen = chartY - (int)((klines[i].open - minL) / range * chartHeight);
-        int yClose = chartY - (int)((klines[i].close - minL) / range * chartHeight);
-        int yHigh = chartY - (int)((klines[i].high - minL) / range * chartHeight);
-        int yLow = chartY - (int)((klines[i].low - minL) / range * chartHeight);
-        uint32_t color = (klines[i].close >= klines[i].open) ? TFT_GREEN : 0xF800;
+        int yOpen = chartY - (int)((k.open - minL) / range * chartHeight);
+        int yClose = chartY - (int)((k.close - minL) / range * chartHeight);
+        int yHigh = chartY - (int)((k.high - minL) / range * chartHeight);
+        int yLow = chartY - (int)((k.low - minL) / range * chartHeight);
+        uint32_t color = (k.close >= k.open) ? TFT_GREEN : 0xF800;
         tft.drawLine(x + barWidth/2, yHigh, x + barWidth/2, yLow, color);
         int bodyH = abs(yOpen - yClose); if (bodyH == 0) bodyH = 1;
         tft.fillRect(x, min(yOpen, yClose), barWidth, bodyH, color);
@@ -150,6 +98,24 @@ void drawKLines() {
     tft.drawFloat(minL, 1, screenW - 5, chartY, 1);
 }
 
+// 右上角輪播自選清單：symbol 省略 USDT，漲跌幅以 24h 開盤價計算
+void drawWatchlist() {
+    int w = tft.width();
+    tft.fillRect(w / 2, 0, w / 2, 28, TFT_BLACK);
+    if (!watch.count) return;
+    const TickerRecord& r = watch.items[watchIdx % watch.count];
+    if (!r.closeTime) return;
+    char name[WATCHLIST_SYMBOL];
+    strcpy(name, r.symbol);
+    size_t n = strlen(name);
+    if (n > 4 && strcmp(name + n - 4, "USDT") == 0) name[n - 4] = 0;
+    char line[40];
+    snprintf(line, sizeof(line), "%s %.*f %+.1f%%", name, r.last < 10 ? 4 : 1, r.last, r.changePct());
+    tft.setTextDatum(TR_DATUM);
+    tft.setTextColor(r.changePct() >= 0 ? TFT_GREEN : TFT_RED);
+    tft.drawString(line, w - 5, 10, 2);
+}
+
 void drawButtons() {
     tft.setTextDatum(MC_DATUM);
     for (int i = 0; i < 5; i++) {
@@ -173,6 +139,7 @@ void drawUI(bool fullRedraw = true) {
         
         tft.drawFastHLine(0, 85, w, TFT_DARKGREY);
         drawButtons();
+        drawWatchlist();
     }
 
     // 價格區域
@@ -184,9 +151,14 @@ void drawUI(bool fullRedraw = true) {
     drawKLines();
     
     // 狀態
-    tft.fillRect(0, h-15, 120, 15, TFT_BLACK);
-    tft.setTextDatum(BL_DATUM); tft.setTextColor(TFT_DARKGREY);
-    tft.drawString("Upd: " + String(millis()/1000) + "s", 5, h - 2, 1);
+    tft.fillRect(0, h-15, 160, 15, TFT_BLACK);
+#if REPLAY_MODE
+    tft.setTextDatum(BL_DATUM); tft.setTextColor(TFT_ORANGE);
+    tft.drawString("Upd: " + String(millis()/1000) + "s  REPLAY", 5, h - 2, 1);
+#else
+    tft.setTextDatum(BL_DATUM); tft.setTextColor(wifiManager.connected() ? TFT_DARKGREY : TFT_RED);
+    tft.drawString("Upd: " + String(millis()/1000) + "s  WiFi: " + wifiManager.stateName(), 5, h - 2, 1);
+#endif
 }
 
 void handleTouch() {
@@ -209,16 +181,30 @@ void handleTouch() {
             if (tx >= buttons[i].x && tx <= buttons[i].x + buttons[i].w &&
                 ty >= buttons[i].y && ty <= buttons[i].y + buttons[i].h) {
                 if (currentIntervalIdx != i) {
+                    unsigned long t0 = millis();
                     currentIntervalIdx = i;
                     lastTouchTime = millis();
-                    
-                    tft.fillRect(0, 0, screenW, 85, TFT_BLACK);
-                    tft.setTextColor(TFT_WHITE); tft.setTextDatum(MC_DATUM);
-                    tft.drawString("Loading...", screenW/2, 45, 2);
+                    setViewInterval(i);
+
+                    // 只重畫標題與按鈕，避開整頁 fillScreen；尚無資料時交給網路 task 抓
+                    tft.fillRect(0, 0, screenW, 28, TFT_BLACK);
+                    tft.setTextColor(TFT_WHITE); tft.setTextDatum(TL_DATUM);
+                    tft.drawString("BTC/USDT (" + String(intervals[i]) + ")", 10, 10, 2);
                     drawButtons();
-                    
-                    fetchKLineData();
-                    drawUI(true);
+                    drawWatchlist();
+                    CacheLookup r = cacheLookup(series[i], i, millis(), cacheStats);
+                    if (r == CACHE_MISS) {
+                        tft.fillRect(0, 90, screenW, 120, TFT_BLACK);
+                        tft.setTextColor(TFT_WHITE); tft.setTextDatum(MC_DATUM);
+                        tft.drawString("Loading...", screenW/2, 150, 2);
+                        switchStart = t0;
+                    } else {
+                        drawUI(false);
+                    }
+                    // 過期或沒有快取才需要刷新，新鮮的快取不發請求
+                    if (r != CACHE_HIT) requestFetch(i);
+                    Serial.printf("[ui] touch->render %s %lums (net busy=%d)\n", intervals[i], millis() - t0, networkBusy());
+                    printCacheStats(Serial, "cache", cacheStats);
                 }
                 return;
             }
@@ -239,17 +225,59 @@ void setup() {
     touch.setRotation(1);
     
     initButtons();
-    connectWiFi();
-    fetchKLineData();
+    for (int i = 0; i < INTERVAL_COUNT; i++) series[i].clear();
+    // 連線在背景進行，畫面先出來；狀態顯示在左下角。回放模式不連線，資料全部來自記錄檔
+#if !REPLAY_MODE
+    wifiManager.begin(ssid, password);
+#endif
+    powerManager.begin(POWER_MODE);
+    setViewInterval(currentIntervalIdx);
+    startNetworkTask();
     drawUI(true);
 }
 
+// 取出網路 task 發布的所有快照，更新 UI 端副本
+void applySnapshots() {
+    static KLineSnapshot snap;
+    while (takeSnapshot(snap)) {
+        series[snap.intervalIdx] = snap.series;
+        if (snap.price != currentPrice) {
+            currentPrice = snap.price;
+            chartDirty = true;
+        }
+        if (snap.intervalIdx == currentIntervalIdx) {
+            chartDirty = true;
+            if (switchStart) {
+                Serial.printf("[ui] %s loaded in %lums\n", intervals[snap.intervalIdx], millis() - switchStart);
+                switchStart = 0;
+            }
+        }
+    }
+}
+
 void loop() {
+    static WifiState lastWifi = WIFI_IDLE;
+    wifiManager.loop();
+    if (wifiManager.state() != lastWifi) {
+        lastWifi = wifiManager.state();
+        chartDirty = true;
+    }
     handleTouch();
-    static unsigned long lastUpdate = 0;
-    if (millis() - lastUpdate > 60000) {
-        fetchKLineData();
-        drawUI();
-        lastUpdate = millis();
+    applySnapshots();
+    // 自選清單每 3 秒換一個交易對，新資料到時立即重畫目前這個
+    static unsigned long lastWatch = 0;
+    bool watchUpdated = takeWatchlist(watch);
+    if (watchUpdated || (watch.count > 1 && millis() - lastWatch > 3000)) {
+        if (!watchUpdated) watchIdx = (watchIdx + 1) % watch.count;
+        drawWatchlist();
+        lastWatch = millis();
+    }
+    // 推送頻繁，畫面最多每秒重繪一次
+    static unsigned long lastDraw = 0;
+    if (chartDirty && millis() - lastDraw > 1000) {
+        drawUI(false);
+        chartDirty = false;
+        lastDraw = millis();
     }
+    powerManager.idle();
 }
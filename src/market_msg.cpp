@@ -0,0 +1,115 @@
+#include "market_msg.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include "msgpack_parser.h"
+
+#define FIELD_T 0x01
+#define FIELD_O 0x02
+#define FIELD_H 0x04
+#define FIELD_L 0x08
+#define FIELD_C 0x10
+#define FIELD_KLINE 0x1f
+
+// 單一物件 (depth 1) 或最外層陣列中的物件 (depth 2)
+void MarketMsgHandler::onBegin(int depth, bool isArray) {
+    if (isArray || depth > 2 || _objectDepth) return;
+    _objectDepth = depth;
+    _field = 0;
+    _fields = 0;
+    _interval[0] = 0;
+    _closed = false;
+    _price = 0;
+}
+
+void MarketMsgHandler::onKey(int depth, const char* key) {
+    // 欄位名稱都是單一字元
+    if (depth == _objectDepth) _field = key[0] && !key[1] ? key[0] : 0;
+}
+
+void MarketMsgHandler::onValue(int depth, int index, const char* value, bool isString) {
+    if (!_objectDepth) {
+        // MsgPack 整則只有一個數字：視為價格
+        float p = depth == 0 && !isString ? strtof(value, nullptr) : 0;
+        if (p > 0) {
+            _sink.onPrice(p);
+            _result.prices++;
+        }
+        return;
+    }
+    if (depth != _objectDepth) return;
+    switch (_field) {
+        case 'i':
+            strncpy(_interval, value, sizeof(_interval) - 1);
+            _interval[sizeof(_interval) - 1] = 0;
+            break;
+        // 時間以 double 解析：MsgPack 可能送成浮點數，13 位數的 ms 仍然精確
+        case 't': _k.openTime = (uint64_t)strtod(value, nullptr); _fields |= FIELD_T; break;
+        case 'o': _k.open = strtof(value, nullptr); _fields |= FIELD_O; break;
+        case 'h': _k.high = strtof(value, nullptr); _fields |= FIELD_H; break;
+        case 'l': _k.low = strtof(value, nullptr); _fields |= FIELD_L; break;
+        case 'c': _k.close = strtof(value, nullptr); _fields |= FIELD_C; break;
+        case 'x': _closed = strcmp(value, "true") == 0; break;
+        case 'p': _price = strtof(value, nullptr); break;
+        case 'E': _result.eventMs = (uint64_t)strtod(value, nullptr); break;
+        default: break;
+    }
+    _field = 0;
+}
+
+void MarketMsgHandler::onEnd(int depth, bool isArray) {
+    if (isArray || depth != _objectDepth) return;
+    _objectDepth = 0;
+    const char* interval = _interval[0] ? _interval : _topicInterval;
+    if (_fields == FIELD_KLINE && interval && *interval && _k.openTime) {
+        _sink.onKLine(interval, _k, _closed);
+        _result.klines++;
+    }
+    if (_price > 0) {
+        _sink.onPrice(_price);
+        _result.prices++;
+    }
+}
+
+// MsgPack 的 map / array / 浮點數開頭都不是可印字元；其餘視為 JSON 文字
+static bool isMsgPack(uint8_t b) {
+    return (b >= 0x80 && b <= 0x9f) || (b >= 0xdc && b <= 0xdf) || b == 0xca || b == 0xcb;
+}
+
+MarketMsgResult decodeMarketMsg(const char* topic, const uint8_t* payload, size_t len, MarketMsgSink& sink) {
+    const char* slash = topic ? strrchr(topic, '/') : nullptr;
+    MarketMsgHandler handler(slash ? slash + 1 : topic, sink);
+    MarketMsgResult& r = handler.result();
+    size_t i = 0;
+    while (i < len && (payload[i] == ' ' || payload[i] == '\t' || payload[i] == '\r' || payload[i] == '\n')) i++;
+    if (i == len) return r;
+    if (isMsgPack(payload[i])) {
+        r.format = MARKET_MSGPACK;
+        MsgPackParser parser(handler);
+        r.ok = parser.parse(payload + i, len - i);
+    } else if (payload[i] == '{' || payload[i] == '[') {
+        r.format = MARKET_JSON;
+        JsonStreamParser parser(handler);
+        parser.feed(payload + i, len - i);
+        r.ok = parser.done();
+    } else {
+        // 純文字數字 (mosquitto_pub -m 64000.5)
+        r.format = MARKET_JSON;
+        char buf[32];
+        size_t n = len - i < sizeof(buf) - 1 ? len - i : sizeof(buf) - 1;
+        memcpy(buf, payload + i, n);
+        buf[n] = 0;
+        char* end;
+        float p = strtof(buf, &end);
+        r.ok = end != buf && p > 0;
+        if (r.ok) {
+            sink.onPrice(p);
+            r.prices++;
+        }
+    }
+    return r;
+}
+
+const char* marketFormatName(MarketFormat format) {
+    return format == MARKET_MSGPACK ? "msgpack" : "json";
+}
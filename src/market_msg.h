@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "json_stream.h"
+#include "kline_store.h"
+
+// --- 精簡行情訊息 (本地 MQTT broker 轉發用)：JSON 或 MsgPack，依第一個位元組自動判斷 ---
+// 單根 K線：{"i":"1m","t":1700000000000,"o":64000.1,"h":64010,"l":63990.5,"c":64005.2,"x":false,"E":1700000000123}
+// 價格    ：{"p":64005.2,"E":1700000000123}，或整則只有一個數字 64005.2
+// 整組    ：[{"i":"1h","t":...,"o":...}, ...] (通常以 retained 發布，訂閱時立即收到完整序列)
+// 欄位與 Binance WebSocket 的 k 相同；數值可為數字或字串。"i" 省略時取 topic 的最後一段，"E" 為發布時間 (可省略)。
+// 不依賴 Arduino，裝置與主機 (tools/host_mqtt.cpp) 共用。
+
+enum MarketFormat : uint8_t { MARKET_JSON, MARKET_MSGPACK };
+
+class MarketMsgSink {
+public:
+    virtual ~MarketMsgSink() {}
+    virtual void onKLine(const char* interval, const KLine& k, bool closed) = 0;
+    virtual void onPrice(float price) = 0;
+};
+
+struct MarketMsgResult {
+    MarketFormat format;
+    bool ok;              // 整則解析成功 (其中不完整的 K線仍會被略過)
+    uint16_t klines;
+    uint16_t prices;
+    uint64_t eventMs;     // 最後一個 "E"，沒有時為 0
+};
+
+// 每個物件結束時依收到的欄位送出 K線 (t/o/h/l/c 齊全) 及 / 或價格 (p)
+class MarketMsgHandler : public JsonStreamHandler {
+public:
+    MarketMsgHandler(const char* topicInterval, MarketMsgSink& sink) : _topicInterval(topicInterval), _sink(sink) {}
+    void onBegin(int depth, bool isArray) override;
+    void onEnd(int depth, bool isArray) override;
+    void onKey(int depth, const char* key) override;
+    void onValue(int depth, int index, const char* value, bool isString) override;
+    MarketMsgResult& result() { return _result; }
+
+private:
+    const char* _topicInterval;
+    MarketMsgSink& _sink;
+    MarketMsgResult _result = {};
+    int _objectDepth = 0;     // 正在收集欄位的物件所在層數，0 表示不在物件內
+    char _field = 0;
+    uint8_t _fields = 0;      // 已收到的 t/o/h/l/c 位元
+    KLine _k;
+    char _interval[8];
+    bool _closed = false;
+    float _price = 0;
+};
+
+MarketMsgResult decodeMarketMsg(const char* topic, const uint8_t* payload, size_t len, MarketMsgSink& sink);
+const char* marketFormatName(MarketFormat format);
@@ -0,0 +1,81 @@
+#include "mqtt_feed.h"
+
+#include <WiFi.h>
+#include <sys/time.h>
+
+MqttFeed mqttFeed;
+
+void MqttFeed::begin(const char* broker, uint16_t port, const char* topic, MarketMsgSink& sink) {
+    _topic = topic;
+    _sink = &sink;
+    // 每台用不同的 client id，否則 broker 會把同名的舊連線踢掉
+    snprintf(_clientId, sizeof(_clientId), "btcmon-%06llx", (unsigned long long)(ESP.getEfuseMac() & 0xffffff));
+    _mqtt.setServer(broker, port);
+    _mqtt.setBufferSize(MQTT_BUFFER);
+    _mqtt.setKeepAlive(MQTT_KEEPALIVE_S);
+    _mqtt.setSocketTimeout(2);
+    _mqtt.setCallback([this](char* t, uint8_t* p, unsigned int len) { onMessage(t, p, len); });
+}
+
+// clean session + QoS 0：斷線期間的訊息不補，重新訂閱時 broker 送出 retained 的整組序列
+void MqttFeed::connect() {
+    uint32_t now = millis();
+    if ((int32_t)(now - _nextAttempt) < 0) return;
+    if (_mqtt.connect(_clientId, MQTT_USER, MQTT_PASS) && _mqtt.subscribe(_topic, 0)) {
+        _stats.connects++;
+        _backoffMs = MQTT_BACKOFF_MIN_MS;
+        _wasConnected = true;
+        Serial.printf("[mqtt] connected as %s, subscribed %s\n", _clientId, _topic);
+        return;
+    }
+    Serial.printf("[mqtt] connect failed state=%d, retry in %ums\n", _mqtt.state(), _backoffMs);
+    _nextAttempt = now + _backoffMs;
+    _backoffMs = min(_backoffMs * 2, (uint32_t)MQTT_BACKOFF_MAX_MS);
+}
+
+void MqttFeed::loop() {
+    if (WiFi.status() != WL_CONNECTED) return;
+    if (!_mqtt.connected()) {
+        if (_wasConnected) {
+            _stats.disconnects++;
+            _wasConnected = false;
+            Serial.printf("[mqtt] disconnected state=%d\n", _mqtt.state());
+        }
+        connect();
+        return;
+    }
+    // PubSubClient::loop() 每次只讀一個封包：已到的訊息這一輪就處理完，不等下一輪
+    for (int i = 0; i < 16 && _net.available(); i++) _mqtt.loop();
+    _mqtt.loop();
+}
+
+void MqttFeed::onMessage(const char* topic, const uint8_t* payload, unsigned int len) {
+    _stats.messages++;
+    MarketMsgResult r = decodeMarketMsg(topic, payload, len, *_sink);
+    if (r.format == MARKET_MSGPACK) _stats.msgpack++;
+    else _stats.json++;
+    if (!r.ok) _stats.errors++;
+    _stats.klines += r.klines;
+    _stats.prices += r.prices;
+    // 發布端帶了 "E" 且兩邊都已校時 (SNTP) 才算延遲
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    uint64_t nowMs = (uint64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+    if (r.eventMs && tv.tv_sec > 1600000000 && nowMs >= r.eventMs && nowMs - r.eventMs < 60000) {
+        uint32_t lat = nowMs - r.eventMs;
+        _stats.latencyCount++;
+        _stats.latencyMsTotal += lat;
+        _stats.latencyMsMax = max(_stats.latencyMsMax, lat);
+    }
+}
+
+// [mqtt] 訊息數 (依格式)、K線 / 價格筆數、錯誤、重連次數，與發布到收到的延遲 (需兩端校時)
+void MqttFeed::printStats(Print& out) {
+    out.printf("[mqtt] %s msgs=%u json=%u msgpack=%u klines=%u prices=%u errors=%u connects=%u drops=%u",
+               _mqtt.connected() ? "up" : "down", _stats.messages, _stats.json, _stats.msgpack, _stats.klines,
+               _stats.prices, _stats.errors, _stats.connects, _stats.disconnects);
+    if (_stats.latencyCount) {
+        out.printf(" lat_avg=%ums lat_max=%ums", _stats.latencyMsTotal / _stats.latencyCount, _stats.latencyMsMax);
+    }
+    out.println();
+}
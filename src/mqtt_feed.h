@@ -0,0 +1,66 @@
+#pragma once
+
+#include <Arduino.h>
+#include <WiFiClient.h>
+#include <PubSubClient.h>
+#include "market_msg.h"
+
+// --- MQTT 輸入：從本地 broker 訂閱精簡的 K線 / 價格訊息 (JSON 或 MsgPack)，取代連外的 REST / WebSocket ---
+// 設定 MQTT_BROKER 後網路 task 只連 broker，不連交易所；QoS 0，收到就合併進序列並發布。
+// 訊息格式見 market_msg.h；主機上以 tools/mqtt_broker.py (mosquitto 替身 + 行情產生器) 測試。
+#ifndef MQTT_PORT
+#define MQTT_PORT 1883
+#endif
+#ifndef MQTT_TOPIC
+#define MQTT_TOPIC "market/BTCUSDT/#"
+#endif
+#ifndef MQTT_USER
+#define MQTT_USER nullptr
+#endif
+#ifndef MQTT_PASS
+#define MQTT_PASS nullptr
+#endif
+#define MQTT_KEEPALIVE_S 15
+#define MQTT_BUFFER 4096            // 單則訊息上限；整組 30 根 JSON 約 3.5 KB，MsgPack 約 2 KB
+#define MQTT_BACKOFF_MIN_MS 1000
+#define MQTT_BACKOFF_MAX_MS 30000
+
+struct MqttStats {
+    uint32_t messages;
+    uint32_t json;
+    uint32_t msgpack;
+    uint32_t klines;
+    uint32_t prices;
+    uint32_t errors;        // 解析失敗的訊息 (超過 MQTT_BUFFER 的由 PubSubClient 直接丟掉，不會進來)
+    uint32_t connects;
+    uint32_t disconnects;
+    uint32_t latencyCount;  // 帶 "E" 且已校時的訊息
+    uint32_t latencyMsTotal;
+    uint32_t latencyMsMax;
+};
+
+class MqttFeed {
+public:
+    void begin(const char* broker, uint16_t port, const char* topic, MarketMsgSink& sink);
+    // 網路 task 每輪呼叫：斷線時依退避重連，連上後收訊息並分派給 sink
+    void loop();
+    bool connected() { return _mqtt.connected(); }
+    const MqttStats& stats() const { return _stats; }
+    void printStats(Print& out);
+
+private:
+    void connect();
+    void onMessage(const char* topic, const uint8_t* payload, unsigned int len);
+
+    WiFiClient _net;
+    PubSubClient _mqtt{_net};
+    const char* _topic = nullptr;
+    MarketMsgSink* _sink = nullptr;
+    char _clientId[24];
+    bool _wasConnected = false;
+    uint32_t _nextAttempt = 0;
+    uint32_t _backoffMs = MQTT_BACKOFF_MIN_MS;
+    MqttStats _stats = {};
+};
+
+extern MqttFeed mqttFeed;
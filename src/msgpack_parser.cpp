@@ -0,0 +1,90 @@
+#include "msgpack_parser.h"
+
+#include <stdio.h>
+#include <string.h>
+
+uint64_t MsgPackParser::be(int n) {
+    uint64_t v = 0;
+    for (int i = 0; i < n; i++) v = v << 8 | _data[_pos++];
+    return v;
+}
+
+bool MsgPackParser::parse(const uint8_t* data, size_t len) {
+    _data = data;
+    _len = len;
+    _pos = 0;
+    return value(0, 0, false) && _pos == _len;
+}
+
+bool MsgPackParser::container(int depth, uint32_t count, bool isArray) {
+    if (depth > JSON_STREAM_MAX_DEPTH) return false;
+    _handler.onBegin(depth, isArray);
+    for (uint32_t i = 0; i < count; i++) {
+        if (!isArray && !value(depth, i, true)) return false;
+        if (!value(depth, i, false)) return false;
+    }
+    _handler.onEnd(depth, isArray);
+    return true;
+}
+
+// depth 為值所在容器的層數 (最外層的值為 0，與 JsonStreamParser 相同)；isKey 時以 onKey 送出
+bool MsgPackParser::value(int depth, int index, bool isKey) {
+    if (!need(1)) return false;
+    uint8_t b = _data[_pos++];
+    // map / array：fix、16、32 位元長度
+    if ((b & 0xe0) == 0x80) return !isKey && container(depth + 1, b & 0x0f, (b & 0x10) != 0);
+    if (b == 0xdc || b == 0xde) return !isKey && need(2) && container(depth + 1, be(2), b == 0xdc);
+    if (b == 0xdd || b == 0xdf) return !isKey && need(4) && container(depth + 1, be(4), b == 0xdd);
+
+    bool isString = false;
+    size_t slen = 0;
+    if ((b & 0xe0) == 0xa0) {
+        isString = true;
+        slen = b & 0x1f;
+    } else if (b >= 0xd9 && b <= 0xdb) {
+        int n = 1 << (b - 0xd9);
+        if (!need(n)) return false;
+        isString = true;
+        slen = be(n);
+    }
+    if (isString) {
+        if (slen >= JSON_STREAM_TOKEN || !need(slen)) return false;
+        memcpy(_token, _data + _pos, slen);
+        _token[slen] = 0;
+        _pos += slen;
+    } else if (b <= 0x7f) {
+        snprintf(_token, sizeof(_token), "%u", b);
+    } else if (b >= 0xe0) {
+        snprintf(_token, sizeof(_token), "%d", (int8_t)b);
+    } else if (b == 0xc0 || b == 0xc2 || b == 0xc3) {
+        strcpy(_token, b == 0xc0 ? "null" : b == 0xc2 ? "false" : "true");
+    } else if (b == 0xca) {
+        if (!need(4)) return false;
+        uint32_t bits = be(4);
+        float f;
+        memcpy(&f, &bits, 4);
+        snprintf(_token, sizeof(_token), "%.9g", f);
+    } else if (b == 0xcb) {
+        if (!need(8)) return false;
+        uint64_t bits = be(8);
+        double d;
+        memcpy(&d, &bits, 8);
+        snprintf(_token, sizeof(_token), "%.17g", d);
+    } else if (b >= 0xcc && b <= 0xcf) {
+        int n = 1 << (b - 0xcc);
+        if (!need(n)) return false;
+        snprintf(_token, sizeof(_token), "%llu", (unsigned long long)be(n));
+    } else if (b >= 0xd0 && b <= 0xd3) {
+        int n = 1 << (b - 0xd0);
+        if (!need(n)) return false;
+        uint64_t v = be(n);
+        // 依長度做符號延伸
+        if (n < 8 && (v >> (n * 8 - 1))) v |= ~0ull << (n * 8);
+        snprintf(_token, sizeof(_token), "%lld", (long long)v);
+    } else {
+        return false;   // bin / ext / 保留值
+    }
+    if (isKey) _handler.onKey(depth, _token);
+    else _handler.onValue(depth, index, _token, isString);
+    return true;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "json_stream.h"
+
+// --- MsgPack 解析：把一則完整的 MsgPack 訊息轉成與 JsonStreamParser 相同的事件 ---
+// 同一個 JsonStreamHandler 不用改就能處理兩種格式。數值轉成與 JSON literal 相同的字串
+// (整數、%.9g / %.17g、true / false / null)，字串與 map 的 key 以 isString = true 送出。
+// 不依賴 Arduino，裝置與主機 (tools/host_mqtt.cpp) 共用。
+// 不支援 bin / ext (行情訊息用不到)，遇到時視為錯誤。
+
+class MsgPackParser {
+public:
+    explicit MsgPackParser(JsonStreamHandler& handler) : _handler(handler) {}
+    // 整則訊息必須剛好是一個值；格式錯誤、截斷、層數或字串超過上限時回傳 false
+    bool parse(const uint8_t* data, size_t len);
+
+private:
+    bool value(int depth, int index, bool isKey);
+    bool container(int depth, uint32_t count, bool isArray);
+    bool need(size_t n) const { return _len - _pos >= n; }
+    uint64_t be(int n);
+
+    JsonStreamHandler& _handler;
+    const uint8_t* _data = nullptr;
+    size_t _len = 0;
+    size_t _pos = 0;
+    char _token[JSON_STREAM_TOKEN];
+};
@@ -0,0 +1,687 @@
+#include "net_task.h"
+
+#include <atomic>
+#include <sys/time.h>
+#include <esp_timer.h>
+#include <WiFi.h>
+#include <ArduinoJson.h>
+#include "rest_conn.h"
+#include "tls_ca.h"
+#include "kline_stream.h"
+#include "kline_cache.h"
+#include "refresh_scheduler.h"
+#include "clock_sync.h"
+#include "kline_fetch.h"
+#include "spsc_ring.h"
+#include "dns_cache.h"
+#include "rate_budget.h"
+#include "fetch_queue.h"
+#include "tls_bench.h"
+#include "watchlist.h"
+#include "exchange_set.h"
+#include "lan_relay.h"
+#include "capture.h"
+#include "mqtt_feed.h"
+
+#define NET_TASK_CORE 0
+#define NET_TASK_STACK 12288
+#define PREFETCH_GAP_MS 3000     // 背景預抓之間的最小間隔 (失敗重試由 FetchQueue 退避)
+#define STREAM_TOUCH_MS 10000    // 串流更新但內容沒變時，至少這麼久發布一次以更新資料年齡
+#define TICKER_POLL_MS 2000      // 串流斷線時輪詢 ticker 價格的間隔
+#define CLOCK_SYNC_FAST_MS 30000   // 樣本不足時的校時間隔
+#define CLOCK_SYNC_MS 600000       // 穩定後每 10 分鐘校時一次
+#ifndef WATCHLIST
+#define WATCHLIST "BTCUSDT,ETHUSDT,BNBUSDT,SOLUSDT,XRPUSDT"
+#endif
+#define WATCHLIST_POLL_MS 15000    // 自選清單刷新間隔，失敗時同樣等下一輪
+#define KLINE_FAILOVER_AFTER 3     // K線來源連續失敗幾次後換交易所
+#define KLINE_FAILBACK_MS 300000   // 改用其他交易所後，每 5 分鐘試一次 Binance
+// Binance 請求權重 (limit 1~100 的 klines 為 2)
+#define WEIGHT_KLINES 2
+#define WEIGHT_TICKER 2
+#define WEIGHT_TIME 1
+#define WEIGHT_WATCHLIST 2         // ticker/24hr 帶 1~20 個 symbols
+#define RATE_DEFERRED -100         // binanceGet() 因權重預算不足而沒有送出
+
+// 以下僅網路 task 存取
+static RestConn binance;
+static KLineStream stream;
+static KLineSeries series[INTERVAL_COUNT];
+static float currentPrice = 0;
+static uint32_t pendingMask = 0;   // 有更新但還沒成功發布的週期
+static CacheStats cacheStats;
+static RefreshScheduler scheduler;
+static ClockSync exchangeClock;
+static RateBudget rateBudget;
+static FetchQueue fetchQueue;
+static Watchlist watchlist;
+static uint32_t lastWatchlist = 0;
+static int klineSource = EXCHANGE_BINANCE;   // 目前抓 K線的交易所
+static uint8_t sourceFailures = 0;
+static uint32_t failbackAt = 0;
+static float publishedPrice = 0;
+
+// 跨 task 共用，全部無鎖
+static SpscRing<KLineSnapshot, SNAPSHOT_SLOTS> snapshots;
+static SpscRing<Watchlist, 2> watchSnapshots;
+static std::atomic<uint32_t> fetchRequests{0};
+static std::atomic<int> viewInterval{2};
+static std::atomic<bool> busy{false};
+static std::atomic<uint32_t> fetchAvgMs{0};
+
+// 64 位元本地時間 (ms)，不像 millis() 會在 49 天後溢位
+static uint64_t localMs() {
+    return esp_timer_get_time() / 1000;
+}
+
+#if REPLAY_MODE
+// 回放時的交易所時間：最近一筆 Date 標頭 (或 serverTime) 加上之後經過的記錄時間，與回放速度無關
+static uint64_t replayServerMs = 0;
+#endif
+
+static uint64_t exchangeNowMs() {
+#if REPLAY_MODE
+    return replayServerMs;
+#else
+    return exchangeClock.nowMs(localMs());
+#endif
+}
+
+static void printRateBudget() {
+    uint64_t now = localMs();
+    const RateStats& st = rateBudget.stats();
+    Serial.printf("[rate] ip_used=%u/%u tokens=%d/%d allowed=%u deferred=%u limited=%u blocked=%us\n",
+                  rateBudget.usedWeight(now), RATE_WEIGHT_LIMIT, rateBudget.tokens(now), RATE_DEVICE_WEIGHT,
+                  st.allowed, st.deferred, st.limited, rateBudget.blockedForMs(now) / 1000);
+}
+
+// 所有 REST 請求都經過這裡：先扣權重預算，標記忙碌，並把回應的 Date 標頭當成低精度校時樣本
+template <typename Body>
+static int binanceGet(const char* path, Body& body, RatePriority prio, uint16_t weight) {
+    if (!rateBudget.allow(prio, weight, localMs())) return RATE_DEFERRED;
+    busy = true;
+    uint64_t t0 = localMs();
+    int httpCode = binance.get(path, body);
+    uint64_t t1 = localMs();
+    busy = false;
+    // 指數移動平均，權重 1/8
+    uint32_t avg = fetchAvgMs;
+    fetchAvgMs = avg ? avg + ((int32_t)(t1 - t0) - (int32_t)avg) / 8 : (uint32_t)(t1 - t0);
+    rateBudget.onResponse(httpCode, binance.lastUsedWeight(), binance.lastRetryAfter(), t1);
+    if (httpCode == 429 || httpCode == 418) printRateBudget();
+    // Date 只到秒：取該秒中點，並計入 500 ms 解析度；已有精確樣本後就不再需要
+    if (binance.lastDateMs() && exchangeClock.goodCount() == 0) {
+        exchangeClock.addSample(t0, t1, binance.lastDateMs() + 500, 500);
+    }
+    return httpCode;
+}
+
+// SNTP 已同步時以系統時間當成低精度校時樣本
+static bool addSntpSample() {
+    if (time(nullptr) <= 1600000000) return false;
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    uint64_t l = localMs();
+    exchangeClock.addSample(l, l, (uint64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000, 50);
+    return true;
+}
+
+// /api/v3/time 以 RTT 補償取樣；失敗時若 SNTP 已同步就改用系統時間
+static void syncClock() {
+    static uint64_t nextSync = 0;
+    uint64_t now = localMs();
+    if (now < nextSync || WiFi.status() != WL_CONNECTED) return;
+    // 精確樣本不足 4 個前以快速間隔校時；Date 樣本不算
+    nextSync = now + (exchangeClock.goodCount() < 4 ? CLOCK_SYNC_FAST_MS : CLOCK_SYNC_MS);
+
+    String payload;
+    uint64_t t0 = localMs();
+    // 這裡不經過 binanceGet()，避免把同一次回應的 Date 也當成樣本
+    int httpCode = RATE_DEFERRED;
+    if (rateBudget.allow(RATE_LOW, WEIGHT_TIME, t0)) {
+        httpCode = binance.get("/api/v3/time", payload);
+        rateBudget.onResponse(httpCode, binance.lastUsedWeight(), binance.lastRetryAfter(), localMs());
+    }
+    uint64_t t1 = localMs();
+    JsonDocument doc;
+    if (httpCode == HTTP_CODE_OK && !deserializeJson(doc, payload) && doc["serverTime"].as<uint64_t>()) {
+        exchangeClock.addSample(t0, t1, doc["serverTime"].as<uint64_t>());
+    } else {
+        addSntpSample();
+    }
+    Serial.printf("[clock] offset=%lldms drift=%.1fppm unc=%ums samples=%d good=%d\n",
+                  (long long)exchangeClock.offsetMs(t1), exchangeClock.driftPpm(),
+                  exchangeClock.uncertaintyMs(t1), exchangeClock.count(), exchangeClock.goodCount());
+}
+
+// 依失敗的階段分類：連線前的錯誤看 TLS client 記錄的階段，其餘看 HTTP 狀態與解析結果
+static FetchOutcome classifyFetch(int httpCode, bool parsed, const Transport& conn) {
+    if (httpCode == RATE_DEFERRED) return FETCH_DEFERRED;
+    if (httpCode == HTTP_CODE_OK) return parsed ? FETCH_OK : FETCH_PARSE;
+    if (httpCode > 0) return FETCH_HTTP;
+    if (httpCode == HTTPC_ERROR_ENCODING) return FETCH_PARSE;
+    switch (conn.connectError()) {
+        case CONNECT_DNS: return FETCH_DNS;
+        case CONNECT_TCP: return FETCH_CONNECT;
+        case CONNECT_TLS: return FETCH_TLS;
+        default: return FETCH_READ;
+    }
+}
+
+static void fetchAllKLineData();
+
+// 換 K線來源時清空序列：不同交易所的開高低收略有差異，不混在同一組序列裡
+static void switchKLineSource(int ex) {
+    if (ex == klineSource) return;
+    Serial.printf("[exch] klines %s -> %s\n", exchanges[klineSource]->name(), exchanges[ex]->name());
+    klineSource = ex;
+    sourceFailures = 0;
+    failbackAt = millis() + KLINE_FAILBACK_MS;
+    for (int i = 0; i < INTERVAL_COUNT; i++) series[i].clear();
+    fetchAllKLineData();
+}
+
+// 連線失敗、被封鎖 (403 / 451) 或 5xx 都算來源故障；串流正常時 Binance 顯然可用，不換
+static void trackKLineSource(int ex, FetchOutcome outcome, int httpCode) {
+    bool failed = outcome == FETCH_DNS || outcome == FETCH_CONNECT || outcome == FETCH_TLS ||
+                  httpCode == 403 || httpCode == 451 || httpCode >= 500;
+    if (ex != klineSource) return;
+    sourceFailures = failed ? sourceFailures + 1 : 0;
+    if (sourceFailures < KLINE_FAILOVER_AFTER || stream.connected()) return;
+    int next = exchangeSet.healthiest(millis(), ex);
+    if (next >= 0) switchKLineSource(next);
+    else sourceFailures = 0;
+}
+
+// 一個週期的 K線已成功合併：更新價格並標記待發布
+static void onKLinesRefreshed(int idx, int ex) {
+    KLineSeries& klines = series[idx];
+    if (klines.last()) {
+        currentPrice = klines.last()->close;
+        exchangeSet.report(ex, currentPrice, millis());
+    }
+    klines.refreshedAt = millis();
+    pendingMask |= 1u << idx;
+}
+
+// 已有完整 30 根時只從最後一根的開盤時間往後抓，合併進現有序列。
+// 使用者切換的週期為高優先，背景預抓為低優先 (預算不足時延後)。
+// Binance 不可用時改向其他交易所抓，該交易所沒有這個週期就退回 Binance。
+// 4xx (429 除外) 是請求本身的問題，retryable 設為 false
+static FetchOutcome fetchKLineData(int idx, RatePriority prio, bool& retryable) {
+    retryable = true;
+    if (WiFi.status() != WL_CONNECTED) return FETCH_CONNECT;
+    bool ok = false;
+    KLineSeries& klines = series[idx];
+    char path[128];
+    int ex = exchanges[klineSource]->supports(idx) ? klineSource : EXCHANGE_BINANCE;
+    // 回應直接從連線串流解析，每解析完一列就合併，不緩衝整份 body
+    KLineFetch fetch(klines, *exchanges[ex]);
+    fetch.path(path, sizeof(path), idx);
+    bool gap = false;
+    int httpCode;
+    RestConn* conn = &binance;
+    bool borrowed = false;
+    if (ex == EXCHANGE_BINANCE) {
+        httpCode = binanceGet(path, fetch, prio, WEIGHT_KLINES);
+    } else if ((conn = exchangeSet.acquire(ex)) != nullptr) {
+        borrowed = true;
+        busy = true;
+        httpCode = conn->get(path, fetch);
+        busy = false;
+    } else {
+        // worker 正在用這條連線抓價格，稍後重試
+        conn = &binance;
+        httpCode = RATE_DEFERRED;
+    }
+    if (httpCode == HTTP_CODE_OK && fetch.parsed()) {
+        gap = fetch.gap();
+        onKLinesRefreshed(idx, ex);
+        ok = true;
+    }
+    FetchOutcome outcome = classifyFetch(httpCode, fetch.parsed(), *conn);
+    retryable = httpCode < 400 || httpCode >= 500 || httpCode == 429;
+    if (httpCode != RATE_DEFERRED) {
+        conn->printStats(Serial);
+        if (ex == EXCHANGE_BINANCE) printRateBudget();
+        trackKLineSource(ex, outcome, httpCode);
+    }
+    if (borrowed) {
+        // 與 worker 抓價格時相同：失敗才關閉，成功時保留 keep-alive 再歸還
+        if (!ok) conn->close();
+        exchangeSet.release(ex);
+    }
+    uint64_t serverNow = exchangeNowMs();
+    if (serverNow && !gap) {
+        if (ok) scheduler.onRefreshed(idx, klines.lastOpenTime(), serverNow);
+        else scheduler.onFailed(idx, serverNow);
+    }
+    if (gap) {
+        klines.clear();
+        outcome = fetchKLineData(idx, prio, retryable);
+    }
+    return outcome;
+}
+
+// 只更新還沒收盤的最後一根；已跨過邊界的交給 K線刷新
+static void applyPrice(float price) {
+    currentPrice = price;
+    exchangeSet.report(EXCHANGE_BINANCE, price, millis());
+    uint64_t serverNow = exchangeNowMs();
+    for (int i = 0; i < INTERVAL_COUNT; i++) {
+        if (cacheCandleClosed(series[i], i, serverNow)) continue;
+        if (series[i].applyPrice(price)) pendingMask |= 1u << i;
+    }
+}
+
+// {"symbol":"BTCUSDT","price":"..."}
+static bool applyTickerPrice(const char* payload, size_t length) {
+    JsonDocument doc;
+    if (deserializeJson(doc, payload, length)) return false;
+    float price = doc["price"].as<float>();
+    if (price <= 0) return false;
+    applyPrice(price);
+    return true;
+}
+
+// /api/v3/ticker/price 回應只有幾十位元組，用來在 K線刷新之間更新即時價格
+static bool fetchTickerPrice() {
+    if (WiFi.status() != WL_CONNECTED) return false;
+    String payload;
+    int httpCode = binanceGet("/api/v3/ticker/price?symbol=BTCUSDT", payload, RATE_LOW, WEIGHT_TICKER);
+    if (httpCode != HTTP_CODE_OK) return false;
+    return applyTickerPrice(payload.c_str(), payload.length());
+}
+
+// 整個自選清單一次請求；回應逐個物件解析，寫回清單中對應的紀錄
+static void fetchWatchlist() {
+    if (WiFi.status() != WL_CONNECTED || !watchlist.count) return;
+    lastWatchlist = millis();
+    char path[WATCHLIST_MAX * (WATCHLIST_SYMBOL + 7) + 48];
+    WatchlistFetch fetch(watchlist);
+    if (!fetch.path(path, sizeof(path))) return;
+    uint64_t t0 = localMs();
+    int httpCode = binanceGet(path, fetch, RATE_LOW, WEIGHT_WATCHLIST);
+    if (httpCode == RATE_DEFERRED) return;
+    Serial.printf("[watch] http=%d symbols=%d updated=%d %ums\n", httpCode, watchlist.count, fetch.updated(),
+                  (uint32_t)(localMs() - t0));
+    // UI 還沒取走上一份時丟掉這次，下一輪再發布
+    if (httpCode == HTTP_CODE_OK && fetch.updated()) watchSnapshots.push(watchlist);
+}
+
+// 串流重連後補資料：顯示中的週期先抓，其餘排在低優先
+static void fetchAllKLineData() {
+    uint64_t now = localMs();
+    int view = viewInterval;
+    fetchQueue.enqueue(view, RATE_HIGH, now);
+    for (int i = 0; i < INTERVAL_COUNT; i++) {
+        if (i != view) fetchQueue.enqueue(i, RATE_LOW, now);
+    }
+}
+
+static void printFetchStats() {
+    const FetchStats& st = fetchQueue.stats();
+    Serial.print("[fetch]");
+    for (int i = 0; i < FETCH_OUTCOME_COUNT; i++) {
+        Serial.printf(" %s=%u", FetchQueue::outcomeName((FetchOutcome)i), st.outcomes[i]);
+    }
+    Serial.printf(" retry=%u coalesced=%u dropped=%u\n", st.retries, st.coalesced, st.dropped);
+}
+
+// 每輪最多執行一筆到期的請求；失敗的由佇列以退避 + 抖動重排
+static void runFetchQueue() {
+    RatePriority prio;
+    int idx = fetchQueue.next(localMs(), &prio);
+    if (idx < 0) return;
+    bool retryable;
+    FetchOutcome outcome = fetchKLineData(idx, prio, retryable);
+    fetchQueue.complete(idx, outcome, retryable, localMs());
+    if (outcome != FETCH_DEFERRED) printFetchStats();
+}
+
+// WebSocket 推送的 K線依週期合併進對應序列
+static void onStreamKLine(const char* interval, const KLine& k, bool closed) {
+    for (int i = 0; i < INTERVAL_COUNT; i++) {
+        if (strcmp(interval, intervals[i]) != 0) continue;
+        uint32_t now = millis();
+        bool changed = series[i].merge(k);
+        if (changed || now - series[i].refreshedAt > STREAM_TOUCH_MS) pendingMask |= 1u << i;
+        if (changed) {
+            currentPrice = k.close;
+            exchangeSet.report(EXCHANGE_BINANCE, k.close, now);
+        }
+        series[i].refreshedAt = now;
+        return;
+    }
+}
+
+// 佇列滿時保留 pending 位元，下一輪再發布最新狀態，不會遺失更新
+static void publishPending() {
+    static KLineSnapshot snap;
+    // 顯示的價格依 PRICE_SELECT 從各交易所的新鮮報價選出；選出的價格變了也要發布
+    float price = currentPrice;
+    exchangeSet.price(price, millis());
+    if (price != publishedPrice) pendingMask |= 1u << viewInterval;
+    for (int i = 0; i < INTERVAL_COUNT && pendingMask; i++) {
+        if (!(pendingMask & (1u << i))) continue;
+        snap.intervalIdx = i;
+        snap.price = price;
+        snap.series = series[i];
+        if (!snapshots.push(snap)) return;
+        publishedPrice = price;
+        pendingMask &= ~(1u << i);
+        lanRelay.publish(i, price);
+    }
+}
+
+// follower：不連交易所也不建立 TLS，序列與價格全部來自 relay 的 multicast，不會返回
+static void runFollower() {
+    Serial.println("[relay] follower mode, waiting for relay");
+    uint32_t lastStats = 0;
+    for (;;) {
+        uint32_t updated = lanRelay.loop(0);
+        if (updated & RELAY_PRICE_BIT) currentPrice = lanRelay.price();
+        for (int i = 0; i < INTERVAL_COUNT; i++) {
+            if (!(updated & (1u << i))) continue;
+            series[i].refreshedAt = millis();
+            pendingMask |= 1u << i;
+        }
+        publishPending();
+        if (millis() - lastStats > 60000) {
+            lanRelay.printStats(Serial);
+            lastStats = millis();
+        }
+        vTaskDelay(pdMS_TO_TICKS(5));
+    }
+}
+
+#ifdef MQTT_BROKER
+// MQTT 訊息與 WebSocket 事件 / ticker 價格走同一條合併路徑
+class MqttSink : public MarketMsgSink {
+public:
+    void onKLine(const char* interval, const KLine& k, bool closed) override { onStreamKLine(interval, k, closed); }
+    void onPrice(float price) override { applyPrice(price); }
+};
+
+// MQTT：只連本地 broker，不連交易所也不建立 TLS；序列與價格全部來自訂閱的訊息，不會返回
+static void runMqtt() {
+    static MqttSink sink;
+    while (WiFi.status() != WL_CONNECTED) vTaskDelay(pdMS_TO_TICKS(50));
+    // 判斷 K線是否已收盤要知道時間；不通外網時 SNTP 失敗，價格仍會更新最後一根
+    configTime(0, 0, "pool.ntp.org", "time.google.com");
+    mqttFeed.begin(MQTT_BROKER, MQTT_PORT, MQTT_TOPIC, sink);
+    uint32_t lastStats = 0;
+    uint32_t lastClock = 0;
+    for (;;) {
+        mqttFeed.loop();
+        publishPending();
+        lanRelay.loop(publishedPrice);
+        if (millis() - lastClock > CLOCK_SYNC_FAST_MS) {
+            addSntpSample();
+            lastClock = millis();
+        }
+        if (millis() - lastStats > 60000) {
+            mqttFeed.printStats(Serial);
+            if (RELAY_ROLE == RELAY_SOURCE) lanRelay.printStats(Serial);
+            lastStats = millis();
+        }
+        // QoS 0 的推送隨時會到，輪詢間隔縮短到 2 ms
+        vTaskDelay(pdMS_TO_TICKS(2));
+    }
+}
+#endif
+
+#if REPLAY_MODE
+struct ReplayStats {
+    uint32_t records[ROUTE_COUNT];
+    uint32_t busyUs[ROUTE_COUNT];  // 解析 + 合併 + 發布花的時間
+    uint32_t failed;               // 記錄的是失敗的請求 (沒有 body 可解析)
+    uint32_t parseErrors;
+    uint32_t diverged;             // 依回放中的序列組出的 K線路徑與記錄的不同：流程已不是記錄時的狀態
+};
+
+// 一筆紀錄交給與連線時相同的處理函式
+static PayloadRoute replayEntry(const PayloadEntry& e, ReplayStats& st) {
+    int idx = 0;
+    PayloadRoute route = payloadRoute(e, &idx);
+    // 失敗的請求照樣餵：連線中途斷掉前串流解析已合併的列，回放時也要合併
+    bool http200 = route == ROUTE_STREAM || e.rec.httpCode == HTTP_CODE_OK;
+    if (!http200) st.failed++;
+    bool ok = true;
+    switch (route) {
+        case ROUTE_KLINES: {
+            KLineFetch fetch(series[idx]);
+            char path[128];
+            fetch.path(path, sizeof(path), idx);
+            if (strcmp(path, e.path) != 0) st.diverged++;
+            if (e.bodyLen) fetch.write(e.body, e.bodyLen);
+            ok = fetch.parsed() || !http200;
+            // 增量請求回滿一頁時連線端會清空重抓，重抓的回應是下一筆紀錄
+            if (http200 && fetch.parsed() && fetch.gap()) series[idx].clear();
+            else if (http200 && fetch.parsed()) onKLinesRefreshed(idx, EXCHANGE_BINANCE);
+            break;
+        }
+        case ROUTE_TICKER:
+            if (http200) ok = applyTickerPrice((const char*)e.body, e.bodyLen);
+            break;
+        case ROUTE_WATCHLIST: {
+            WatchlistFetch fetch(watchlist);
+            if (e.bodyLen) fetch.write(e.body, e.bodyLen);
+            if (http200 && fetch.updated()) watchSnapshots.push(watchlist);
+            break;
+        }
+        case ROUTE_TIME: {
+            if (!http200) break;
+            JsonDocument doc;
+            ok = !deserializeJson(doc, e.body, e.bodyLen) && doc["serverTime"].as<uint64_t>();
+            if (ok) replayServerMs = doc["serverTime"].as<uint64_t>();
+            break;
+        }
+        case ROUTE_STREAM:
+            stream.replay(e.body, e.bodyLen, onStreamKLine);
+            break;
+        default:
+            break;
+    }
+    if (!ok) st.parseErrors++;
+    return route;
+}
+
+// 回放：不連線，依記錄的順序與時間把 payload 餵給同一套解析 -> 合併 -> 發布流程，不會返回
+static void runReplay() {
+    static const char* const files[] = {CAPTURE_OLD_FILE, CAPTURE_FILE};
+    static PayloadReader reader;
+    static PayloadEntry entry;
+    watchlist.begin(WATCHLIST);
+    if (!payloadCapture.mount() || !reader.begin(files, 2)) {
+        Serial.println("[replay] no capture file, upload one to LittleFS (pio run -t uploadfs)");
+        for (;;) vTaskDelay(portMAX_DELAY);
+    }
+    Serial.printf("[replay] speed=%.1fx%s\n", (float)REPLAY_SPEED, REPLAY_SPEED > 0 ? "" : " (as fast as possible)");
+    for (uint32_t pass = 1;; pass++) {
+        ReplayStats st = {};
+        ReplayClock pace;
+        pace.begin(REPLAY_SPEED);
+        uint64_t serverBase = 0;
+        uint32_t serverAt = 0;
+        uint32_t lastYield = millis();
+        uint64_t start = localMs();
+        while (reader.next(entry)) {
+            const PayloadRecord& r = entry.rec;
+            uint32_t wait;
+            while ((wait = pace.waitMs(r.tMs, millis())) > 0) {
+                publishPending();
+                vTaskDelay(pdMS_TO_TICKS(min(wait, (uint32_t)50)));
+                lastYield = millis();
+            }
+            // 交易所時間跟著記錄走：有 Date 的回應重新對齊，換一次開機的紀錄就歸零等下一個 Date
+            if (r.flags & PAYLOAD_SESSION) serverBase = 0;
+            if (r.dateMs) {
+                serverBase = r.dateMs + 500;
+                serverAt = r.tMs;
+            }
+            if (serverBase) replayServerMs = serverBase + (r.tMs - serverAt);
+            uint64_t t0 = esp_timer_get_time();
+            PayloadRoute route = replayEntry(entry, st);
+            publishPending();
+            st.records[route]++;
+            st.busyUs[route] += esp_timer_get_time() - t0;
+            // 盡快回放時也要讓出 CPU，避免 idle task 的 watchdog
+            if (millis() - lastYield > 100) {
+                vTaskDelay(1);
+                lastYield = millis();
+            }
+        }
+        Serial.printf("[replay] pass=%u wall=%ums", pass, (uint32_t)(localMs() - start));
+        for (int i = 0; i < ROUTE_COUNT; i++) {
+            if (st.records[i]) Serial.printf(" %s=%u/%uus", payloadRouteName((PayloadRoute)i), st.records[i],
+                                             st.busyUs[i] / st.records[i]);
+        }
+        const PayloadStats& rs = reader.stats();
+        Serial.printf(" failed=%u parse_err=%u diverged=%u corrupt=%u\n", st.failed, st.parseErrors, st.diverged,
+                      rs.errors);
+        // 最後一筆之後的更新也要發布出去
+        while (pendingMask) {
+            publishPending();
+            vTaskDelay(pdMS_TO_TICKS(50));
+        }
+        if (!REPLAY_LOOP) for (;;) vTaskDelay(portMAX_DELAY);
+        vTaskDelay(pdMS_TO_TICKS(2000));
+        for (int i = 0; i < INTERVAL_COUNT; i++) series[i].clear();
+        replayServerMs = 0;
+        reader.rewind();
+    }
+}
+#endif
+
+// 背景預抓：每輪最多刷新一個週期。
+// 串流斷線且已知交易所時間時依 K線邊界排程；否則依快取年齡，空的週期成功後立即接著抓下一個
+static void prefetchStale() {
+    static uint32_t nextPrefetchAt = 0;
+    uint32_t now = millis();
+    uint64_t serverNow = exchangeNowMs();
+    int idx;
+    if (!stream.connected() && serverNow) {
+        idx = scheduler.due(serverNow, viewInterval);
+    } else {
+        if ((int32_t)(now - nextPrefetchAt) < 0) return;
+        idx = cachePickStale(series, viewInterval, now, serverNow);
+    }
+    if (idx < 0 || fetchQueue.pending(idx)) return;
+    if (!fetchQueue.enqueue(idx, RATE_LOW, localMs())) return;
+    cacheStats.prefetches++;
+    // 空的週期不等間隔，完成後立即接著排下一個
+    nextPrefetchAt = now + (series[idx].count == 0 ? 0 : PREFETCH_GAP_MS);
+    printCacheStats(Serial, "prefetch", cacheStats);
+}
+
+static void networkTask(void*) {
+    for (int i = 0; i < INTERVAL_COUNT; i++) series[i].clear();
+#if REPLAY_MODE
+    runReplay();
+#endif
+    lanRelay.begin(RELAY_ROLE, series);
+    if (RELAY_ROLE == RELAY_FOLLOWER) runFollower();
+#ifdef MQTT_BROKER
+    runMqtt();
+#endif
+    scheduler.begin(intervalSeconds, INTERVAL_COUNT, esp_random());
+    binance.begin(BINANCE_HOSTS, BINANCE_PORT, BINANCE_CA_BUNDLE);
+    binance.setWeightHeader("X-MBX-USED-WEIGHT-1m");
+#if CAPTURE_MODE
+    if (payloadCapture.begin()) {
+        binance.setCapture(payloadCapture.writer());
+        stream.setCapture(payloadCapture.writer());
+    }
+#endif
+    rateBudget.begin(localMs());
+    fetchQueue.begin(esp_random());
+    watchlist.begin(WATCHLIST);
+    exchangeSet.begin();
+    // WiFi 由 UI 端的狀態機在背景連線；開機的預先解析要等連上
+    while (WiFi.status() != WL_CONNECTED) vTaskDelay(pdMS_TO_TICKS(50));
+    // 先解析好 REST 主機，第一次抓取就不用等 DNS
+    dnsCache.prefetch(binance.host());
+    dnsCache.printStats(Serial);
+#if TLS_BENCH
+    runTlsBench(binance.host(), binance.port(), Serial);
+#endif
+    configTime(0, 0, "pool.ntp.org", "time.google.com");
+    stream.begin("BTCUSDT", intervals, INTERVAL_COUNT, onStreamKLine);
+
+    uint32_t lastTicker = 0;
+    for (;;) {
+        syncClock();
+        stream.loop();
+        // 串流 (重新) 連上時以 REST 補齊斷線期間的 K線
+        if (stream.takeResync()) {
+            if (klineSource != EXCHANGE_BINANCE) switchKLineSource(EXCHANGE_BINANCE);
+            else fetchAllKLineData();
+        }
+        // 改用其他交易所一段時間後試著回到 Binance，仍失敗會再換走
+        if (klineSource != EXCHANGE_BINANCE && (int32_t)(millis() - failbackAt) >= 0) {
+            switchKLineSource(EXCHANGE_BINANCE);
+        }
+        exchangeSet.poll(millis());
+        lanRelay.loop(publishedPrice);
+        static uint32_t lastExchStats = 0;
+        if (millis() - lastExchStats > 60000) {
+            exchangeSet.printStats(Serial, millis());
+            if (RELAY_ROLE == RELAY_SOURCE) lanRelay.printStats(Serial);
+            if (CAPTURE_MODE) payloadCapture.printStats(Serial);
+            lastExchStats = millis();
+        }
+#if CAPTURE_MODE
+        payloadCapture.poll(Serial);
+#endif
+
+        // 使用者的請求進佇列：重複點同一個週期、或該週期正在抓，都只會合併成一次
+        uint32_t req = fetchRequests.exchange(0);
+        for (int i = 0; i < INTERVAL_COUNT; i++) {
+            if (req & (1u << i)) fetchQueue.enqueue(i, RATE_HIGH, localMs());
+        }
+        runFetchQueue();
+        publishPending();
+        // 串流正常時各週期持續更新不會過期；串流斷線時分層輪詢：
+        // 高頻抓小的 ticker 價格，K線只在跨過邊界或過期時才抓
+        // (K線改由其他交易所提供時，價格也交給各交易所的 worker)
+        if (!stream.connected() && klineSource == EXCHANGE_BINANCE && millis() - lastTicker > TICKER_POLL_MS) {
+            fetchTickerPrice();
+            lastTicker = millis();
+        }
+        prefetchStale();
+        publishPending();
+        // 自選清單的成本固定為一次請求，串流正常與否都照常刷新
+        if (millis() - lastWatchlist > WATCHLIST_POLL_MS) fetchWatchlist();
+        dnsCache.refresh();
+        vTaskDelay(pdMS_TO_TICKS(5));
+    }
+}
+
+void startNetworkTask() {
+    xTaskCreatePinnedToCore(networkTask, "net", NET_TASK_STACK, nullptr, 1, nullptr, NET_TASK_CORE);
+}
+
+bool takeSnapshot(KLineSnapshot& out) {
+    return snapshots.pop(out);
+}
+
+bool takeWatchlist(Watchlist& out) {
+    return watchSnapshots.pop(out);
+}
+
+void requestFetch(int idx) {
+    fetchRequests.fetch_or(1u << idx);
+}
+
+void setViewInterval(int idx) {
+    viewInterval = idx;
+}
+
+bool networkBusy() {
+    return busy || exchangeSet.busy();
+}
+
+uint32_t networkFetchAvgMs() {
+    return fetchAvgMs;
+}
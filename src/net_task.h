@@ -0,0 +1,19 @@
+#pragma once
+
+#include <Arduino.h>
+#include "kline_store.h"
+#include "watchlist.h"
+
+// --- 網路 task (core 0) 與 UI task (core 1) 之間的資料交換 ---
+
+void startNetworkTask();
+
+// 以下由 UI task 呼叫，皆不會阻塞
+bool takeSnapshot(KLineSnapshot& out);
+// 自選清單刷新後的整份紀錄
+bool takeWatchlist(Watchlist& out);
+void requestFetch(int idx);
+void setViewInterval(int idx);
+bool networkBusy();
+// 最近幾次 REST 請求的平均耗時 (ms)，用來比較各省電模式增加的延遲
+uint32_t networkFetchAvgMs();
@@ -0,0 +1,252 @@
+#include "payload_log.h"
+
+#include <string.h>
+#include <unistd.h>
+#include "kline_store.h"
+
+// 從頭走過每筆紀錄的標頭，回傳最後一筆完整紀錄的結尾位置
+static long validLength(FILE* f) {
+    long pos = 0;
+    PayloadRecord rec;
+    fseek(f, 0, SEEK_SET);
+    while (fread(&rec, sizeof(rec), 1, f) == 1) {
+        if (rec.magic != PAYLOAD_MAGIC || rec.bodyLen == PAYLOAD_OPEN) break;
+        long next = pos + (long)sizeof(rec) + rec.hostLen + rec.pathLen + rec.bodyLen;
+        if (fseek(f, next, SEEK_SET) != 0) break;
+        pos = next;
+    }
+    return pos;
+}
+
+bool PayloadWriter::begin(const char* path, const char* oldPath, uint32_t maxBytes, uint32_t now) {
+    end();
+    snprintf(_path, sizeof(_path), "%s", path);
+    snprintf(_oldPath, sizeof(_oldPath), "%s", oldPath);
+    _maxBytes = maxBytes;
+    _start = now;
+    _seq = 0;
+    _session = true;
+    _recordAt = -1;
+    // 要回頭補標頭，不能用 "a" (每次寫入都會移到結尾)
+    _file = fopen(_path, "r+b");
+    if (!_file) _file = fopen(_path, "w+b");
+    if (!_file) {
+        _stats.errors++;
+        return false;
+    }
+    fseek(_file, 0, SEEK_END);
+    long size = ftell(_file);
+    // 上次斷電留下半筆紀錄：整個檔案改為舊檔 (前面完整的部分仍可讀)，從新檔開始
+    if (size > 0 && validLength(_file) != size) return rotate();
+    fseek(_file, 0, SEEK_END);
+    _size = (uint32_t)size;
+    return true;
+}
+
+void PayloadWriter::end() {
+    if (!_file) return;
+    if (_recordAt >= 0) finish(-1);
+    if (_file) fclose(_file);
+    _file = nullptr;
+}
+
+bool PayloadWriter::rotate() {
+    fclose(_file);
+    remove(_oldPath);
+    rename(_path, _oldPath);
+    _file = fopen(_path, "w+b");
+    _size = 0;
+    _stats.rotations++;
+    if (!_file) _stats.errors++;
+    return _file != nullptr;
+}
+
+// 寫入失敗 (通常是空間不足) 後停止記錄，已寫入的紀錄仍可讀
+void PayloadWriter::fail() {
+    _stats.errors++;
+    fclose(_file);
+    _file = nullptr;
+    _recordAt = -1;
+}
+
+bool PayloadWriter::beginRecord(PayloadKind kind, const char* host, const char* path, uint32_t now) {
+    if (!_file) return false;
+    if (_recordAt >= 0) finish(-1);
+    size_t hostLen = strnlen(host, PAYLOAD_HOST_MAX - 1);
+    size_t pathLen = strnlen(path, PAYLOAD_PATH_MAX - 1);
+    uint32_t head = sizeof(PayloadRecord) + hostLen + pathLen;
+    // body 可能讓檔案略超過一半 (最多 PAYLOAD_BODY_MAX)
+    if (_size > 0 && _size + head > _maxBytes / 2 && !rotate()) return false;
+
+    memset(&_rec, 0, sizeof(_rec));
+    _rec.magic = PAYLOAD_MAGIC;
+    _rec.kind = kind;
+    _rec.flags = _session ? PAYLOAD_SESSION : 0;
+    _rec.hostLen = hostLen;
+    _rec.pathLen = pathLen;
+    _rec.tMs = now - _start;
+    _rec.bodyLen = PAYLOAD_OPEN;
+    _rec.usedWeight = -1;
+    _rec.retryAfter = -1;
+    _rec.seq = _seq++;
+    _recordAt = _size;
+    if (fwrite(&_rec, sizeof(_rec), 1, _file) != 1 || fwrite(host, 1, hostLen, _file) != hostLen ||
+        fwrite(path, 1, pathLen, _file) != pathLen) {
+        fail();
+        return false;
+    }
+    _session = false;
+    _rec.bodyLen = 0;
+    _size += head;
+    return true;
+}
+
+void PayloadWriter::append(const uint8_t* data, size_t len) {
+    if (_recordAt < 0) return;
+    size_t room = PAYLOAD_BODY_MAX - _rec.bodyLen;
+    if (len > room) {
+        _rec.flags |= PAYLOAD_TRUNCATED;
+        len = room;
+    }
+    if (!len) return;
+    if (fwrite(data, 1, len, _file) != len) {
+        fail();
+        return;
+    }
+    _rec.bodyLen += len;
+    _size += len;
+}
+
+void PayloadWriter::finish(int httpCode, uint64_t dateMs, int32_t usedWeight, int32_t retryAfter) {
+    if (_recordAt < 0) return;
+    _rec.httpCode = httpCode;
+    _rec.dateMs = dateMs;
+    _rec.usedWeight = usedWeight;
+    _rec.retryAfter = retryAfter;
+    if (_rec.flags & PAYLOAD_TRUNCATED) _stats.truncated++;
+    // 補上標頭裡的長度與回應資訊，之後的寫入接在結尾
+    if (fseek(_file, _recordAt, SEEK_SET) != 0 || fwrite(&_rec, sizeof(_rec), 1, _file) != 1 ||
+        fseek(_file, 0, SEEK_END) != 0) {
+        fail();
+        return;
+    }
+    fflush(_file);
+    _recordAt = -1;
+    _stats.records++;
+    _stats.bytes = _size;
+}
+
+void PayloadWriter::write(PayloadKind kind, const char* host, const char* path, const uint8_t* data, size_t len,
+                          uint32_t now) {
+    if (!beginRecord(kind, host, path, now)) return;
+    append(data, len);
+    finish(0);
+}
+
+void PayloadWriter::flush() {
+    if (!_file) return;
+    fflush(_file);
+    fsync(fileno(_file));
+}
+
+bool PayloadReader::begin(const char* const* paths, int count) {
+    end();
+    _paths = paths;
+    _count = count;
+    _body = new uint8_t[PAYLOAD_BODY_MAX];
+    _stats = {};
+    return rewind();
+}
+
+void PayloadReader::end() {
+    if (_file) fclose(_file);
+    _file = nullptr;
+    delete[] _body;
+    _body = nullptr;
+}
+
+bool PayloadReader::rewind() {
+    _index = -1;
+    return openNext();
+}
+
+bool PayloadReader::openNext() {
+    if (_file) fclose(_file);
+    _file = nullptr;
+    while (++_index < _count) {
+        _file = fopen(_paths[_index], "rb");
+        if (_file) return true;
+    }
+    return false;
+}
+
+bool PayloadReader::next(PayloadEntry& e) {
+    while (_file) {
+        PayloadRecord& r = e.rec;
+        if (fread(&r, sizeof(r), 1, _file) != 1) {
+            openNext();
+            continue;
+        }
+        bool valid = r.magic == PAYLOAD_MAGIC && r.bodyLen != PAYLOAD_OPEN && r.hostLen < PAYLOAD_HOST_MAX &&
+                     r.pathLen < PAYLOAD_PATH_MAX && r.bodyLen <= PAYLOAD_BODY_MAX;
+        if (!valid || fread(e.host, 1, r.hostLen, _file) != r.hostLen ||
+            fread(e.path, 1, r.pathLen, _file) != r.pathLen || fread(_body, 1, r.bodyLen, _file) != r.bodyLen) {
+            _stats.errors++;
+            openNext();
+            continue;
+        }
+        e.host[r.hostLen] = 0;
+        e.path[r.pathLen] = 0;
+        e.body = _body;
+        e.bodyLen = r.bodyLen;
+        _stats.records++;
+        _stats.bytes += sizeof(r) + r.hostLen + r.pathLen + r.bodyLen;
+        if (r.flags & PAYLOAD_TRUNCATED) _stats.truncated++;
+        return true;
+    }
+    return false;
+}
+
+uint32_t ReplayClock::waitMs(uint32_t tMs, uint32_t now) {
+    if (_speed <= 0) return 0;
+    if (!_started || tMs < _last) {
+        _started = true;
+        _base = tMs;
+        _baseAt = now;
+    }
+    _last = tMs;
+    uint32_t due = _baseAt + (uint32_t)((tMs - _base) / _speed);
+    int32_t wait = (int32_t)(due - now);
+    return wait > 0 ? (uint32_t)wait : 0;
+}
+
+static bool startsWith(const char* s, const char* prefix) {
+    return strncmp(s, prefix, strlen(prefix)) == 0;
+}
+
+PayloadRoute payloadRoute(const PayloadEntry& e, int* intervalIdx) {
+    if (e.rec.kind == PAYLOAD_STREAM) return ROUTE_STREAM;
+    const char* p = e.path;
+    if (startsWith(p, "/api/v3/klines?")) {
+        const char* v = strstr(p, "interval=");
+        if (!v) return ROUTE_OTHER;
+        v += 9;
+        size_t len = strcspn(v, "&");
+        for (int i = 0; i < INTERVAL_COUNT; i++) {
+            if (strlen(intervals[i]) == len && strncmp(v, intervals[i], len) == 0) {
+                if (intervalIdx) *intervalIdx = i;
+                return ROUTE_KLINES;
+            }
+        }
+        return ROUTE_OTHER;
+    }
+    if (startsWith(p, "/api/v3/ticker/price")) return ROUTE_TICKER;
+    if (startsWith(p, "/api/v3/ticker/24hr")) return ROUTE_WATCHLIST;
+    if (startsWith(p, "/api/v3/time")) return ROUTE_TIME;
+    return ROUTE_OTHER;
+}
+
+const char* payloadRouteName(PayloadRoute route) {
+    static const char* names[ROUTE_COUNT] = {"klines", "ticker", "watch", "time", "stream", "other"};
+    return route < ROUTE_COUNT ? names[route] : "?";
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// --- 網路 payload 記錄檔：REST 回應與 WebSocket 訊息依收到的順序附上時間寫進檔案 ---
+// 只用 stdio：裝置上 LittleFS 掛載在 VFS (/littlefs/...)，主機上就是一般檔案，
+// 記錄 / 讀取 / 回放的節奏都不依賴 Arduino，主機的 tools/replay_bench.cpp 與裝置共用。
+
+#define PAYLOAD_MAGIC 0x4C50       // "PL"
+#define PAYLOAD_OPEN 0xFFFFFFFFu   // 寫入中 (斷電時留下的半筆紀錄) 的 bodyLen
+#define PAYLOAD_HOST_MAX 64        // 含結尾 0
+#define PAYLOAD_PATH_MAX 512       // 含結尾 0；20 個 symbols 的自選清單約 430 bytes
+#define PAYLOAD_BODY_MAX 8192      // 單筆 body 上限，30 根 K線約 5 KB
+
+enum PayloadKind : uint8_t { PAYLOAD_REST, PAYLOAD_STREAM };
+
+// flags
+#define PAYLOAD_TRUNCATED 0x01     // body 超過 PAYLOAD_BODY_MAX，只留前段
+#define PAYLOAD_SESSION 0x02       // 開機後第一筆，tMs 從這裡重新起算
+
+// 每筆紀錄 = 標頭 + host + path + body (都不含結尾 0)
+struct PayloadRecord {
+    uint16_t magic;
+    uint8_t kind;
+    uint8_t flags;
+    uint16_t hostLen;
+    uint16_t pathLen;
+    uint32_t tMs;          // 從開始記錄起算 (ms)，回放依此控制節奏
+    uint32_t bodyLen;
+    int32_t httpCode;      // REST 的狀態碼 (<0 為傳輸層錯誤，body 為空)；WebSocket 為 0
+    int32_t usedWeight;    // X-MBX-USED-WEIGHT-1m，沒有時為 -1
+    int32_t retryAfter;    // Retry-After (秒)，沒有時為 -1
+    uint32_t seq;          // 本次記錄的流水號
+    uint64_t dateMs;       // 回應的 Date 標頭 (epoch ms)，沒有時為 0
+};
+static_assert(sizeof(PayloadRecord) == 40, "PayloadRecord layout");
+
+struct PayloadStats {
+    uint32_t records;
+    uint32_t bytes;        // 寫入 / 讀取的檔案位元組數
+    uint32_t truncated;
+    uint32_t rotations;
+    uint32_t errors;       // 寫入失敗 (寫入端之後停止記錄) 或讀到損毀的紀錄
+};
+
+// 記錄端：目前的檔案超過上限的一半時改名為舊檔再開新檔，兩個檔案合計不超過 maxBytes，
+// 永遠保留最近一段。一次只寫一筆，必須由同一個 task 呼叫
+class PayloadWriter {
+public:
+    bool begin(const char* path, const char* oldPath, uint32_t maxBytes, uint32_t now);
+    void end();
+    bool active() const { return _file != nullptr; }
+    // 開始一筆 REST 紀錄，body 以 append() 逐段寫入 (已解開 chunked / gzip)，finish() 補上長度與回應資訊
+    bool beginRecord(PayloadKind kind, const char* host, const char* path, uint32_t now);
+    void append(const uint8_t* data, size_t len);
+    void finish(int httpCode, uint64_t dateMs = 0, int32_t usedWeight = -1, int32_t retryAfter = -1);
+    // 整筆一次寫入 (WebSocket 訊息)
+    void write(PayloadKind kind, const char* host, const char* path, const uint8_t* data, size_t len, uint32_t now);
+    // 把緩衝寫進檔案；讀取同一個檔案前呼叫
+    void flush();
+    const PayloadStats& stats() const { return _stats; }
+
+private:
+    bool rotate();
+    void fail();
+
+    FILE* _file = nullptr;
+    char _path[48];
+    char _oldPath[48];
+    uint32_t _maxBytes = 0;
+    uint32_t _start = 0;
+    uint32_t _size = 0;
+    uint32_t _seq = 0;
+    bool _session = false;
+    long _recordAt = -1;   // 寫入中這筆紀錄的標頭位置，沒有時為 -1
+    PayloadRecord _rec;
+    PayloadStats _stats = {};
+};
+
+struct PayloadEntry {
+    PayloadRecord rec;
+    char host[PAYLOAD_HOST_MAX];
+    char path[PAYLOAD_PATH_MAX];
+    const uint8_t* body;   // 指向讀取端的緩衝，下一次 next() 前有效
+    size_t bodyLen;
+};
+
+// 讀取端：依序讀完多個檔案 (先舊後新)，不存在的跳過；
+// 遇到寫到一半或損毀的紀錄就放棄該檔案剩下的部分
+class PayloadReader {
+public:
+    ~PayloadReader() { end(); }
+    bool begin(const char* const* paths, int count);
+    void end();
+    bool next(PayloadEntry& e);
+    // 從第一個檔案重新開始
+    bool rewind();
+    const PayloadStats& stats() const { return _stats; }
+
+private:
+    bool openNext();
+
+    const char* const* _paths = nullptr;
+    int _count = 0;
+    int _index = -1;
+    FILE* _file = nullptr;
+    uint8_t* _body = nullptr;
+    PayloadStats _stats = {};
+};
+
+// 回放節奏：speed 為倍速 (1 為原速)，0 為盡快；時間由呼叫端提供。
+// tMs 往回跳 (下一次開機的紀錄) 時以該筆重新對齊，不等待
+class ReplayClock {
+public:
+    void begin(float speed) { _speed = speed; _started = false; }
+    // 還要等多久才輪到 tMs 這筆
+    uint32_t waitMs(uint32_t tMs, uint32_t now);
+
+private:
+    float _speed = 1;
+    bool _started = false;
+    uint32_t _base = 0;       // 對齊點的 tMs
+    uint32_t _baseAt = 0;     // 對齊點的本地時間
+    uint32_t _last = 0;
+};
+
+// 紀錄要交給哪一段解析流程 (依 Binance 的 REST 路徑判斷)
+enum PayloadRoute : uint8_t {
+    ROUTE_KLINES, ROUTE_TICKER, ROUTE_WATCHLIST, ROUTE_TIME, ROUTE_STREAM, ROUTE_OTHER, ROUTE_COUNT
+};
+// ROUTE_KLINES 時 intervalIdx 為 interval= 參數對應的週期，不認得的週期回傳 ROUTE_OTHER
+PayloadRoute payloadRoute(const PayloadEntry& e, int* intervalIdx);
+const char* payloadRouteName(PayloadRoute route);
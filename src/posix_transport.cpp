@@ -0,0 +1,213 @@
+#ifndef ARDUINO
+
+#include "posix_transport.h"
+
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+PosixTransport::PosixTransport(const char* host, uint16_t port, int timeoutMs) : _port(port), _timeoutMs(timeoutMs) {
+    snprintf(_host, sizeof(_host), "%s", host);
+}
+
+PosixTransport::~PosixTransport() {
+    close();
+}
+
+void PosixTransport::close() {
+    if (_fd >= 0) ::close(_fd);
+    _fd = -1;
+    _pos = _len = 0;
+}
+
+bool PosixTransport::connectSocket() {
+    char port[8];
+    snprintf(port, sizeof(port), "%u", _port);
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo* res = nullptr;
+    if (getaddrinfo(_host, port, &hints, &res) != 0 || !res) {
+        _connectError = CONNECT_DNS;
+        return false;
+    }
+    _fd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+    struct timeval tv;
+    tv.tv_sec = _timeoutMs / 1000;
+    tv.tv_usec = (_timeoutMs % 1000) * 1000;
+    // Linux 的 connect() 也遵守 SO_SNDTIMEO
+    if (_fd >= 0) {
+        setsockopt(_fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        setsockopt(_fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+        int enable = 1;
+        setsockopt(_fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+    }
+    bool ok = _fd >= 0 && ::connect(_fd, res->ai_addr, res->ai_addrlen) == 0;
+    freeaddrinfo(res);
+    if (!ok) {
+        _connectError = CONNECT_TCP;
+        close();
+        return false;
+    }
+    _stats.connects++;
+    return true;
+}
+
+// 回傳讀到的位元組數；0 為對方關閉，<0 為錯誤 / 逾時
+int PosixTransport::fill() {
+    _pos = 0;
+    ssize_t n = recv(_fd, _buf, sizeof(_buf), 0);
+    _len = n > 0 ? n : 0;
+    if (n < 0) return (errno == EAGAIN || errno == EWOULDBLOCK) ? POSIX_ERR_READ_TIMEOUT : POSIX_ERR_CONNECTION_LOST;
+    return (int)n;
+}
+
+// 讀一行 (去掉 CRLF)；回傳長度，<0 為錯誤
+int PosixTransport::readLine(char* buf, size_t len) {
+    size_t n = 0;
+    for (;;) {
+        if (_pos >= _len) {
+            int r = fill();
+            if (r == 0) return POSIX_ERR_CONNECTION_LOST;
+            if (r < 0) return r;
+        }
+        char c = _buf[_pos++];
+        if (c == '\n') break;
+        if (c != '\r' && n + 1 < len) buf[n++] = c;
+    }
+    buf[n] = '\0';
+    return (int)n;
+}
+
+int PosixTransport::readExact(BodySink* sink, long length) {
+    while (length > 0) {
+        if (_pos >= _len) {
+            int r = fill();
+            if (r == 0) return POSIX_ERR_CONNECTION_LOST;
+            if (r < 0) return r;
+        }
+        size_t n = _len - _pos;
+        if ((long)n > length) n = length;
+        if (sink && !sink->write(_buf + _pos, n)) return POSIX_ERR_STREAM_WRITE;
+        _pos += n;
+        length -= n;
+        _stats.bytes += n;
+    }
+    return 0;
+}
+
+int PosixTransport::readBody(BodySink* sink, long length, bool chunked, bool untilClose) {
+    if (chunked) {
+        char line[64];
+        for (;;) {
+            int r = readLine(line, sizeof(line));
+            if (r < 0) return r;
+            char* end;
+            long size = strtol(line, &end, 16);
+            if (end == line || size < 0) return POSIX_ERR_ENCODING;
+            if (size == 0) break;
+            if ((r = readExact(sink, size)) < 0) return r;
+            if ((r = readLine(line, sizeof(line))) != 0) return r < 0 ? r : POSIX_ERR_ENCODING;
+        }
+        // trailer 直到空行
+        for (;;) {
+            int r = readLine(line, sizeof(line));
+            if (r <= 0) return r;
+        }
+    }
+    if (untilClose) {
+        for (;;) {
+            if (_pos < _len) {
+                if (sink && !sink->write(_buf + _pos, _len - _pos)) return POSIX_ERR_STREAM_WRITE;
+                _stats.bytes += _len - _pos;
+                _pos = _len;
+            }
+            int r = fill();
+            if (r == 0) return 0;
+            if (r < 0) return r;
+        }
+    }
+    return readExact(sink, length);
+}
+
+int PosixTransport::request(const char* path, BodySink& sink, bool& retryable) {
+    retryable = true;
+    _connectError = CONNECT_OK;
+    if (_fd < 0 && !connectSocket()) return POSIX_ERR_CONNECT;
+
+    char req[512];
+    int n = snprintf(req, sizeof(req),
+                     "GET %s HTTP/1.1\r\nHost: %s\r\nConnection: keep-alive\r\nAccept-Encoding: identity\r\n"
+                     "User-Agent: ESP32-BTCmonitor-host\r\n\r\n",
+                     path, _host);
+    if (n <= 0 || n >= (int)sizeof(req)) return POSIX_ERR_SEND;
+    if (send(_fd, req, n, MSG_NOSIGNAL) != n) return POSIX_ERR_SEND;
+
+    char line[512];
+    int r = readLine(line, sizeof(line));
+    if (r < 0) return r;
+    int status = 0;
+    if (sscanf(line, "HTTP/1.%*d %d", &status) != 1) return POSIX_ERR_NO_HTTP_SERVER;
+
+    long length = -1;
+    bool chunked = false;
+    bool keepAlive = true;
+    _dateMs = 0;
+    _usedWeight = -1;
+    _retryAfter = -1;
+    for (;;) {
+        if ((r = readLine(line, sizeof(line))) < 0) return r;
+        if (r == 0) break;
+        char* colon = strchr(line, ':');
+        if (!colon) continue;
+        *colon = '\0';
+        const char* value = colon + 1;
+        while (*value == ' ') value++;
+        if (!strcasecmp(line, "Content-Length")) length = atol(value);
+        else if (!strcasecmp(line, "Transfer-Encoding")) chunked = strcasestr(value, "chunked") != nullptr;
+        else if (!strcasecmp(line, "Connection")) keepAlive = strcasecmp(value, "close") != 0;
+        else if (!strcasecmp(line, "Date")) _dateMs = parseHttpDate(value);
+        else if (!strcasecmp(line, "X-MBX-USED-WEIGHT-1m")) _usedWeight = atol(value);
+        else if (!strcasecmp(line, "Retry-After")) _retryAfter = atol(value);
+    }
+
+    // 已開始寫入 sink 就不能重試，否則解析器會收到重複資料
+    retryable = status != 200;
+    bool untilClose = !chunked && length < 0;
+    r = readBody(status == 200 ? &sink : nullptr, length, chunked, untilClose);
+    if (r < 0) return r;
+    if (!keepAlive || untilClose) close();
+    return status;
+}
+
+int PosixTransport::get(const char* path, BodySink& sink) {
+    _stats.requests++;
+    bool reused = _fd >= 0;
+    bool retryable;
+    int status = request(path, sink, retryable);
+    if (status < 0 && reused && retryable) {
+        // 閒置時伺服器可能已關閉連線，重建一次再試
+        _stats.reconnects++;
+        close();
+        reused = false;
+        status = request(path, sink, retryable);
+    }
+    if (status < 0) {
+        _stats.failures++;
+        close();
+        return status;
+    }
+    if (reused) _stats.reuses++;
+    return status;
+}
+
+#endif
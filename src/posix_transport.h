@@ -0,0 +1,62 @@
+#pragma once
+
+// --- 主機端 (Linux) 的 Transport：純 HTTP/1.1 socket，支援 keep-alive 與 chunked ---
+// 只用來對 tools/mock_binance.py 測試 / 壓測 K線流程，裝置上不編譯。
+#ifndef ARDUINO
+
+#include "transport.h"
+
+// 錯誤碼與 HTTPClient 的 HTTPC_ERROR_* 相同，呼叫端可以共用同一套判斷
+#define POSIX_ERR_CONNECT -1
+#define POSIX_ERR_SEND -2
+#define POSIX_ERR_CONNECTION_LOST -5
+#define POSIX_ERR_NO_HTTP_SERVER -7
+#define POSIX_ERR_ENCODING -9
+#define POSIX_ERR_STREAM_WRITE -10
+#define POSIX_ERR_READ_TIMEOUT -11
+
+struct PosixStats {
+    uint32_t requests;
+    uint32_t connects;
+    uint32_t reuses;
+    uint32_t reconnects;
+    uint32_t failures;
+    uint64_t bytes;
+};
+
+class PosixTransport : public Transport {
+public:
+    PosixTransport(const char* host, uint16_t port, int timeoutMs = 5000);
+    ~PosixTransport();
+
+    int get(const char* path, BodySink& sink) override;
+    uint64_t lastDateMs() const override { return _dateMs; }
+    int32_t lastUsedWeight() const override { return _usedWeight; }
+    int32_t lastRetryAfter() const override { return _retryAfter; }
+    ConnectError connectError() const override { return _connectError; }
+    void close();
+    const PosixStats& stats() const { return _stats; }
+
+private:
+    int request(const char* path, BodySink& sink, bool& retryable);
+    bool connectSocket();
+    int fill();
+    int readLine(char* buf, size_t len);
+    int readBody(BodySink* sink, long length, bool chunked, bool untilClose);
+    int readExact(BodySink* sink, long length);
+
+    char _host[64];
+    uint16_t _port;
+    int _timeoutMs;
+    int _fd = -1;
+    uint8_t _buf[4096];
+    size_t _pos = 0;
+    size_t _len = 0;
+    uint64_t _dateMs = 0;
+    int32_t _usedWeight = -1;
+    int32_t _retryAfter = -1;
+    ConnectError _connectError = CONNECT_OK;
+    PosixStats _stats = {};
+};
+
+#endif
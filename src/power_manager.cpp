@@ -0,0 +1,47 @@
+#include "power_manager.h"
+
+#include <WiFi.h>
+#include "net_task.h"
+
+PowerManager powerManager;
+
+void PowerManager::begin(PowerMode mode) {
+    _mode = mode;
+    switch (mode) {
+        case POWER_PERFORMANCE: WiFi.setSleep(WIFI_PS_NONE); break;
+        case POWER_MODEM: WiFi.setSleep(WIFI_PS_MIN_MODEM); break;
+        case POWER_MODEM_MAX: WiFi.setSleep(WIFI_PS_MAX_MODEM); break;
+    }
+    _lastAccount = millis();
+    _lastPrint = millis();
+}
+
+// 每輪累計一次：網路 task 忙碌算收發，其餘算待命
+void PowerManager::account() {
+    uint32_t now = millis();
+    uint32_t dt = now - _lastAccount;
+    _lastAccount = now;
+    if (networkBusy()) _activeMs += dt;
+    else _idleMs += dt;
+}
+
+void PowerManager::idle() {
+    if (millis() - _lastPrint > 60000) {
+        printStats(Serial);
+        _lastPrint = millis();
+    }
+    account();
+    delay(1);
+}
+
+const char* PowerManager::modeName() const {
+    static const char* names[] = {"performance", "modem", "modem-max"};
+    return names[_mode];
+}
+
+void PowerManager::printStats(Print& out) const {
+    uint64_t total = _activeMs + _idleMs;
+    if (!total) total = 1;
+    out.printf("[power] mode=%s active=%.1f%% idle=%.1f%% fetch_avg=%ums\n", modeName(), _activeMs * 100.0f / total,
+               _idleMs * 100.0f / total, networkFetchAvgMs());
+}
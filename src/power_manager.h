@@ -0,0 +1,36 @@
+#pragma once
+
+#include <Arduino.h>
+
+// --- 省電模式：WiFi 的 power save 設定 ---
+// PERFORMANCE：無線電常開，延遲最低
+// MODEM      ：WiFi modem sleep (每個 DTIM 醒來)，即 Arduino 核心本身的預設
+// MODEM_MAX  ：WiFi 依 listen interval 醒來，收包延遲再多幾百 ms
+// CPU 不睡：預編譯的 Arduino 核心沒有開啟 CONFIG_PM_ENABLE / tickless idle，無法自動 light sleep。
+// 這裡不估算電流；[power] 只印出量得到的網路忙碌比例與平均抓取耗時，實測電流時用來對照各模式的延遲
+enum PowerMode : uint8_t { POWER_PERFORMANCE, POWER_MODEM, POWER_MODEM_MAX };
+
+#ifndef POWER_MODE
+#define POWER_MODE POWER_MODEM
+#endif
+
+class PowerManager {
+public:
+    void begin(PowerMode mode);
+    // UI 迴圈每輪呼叫 (取代 delay(1))：累計網路忙碌時間，每分鐘印一次統計
+    void idle();
+    PowerMode mode() const { return _mode; }
+    const char* modeName() const;
+    void printStats(Print& out) const;
+
+private:
+    void account();
+
+    PowerMode _mode = POWER_MODEM;
+    uint32_t _lastAccount = 0;
+    uint64_t _activeMs = 0;      // 網路 task 忙碌 (收發中) 的時間
+    uint64_t _idleMs = 0;        // 其餘時間
+    uint32_t _lastPrint = 0;
+};
+
+extern PowerManager powerManager;
@@ -0,0 +1,65 @@
+#include "rate_budget.h"
+
+void RateBudget::begin(uint64_t now) {
+    _tokens = RATE_DEVICE_WEIGHT;
+    _refilledAt = now;
+    _used = 0;
+    _usedAt = 0;
+    _blockedUntil = 0;
+    _stats = {};
+}
+
+void RateBudget::refill(uint64_t now) {
+    if (now <= _refilledAt) return;
+    _tokens += (float)(now - _refilledAt) * RATE_DEVICE_WEIGHT / RATE_WINDOW_MS;
+    if (_tokens > RATE_DEVICE_WEIGHT) _tokens = RATE_DEVICE_WEIGHT;
+    _refilledAt = now;
+}
+
+int32_t RateBudget::tokens(uint64_t now) {
+    refill(now);
+    return (int32_t)_tokens;
+}
+
+uint32_t RateBudget::usedWeight(uint64_t now) const {
+    // 交易所的視窗是整分鐘，不知道回報時落在視窗哪裡，保守地沿用一整個視窗
+    return now - _usedAt < RATE_WINDOW_MS ? _used : 0;
+}
+
+bool RateBudget::blocked(uint64_t now) const {
+    return now < _blockedUntil || usedWeight(now) * 100 >= (uint32_t)RATE_WEIGHT_LIMIT * RATE_HARD_PCT;
+}
+
+bool RateBudget::allow(RatePriority prio, uint16_t weight, uint64_t now) {
+    refill(now);
+    bool ok = !blocked(now);
+    if (ok && prio == RATE_LOW) {
+        // 低優先請求保留 1/4 預算給使用者操作
+        ok = usedWeight(now) * 100 < (uint32_t)RATE_WEIGHT_LIMIT * RATE_SOFT_PCT &&
+             _tokens >= weight + RATE_DEVICE_WEIGHT / 4;
+    }
+    if (!ok) {
+        _stats.deferred++;
+        return false;
+    }
+    // 高優先請求可以透支，但最多欠一整份預算，之後的低優先請求會延後到補回來
+    _tokens -= weight;
+    if (_tokens < -RATE_DEVICE_WEIGHT) _tokens = -RATE_DEVICE_WEIGHT;
+    _stats.allowed++;
+    return true;
+}
+
+void RateBudget::onResponse(int httpCode, int32_t usedWeight, int32_t retryAfterSec, uint64_t now) {
+    if (usedWeight >= 0) {
+        _used = usedWeight;
+        _usedAt = now;
+    }
+    if (httpCode == 429 || httpCode == 418) {
+        _stats.limited++;
+        uint64_t pause = retryAfterSec > 0 ? (uint64_t)retryAfterSec * 1000
+                                           : (httpCode == 418 ? RATE_418_DEFAULT_MS : RATE_429_DEFAULT_MS);
+        if (now + pause > _blockedUntil) _blockedUntil = now + pause;
+        // 被限流時本機預算也清空，恢復後從低速開始
+        _tokens = 0;
+    }
+}
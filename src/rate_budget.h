@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stdint.h>
+
+// --- Binance 請求權重預算 ---
+// 交易所以 IP 計算每分鐘權重 (同一個 NAT 後面的所有裝置共用)，回應的
+// X-MBX-USED-WEIGHT-1m 是整個 IP 目前已用的量。本機另外以 token bucket 限制自己的用量，
+// 低優先請求 (預抓、ticker、校時) 在接近上限前就先延後；429/418 時依 Retry-After 全部暫停。
+// 純邏輯，時間由呼叫端傳入。
+
+#ifndef RATE_WEIGHT_LIMIT
+#define RATE_WEIGHT_LIMIT 6000       // 交易所每分鐘權重上限 (每個 IP)
+#endif
+#ifndef RATE_DEVICE_WEIGHT
+#define RATE_DEVICE_WEIGHT 300       // 本機每分鐘預算：約 20 台共用一個 IP 時的一份
+#endif
+#define RATE_SOFT_PCT 80             // IP 用量超過這個比例就延後低優先請求
+#define RATE_HARD_PCT 95             // 超過這個比例連使用者觸發的請求也先暫停
+#define RATE_WINDOW_MS 60000
+#define RATE_429_DEFAULT_MS 60000    // 429 沒給 Retry-After 時的暫停時間
+#define RATE_418_DEFAULT_MS 120000   // 418 (已被封鎖) 沒給 Retry-After 時的暫停時間
+
+enum RatePriority : uint8_t { RATE_HIGH, RATE_LOW };
+
+struct RateStats {
+    uint32_t allowed;
+    uint32_t deferred;
+    uint32_t limited;        // 收到 429 / 418 的次數
+};
+
+class RateBudget {
+public:
+    void begin(uint64_t now);
+    // 要送出請求前呼叫：允許就扣掉權重
+    bool allow(RatePriority prio, uint16_t weight, uint64_t now);
+    // 回應後呼叫：usedWeight / retryAfterSec 為 -1 表示標頭不存在
+    void onResponse(int httpCode, int32_t usedWeight, int32_t retryAfterSec, uint64_t now);
+    // Retry-After 暫停中或 IP 用量已達硬上限：所有請求都該等
+    bool blocked(uint64_t now) const;
+    uint32_t blockedForMs(uint64_t now) const { return now < _blockedUntil ? _blockedUntil - now : 0; }
+    // 交易所回報的 IP 用量；超過一個視窗沒有新回報就視為 0
+    uint32_t usedWeight(uint64_t now) const;
+    int32_t tokens(uint64_t now);
+    const RateStats& stats() const { return _stats; }
+
+private:
+    void refill(uint64_t now);
+
+    float _tokens = RATE_DEVICE_WEIGHT;
+    uint64_t _refilledAt = 0;
+    uint32_t _used = 0;
+    uint64_t _usedAt = 0;
+    uint64_t _blockedUntil = 0;
+    RateStats _stats = {};
+};
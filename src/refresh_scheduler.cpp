@@ -0,0 +1,73 @@
+#include "refresh_scheduler.h"
+
+void RefreshScheduler::begin(const uint32_t* periodsSec, int count, uint32_t seed) {
+    _count = count > SCHED_MAX_SERIES ? SCHED_MAX_SERIES : count;
+    for (int i = 0; i < _count; i++) {
+        _periodMs[i] = (uint64_t)periodsSec[i] * 1000;
+        _next[i] = 0;
+        _lastOpen[i] = 0;
+        _lastFetch[i] = 0;
+        _interim[i] = 0;
+        _retry[i] = SCHED_RETRY_MIN_MS;
+    }
+    _rng = seed ? seed : 1;
+    _scheduled = 0;
+}
+
+// xorshift32，每台裝置以不同 seed 產生不同抖動
+uint32_t RefreshScheduler::jitter() {
+    _rng ^= _rng << 13;
+    _rng ^= _rng >> 17;
+    _rng ^= _rng << 5;
+    return _rng % (SCHED_JITTER_MS + 1);
+}
+
+void RefreshScheduler::onRefreshed(int idx, uint64_t lastOpenTime, uint64_t now) {
+    if (idx < 0 || idx >= _count) return;
+    uint64_t boundary = lastOpenTime + _periodMs[idx];
+    _lastFetch[idx] = now;
+    _scheduled++;
+
+    if (now >= boundary) {
+        // 已過收盤但交易所還沒給新 K線：短間隔指數退避重試
+        _next[idx] = now + _retry[idx];
+        _retry[idx] = _retry[idx] * 2 > SCHED_RETRY_MAX_MS ? SCHED_RETRY_MAX_MS : _retry[idx] * 2;
+        return;
+    }
+    _retry[idx] = SCHED_RETRY_MIN_MS;
+
+    // 新的一根：中途刷新間隔從週期的 1/8 開始
+    if (lastOpenTime != _lastOpen[idx]) {
+        _lastOpen[idx] = lastOpenTime;
+        uint64_t first = _periodMs[idx] / 8;
+        _interim[idx] = first < SCHED_INTERIM_MIN_MS ? SCHED_INTERIM_MIN_MS : (uint32_t)first;
+    }
+    uint64_t closeAt = boundary + SCHED_CLOSE_DELAY_MS + jitter();
+    uint64_t interimAt = now + _interim[idx];
+    // 中途刷新間隔每次加倍，越接近收盤越少刷新；超過收盤時間就直接等收盤
+    if (interimAt < boundary) {
+        _next[idx] = interimAt;
+        _interim[idx] *= 2;
+    } else {
+        _next[idx] = closeAt;
+    }
+}
+
+void RefreshScheduler::onFailed(int idx, uint64_t now) {
+    if (idx < 0 || idx >= _count) return;
+    _lastFetch[idx] = now;
+    _next[idx] = now + _retry[idx];
+    _retry[idx] = _retry[idx] * 2 > SCHED_RETRY_MAX_MS ? SCHED_RETRY_MAX_MS : _retry[idx] * 2;
+}
+
+int RefreshScheduler::due(uint64_t now, int viewIdx) const {
+    if (viewIdx >= 0 && viewIdx < _count && _next[viewIdx] <= now) return viewIdx;
+    int pick = -1;
+    for (int i = 0; i < _count; i++) {
+        if (_next[i] > now) continue;
+        // 背景週期不追每一次收盤，最多每 10 分鐘刷新一次
+        if (_lastFetch[i] && now - _lastFetch[i] < SCHED_BACKGROUND_MIN_MS) continue;
+        if (pick < 0 || _next[i] < _next[pick]) pick = i;
+    }
+    return pick;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <stdint.h>
+
+// --- 依 K線邊界排程的 REST 刷新 ---
+// 純邏輯，不呼叫 millis()：所有時間都由呼叫端以交易所時間 (epoch ms) 傳入，
+// 因此可以在主機上用假時鐘驗證排程。
+
+#define SCHED_MAX_SERIES 8
+#define SCHED_CLOSE_DELAY_MS 300     // 收盤後至少等這麼久，讓交易所產生新 K線
+#define SCHED_JITTER_MS 1500         // 再加上 0~1500 ms 的隨機抖動，避免多台同時請求
+#define SCHED_INTERIM_MIN_MS 60000   // 兩次邊界之間的中途刷新最短間隔
+#define SCHED_RETRY_MIN_MS 1000      // 收盤後還拿不到新 K線 / 請求失敗的重試起點
+#define SCHED_RETRY_MAX_MS 60000
+#define SCHED_BACKGROUND_MIN_MS 600000  // 非顯示中的週期兩次刷新至少間隔 10 分鐘
+
+class RefreshScheduler {
+public:
+    void begin(const uint32_t* periodsSec, int count, uint32_t seed);
+    // 成功刷新：lastOpenTime 為序列最後一根的開盤時間
+    void onRefreshed(int idx, uint64_t lastOpenTime, uint64_t now);
+    void onFailed(int idx, uint64_t now);
+    // 回傳已到期的週期 (優先顯示中的 viewIdx，其次最早到期者)，沒有則回傳 -1
+    int due(uint64_t now, int viewIdx) const;
+    uint64_t nextAt(int idx) const { return _next[idx]; }
+    uint32_t scheduled() const { return _scheduled; }
+
+private:
+    uint32_t jitter();
+
+    int _count = 0;
+    uint64_t _periodMs[SCHED_MAX_SERIES];
+    uint64_t _next[SCHED_MAX_SERIES];      // 0 表示立即
+    uint64_t _lastOpen[SCHED_MAX_SERIES];
+    uint64_t _lastFetch[SCHED_MAX_SERIES];
+    uint32_t _interim[SCHED_MAX_SERIES];   // 下一次中途刷新的間隔，每次加倍
+    uint32_t _retry[SCHED_MAX_SERIES];
+    uint32_t _rng = 1;
+    uint32_t _scheduled = 0;
+};
@@ -0,0 +1,309 @@
+#include "relay_proto.h"
+
+#include <string.h>
+
+static void put16(uint8_t* p, uint16_t v) {
+    p[0] = v;
+    p[1] = v >> 8;
+}
+
+static void put32(uint8_t* p, uint32_t v) {
+    for (int i = 0; i < 4; i++) p[i] = v >> (8 * i);
+}
+
+static void putFloat(uint8_t* p, float f) {
+    uint32_t v;
+    memcpy(&v, &f, 4);
+    put32(p, v);
+}
+
+static uint16_t get16(const uint8_t* p) {
+    return p[0] | (p[1] << 8);
+}
+
+static uint32_t get32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static float getFloat(const uint8_t* p) {
+    uint32_t v = get32(p);
+    float f;
+    memcpy(&f, &v, 4);
+    return f;
+}
+
+// 開盤時間以秒傳送 (最短週期 1 分鐘，不會有毫秒)
+static void putCandle(uint8_t* p, const KLine& k) {
+    put32(p, (uint32_t)(k.openTime / 1000));
+    putFloat(p + 4, k.open);
+    putFloat(p + 8, k.high);
+    putFloat(p + 12, k.low);
+    putFloat(p + 16, k.close);
+}
+
+static KLine getCandle(const uint8_t* p) {
+    KLine k;
+    k.openTime = (uint64_t)get32(p) * 1000;
+    k.open = getFloat(p + 4);
+    k.high = getFloat(p + 8);
+    k.low = getFloat(p + 12);
+    k.close = getFloat(p + 16);
+    return k;
+}
+
+// FNV-1a
+static uint32_t hashCandles(const KLine* items, int count) {
+    uint32_t h = 2166136261u;
+    const uint8_t* p = (const uint8_t*)items;
+    for (size_t i = 0; i < count * sizeof(KLine); i++) h = (h ^ p[i]) * 16777619u;
+    return h;
+}
+
+void RelaySender::begin(uint32_t epoch) {
+    _epoch = epoch ? epoch : 1;
+    _seq = 0;
+    memset(_what, 0xFE, sizeof(_what));
+    memset(_repairedAt, 0, sizeof(_repairedAt));
+    memset(_sentHash, 0, sizeof(_sentHash));
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+uint32_t RelaySender::next(uint8_t what) {
+    _seq++;
+    _what[_seq % RELAY_HISTORY] = what;
+    _repairedAt[_seq % RELAY_HISTORY] = 0;
+    return _seq;
+}
+
+size_t RelaySender::header(uint8_t* buf, uint8_t type, uint32_t seq) {
+    put16(buf, RELAY_MAGIC);
+    buf[2] = RELAY_VERSION;
+    buf[3] = type;
+    put32(buf + 4, _epoch);
+    put32(buf + 8, seq);
+    put32(buf + 12, _seq);
+    return RELAY_HEADER;
+}
+
+size_t RelaySender::series(uint8_t* buf, size_t len, uint8_t type, uint32_t seq, int idx, const KLineSeries& s,
+                           float price) {
+    size_t n = RELAY_HEADER + 6 + (size_t)s.count * 20;
+    if (len < n) return 0;
+    uint8_t* p = buf + header(buf, type, seq);
+    p[0] = idx;
+    p[1] = s.count;
+    putFloat(p + 2, price);
+    for (int i = 0; i < s.count; i++) putCandle(p + 6 + i * 20, s.items[i]);
+    _stats.frames++;
+    _stats.bytes += n;
+    return n;
+}
+
+size_t RelaySender::encodeSeries(uint8_t* buf, size_t len, int idx, const KLineSeries& s, float price) {
+    if (len < RELAY_HEADER + 6 + (size_t)s.count * 20) return 0;
+    _sentHash[idx] = hashCandles(s.items, s.count > 0 ? s.count - 1 : 0);
+    return series(buf, len, RELAY_SERIES, next(idx), idx, s, price);
+}
+
+size_t RelaySender::encodeUpdate(uint8_t* buf, size_t len, int idx, const KLineSeries& s, float price) {
+    if (s.count < 2 || hashCandles(s.items, s.count - 1) != _sentHash[idx]) {
+        return encodeSeries(buf, len, idx, s, price);
+    }
+    size_t n = RELAY_HEADER + 25;
+    if (len < n) return 0;
+    uint8_t* p = buf + header(buf, RELAY_CANDLE, next(idx));
+    p[0] = idx;
+    putFloat(p + 1, price);
+    putCandle(p + 5, *s.last());
+    _stats.frames++;
+    _stats.bytes += n;
+    return n;
+}
+
+size_t RelaySender::encodePrice(uint8_t* buf, size_t len, float price) {
+    if (len < RELAY_HEADER + 4) return 0;
+    putFloat(buf + header(buf, RELAY_PRICE, next(0xFF)), price);
+    _stats.frames++;
+    _stats.bytes += RELAY_HEADER + 4;
+    return RELAY_HEADER + 4;
+}
+
+int RelaySender::onNack(const uint8_t* data, size_t len, uint32_t now, uint32_t* seqs, int max, bool& all) {
+    all = false;
+    if (len < RELAY_HEADER + 5 || get16(data) != RELAY_MAGIC || data[2] != RELAY_VERSION ||
+        (data[3] & 0x7F) != RELAY_NACK) {
+        _stats.invalid++;
+        return 0;
+    }
+    _stats.nacks++;
+    uint32_t from = get32(data + RELAY_HEADER);
+    int count = data[RELAY_HEADER + 4];
+    // 上一個 epoch 的 follower 或要求全部重送
+    if (get32(data + 4) != _epoch || count == 0) {
+        all = true;
+        return 0;
+    }
+    if (count > RELAY_NACK_MAX) count = RELAY_NACK_MAX;
+    int n = 0;
+    for (uint32_t seq = from; seq < from + count && n < max; seq++) {
+        if (seq == 0 || seq > _seq) continue;
+        // 已經不在歷史裡，不知道原本是哪個週期，只能全部重送
+        if (_seq - seq >= RELAY_HISTORY) {
+            all = true;
+            continue;
+        }
+        uint32_t& at = _repairedAt[seq % RELAY_HISTORY];
+        if (at && now - at < RELAY_REPAIR_HOLDOFF_MS) continue;
+        at = now | 1;
+        seqs[n++] = seq;
+    }
+    return n;
+}
+
+size_t RelaySender::encodeRepair(uint8_t* buf, size_t len, uint32_t seq, const KLineSeries* s, float price) {
+    uint8_t what = _what[seq % RELAY_HISTORY];
+    size_t n;
+    if (what == 0xFF) {
+        if (len < RELAY_HEADER + 4) return 0;
+        putFloat(buf + header(buf, RELAY_PRICE | RELAY_REPAIR, seq), price);
+        n = RELAY_HEADER + 4;
+        _stats.frames++;
+        _stats.bytes += n;
+    } else if (what < INTERVAL_COUNT) {
+        n = series(buf, len, RELAY_SERIES | RELAY_REPAIR, seq, what, s[what], price);
+    } else {
+        return 0;
+    }
+    if (n) _stats.repairs++;
+    return n;
+}
+
+void RelayReceiver::begin(KLineSeries* series, int count) {
+    _series = series;
+    _count = count;
+    reset();
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+void RelayReceiver::reset() {
+    _epoch = 0;
+    _highest = 0;
+    _missing = 0;
+    memset(_applied, 0, sizeof(_applied));
+    _priceVersion = 0;
+    _full = 0;
+}
+
+void RelayReceiver::track(uint32_t seq, bool repair) {
+    if (_highest == 0) {
+        _highest = seq;
+        return;
+    }
+    if (seq > _highest) {
+        uint32_t d = seq - _highest;
+        _stats.missing += d - 1;
+        if (d >= 64) {
+            _stats.lost += __builtin_popcountll(_missing) + (d - 64);
+            _missing = ~1ULL;
+        } else {
+            _stats.lost += __builtin_popcountll(_missing >> (64 - d));
+            _missing = (_missing << d) | ((1ULL << d) - 2);
+        }
+        _highest = seq;
+    } else if (seq < _highest) {
+        uint32_t i = _highest - seq;
+        if (i < 64 && (_missing >> i) & 1) {
+            _missing &= ~(1ULL << i);
+            if (repair) _stats.repaired++;
+        }
+    }
+}
+
+uint32_t RelayReceiver::onFrame(const uint8_t* data, size_t len) {
+    if (len < RELAY_HEADER || get16(data) != RELAY_MAGIC || data[2] != RELAY_VERSION) {
+        _stats.invalid++;
+        return 0;
+    }
+    uint8_t type = data[3] & 0x7F;
+    if (type == RELAY_NACK) return 0;
+    uint32_t epoch = get32(data + 4);
+    uint32_t seq = get32(data + 8);
+    uint32_t version = get32(data + 12);
+    const uint8_t* p = data + RELAY_HEADER;
+    size_t body = len - RELAY_HEADER;
+    // 先檢查長度，壞掉的 frame 不影響序號追蹤
+    if ((type == RELAY_SERIES && (body < 6 || p[0] >= _count || p[1] > KLINE_COUNT || body < 6u + p[1] * 20)) ||
+        (type == RELAY_CANDLE && (body < 25 || p[0] >= _count)) || (type == RELAY_PRICE && body < 4) ||
+        type < RELAY_SERIES || type > RELAY_PRICE) {
+        _stats.invalid++;
+        return 0;
+    }
+    if (epoch != _epoch) {
+        if (_epoch) _stats.epochs++;
+        reset();
+        _epoch = epoch;
+    }
+    _stats.frames++;
+    _stats.bytes += len;
+    track(seq, data[3] & RELAY_REPAIR);
+
+    uint32_t updated = 0;
+    float price = 0;
+    if (type == RELAY_PRICE) {
+        price = getFloat(p);
+    } else {
+        int idx = p[0];
+        if (version < _applied[idx]) {
+            _stats.stale++;
+            return 0;
+        }
+        _applied[idx] = version;
+        KLineSeries& s = _series[idx];
+        if (type == RELAY_SERIES) {
+            price = getFloat(p + 2);
+            uint32_t refreshedAt = s.refreshedAt;
+            s.clear();
+            s.refreshedAt = refreshedAt;
+            for (int i = 0; i < p[1]; i++) s.merge(getCandle(p + 6 + i * 20));
+            _full |= 1u << idx;
+            updated |= 1u << idx;
+        } else {
+            price = getFloat(p + 1);
+            if (s.merge(getCandle(p + 5))) updated |= 1u << idx;
+        }
+    }
+    if (version >= _priceVersion && price > 0) {
+        _priceVersion = version;
+        if (price != _price) updated |= RELAY_PRICE_BIT;
+        _price = price;
+    }
+    return updated;
+}
+
+size_t RelayReceiver::encodeNack(uint8_t* buf, size_t len) {
+    if (!_epoch || len < RELAY_HEADER + 5) return 0;
+    uint32_t from = 0;
+    int count = 0;
+    if (_full != (1u << _count) - 1) {
+        // 還沒收齊每個週期的完整序列 (剛加入或 relay 重開)，要求全部重送
+    } else if (_missing) {
+        int i = 63 - __builtin_clzll(_missing);
+        from = _highest - i;
+        while (i >= 1 && (_missing >> i) & 1 && count < RELAY_NACK_MAX) {
+            i--;
+            count++;
+        }
+    } else {
+        return 0;
+    }
+    put16(buf, RELAY_MAGIC);
+    buf[2] = RELAY_VERSION;
+    buf[3] = RELAY_NACK;
+    put32(buf + 4, _epoch);
+    put32(buf + 8, 0);
+    put32(buf + 12, 0);
+    put32(buf + RELAY_HEADER, from);
+    buf[RELAY_HEADER + 4] = count;
+    _stats.nacks++;
+    return RELAY_HEADER + 5;
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "kline_store.h"
+
+// --- 區網轉發協定：一台 (relay) 抓資料，以 UDP multicast 把 K線與價格送給其他台 (follower) ---
+// 每個 frame 都是該週期 / 價格的「目前狀態」，可以重送、可以覆蓋，不需要依序套用。
+// 序號只用來偵測遺失：follower 發現缺號時送 NACK，relay 以該序號原本所屬週期的最新狀態重送。
+// 不依賴 Arduino，主機上的 tools/relay_loopback.cpp 與裝置共用。
+//
+// header (16 bytes，little endian)：magic u16 | version u8 | type u8 | epoch u32 | seq u32 | version u32
+//   epoch   relay 開機時隨機產生，換了代表 relay 重開，follower 重設序號
+//   seq     每個新 frame 遞增；重送的 frame 沿用被 NACK 的序號並帶 RELAY_REPAIR 旗標
+//   version 產生內容時 relay 的最新序號，follower 只套用比手上更新的內容
+// RELAY_SERIES  idx u8 | count u8 | price f32 | count × (openTime 秒 u32 | o h l c f32)
+// RELAY_CANDLE  idx u8 | price f32 | openTime 秒 u32 | o h l c f32       (只有最後一根變動時)
+// RELAY_PRICE   price f32                                                 (同時當心跳)
+// RELAY_NACK    from u32 | count u8                                       (count 0 = 要求全部重送)
+
+#define RELAY_MAGIC 0x4B42
+#define RELAY_VERSION 1
+#define RELAY_HEADER 16
+#define RELAY_MAX_FRAME (RELAY_HEADER + 6 + KLINE_COUNT * 20)
+#define RELAY_HISTORY 64           // relay 記得最近幾個序號屬於哪個週期
+#define RELAY_NACK_MAX 16          // 一個 NACK 最多要求幾個序號
+#define RELAY_REPAIR_HOLDOFF_MS 200  // 同一個序號多台同時 NACK 時只重送一次
+
+enum RelayFrameType : uint8_t { RELAY_SERIES = 1, RELAY_CANDLE = 2, RELAY_PRICE = 3, RELAY_NACK = 4 };
+#define RELAY_REPAIR 0x80
+#define RELAY_PRICE_BIT (1u << 31)   // onFrame() 回傳值中代表價格有更新
+
+struct RelayStats {
+    uint32_t frames;        // 收到 / 送出的 frame
+    uint32_t bytes;
+    uint32_t missing;       // 偵測到的缺號
+    uint32_t repaired;      // 由重送補回
+    uint32_t lost;          // 超出追蹤範圍仍未補回
+    uint32_t stale;         // 內容比手上舊，沒套用
+    uint32_t nacks;         // follower：送出 / relay：收到
+    uint32_t repairs;       // relay：重送的 frame
+    uint32_t epochs;        // follower：偵測到 relay 重開
+    uint32_t invalid;
+};
+
+class RelaySender {
+public:
+    void begin(uint32_t epoch);
+    // 依上次送出的內容決定送單根 (RELAY_CANDLE) 或整組 (RELAY_SERIES)，回傳 frame 長度
+    size_t encodeUpdate(uint8_t* buf, size_t len, int idx, const KLineSeries& s, float price);
+    size_t encodeSeries(uint8_t* buf, size_t len, int idx, const KLineSeries& s, float price);
+    size_t encodePrice(uint8_t* buf, size_t len, float price);
+    // 解析 NACK，取出需要重送的序號 (仍在歷史內、最近沒重送過)；all 表示 follower 要求全部重送
+    int onNack(const uint8_t* data, size_t len, uint32_t now, uint32_t* seqs, int max, bool& all);
+    // 以目前狀態重送某個序號
+    size_t encodeRepair(uint8_t* buf, size_t len, uint32_t seq, const KLineSeries* series, float price);
+    const RelayStats& stats() const { return _stats; }
+
+private:
+    size_t header(uint8_t* buf, uint8_t type, uint32_t seq);
+    size_t series(uint8_t* buf, size_t len, uint8_t type, uint32_t seq, int idx, const KLineSeries& s, float price);
+    uint32_t next(uint8_t what);
+
+    uint32_t _epoch = 0;
+    uint32_t _seq = 0;
+    uint8_t _what[RELAY_HISTORY];         // 序號 % RELAY_HISTORY -> 週期 (0xFF 為價格)
+    uint32_t _repairedAt[RELAY_HISTORY];
+    uint32_t _sentHash[INTERVAL_COUNT];   // 上次送出時除了最後一根以外的內容，沒變才能只送單根
+    RelayStats _stats = {};
+};
+
+class RelayReceiver {
+public:
+    void begin(KLineSeries* series, int count);
+    void reset();
+    // 套用一個 frame，回傳有更新的週期位元 (價格為 RELAY_PRICE_BIT)
+    uint32_t onFrame(const uint8_t* data, size_t len);
+    // 有缺號 (或還沒收過完整資料) 時編出 NACK，沒有時回傳 0
+    size_t encodeNack(uint8_t* buf, size_t len);
+    float price() const { return _price; }
+    bool synced() const { return _epoch != 0; }
+    const RelayStats& stats() const { return _stats; }
+
+private:
+    void track(uint32_t seq, bool repair);
+
+    KLineSeries* _series = nullptr;
+    int _count = 0;
+    uint32_t _epoch = 0;
+    uint32_t _highest = 0;
+    uint64_t _missing = 0;        // bit i = 序號 _highest - i 尚未收到
+    uint32_t _applied[INTERVAL_COUNT] = {};
+    uint32_t _priceVersion = 0;
+    uint8_t _full = 0;            // 已收到完整序列的週期位元
+    float _price = 0;
+    RelayStats _stats = {};
+};
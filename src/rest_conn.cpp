@@ -0,0 +1,242 @@
+#include "rest_conn.h"
+
+static int32_t headerInt(const String& value) {
+    return value.length() ? value.toInt() : -1;
+}
+
+// HTTPClient::writeToStream() 只接受 Stream，轉接到 BodySink
+class BodySinkStream : public Stream {
+public:
+    explicit BodySinkStream(BodySink& sink) : _sink(sink) {}
+    size_t write(uint8_t c) override { return _sink.write(&c, 1) ? 1 : 0; }
+    size_t write(const uint8_t* buf, size_t len) override { return _sink.write(buf, len) ? len : 0; }
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+    void flush() override {}
+
+private:
+    BodySink& _sink;
+};
+
+// 反方向：gzip 解壓結果寫回 Stream 型態的 sink，寫入不完整視為拒收
+class StreamBodySink : public BodySink {
+public:
+    explicit StreamBodySink(Stream& out) : _out(out) {}
+    bool write(const uint8_t* data, size_t len) override { return _out.write(data, len) == len; }
+
+private:
+    Stream& _out;
+};
+
+// 記錄模式：寫進 sink 的 body 同時附加到記錄檔
+class CaptureStream : public Stream {
+public:
+    CaptureStream(Stream& sink, PayloadWriter& writer) : _sink(sink), _writer(writer) {}
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* buf, size_t len) override {
+        size_t n = _sink.write(buf, len);
+        _writer.append(buf, n);
+        return n;
+    }
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+    void flush() override {}
+
+private:
+    Stream& _sink;
+    PayloadWriter& _writer;
+};
+
+void RestConn::begin(const char* hosts, uint16_t port, const char* caBundle, const char* caExtra, const char* sessionNs) {
+    _pool.begin(hosts, port);
+    _current = -1;
+    if (_pool.count()) {
+        _host = _pool.at(0).host;
+        _port = _pool.at(0).port;
+    }
+#if TLS_VERIFY
+    _client.setCaBundle(caBundle, caExtra);
+#else
+    _client.setInsecure();
+#endif
+    _client.setSessionNamespace(sessionNs);
+    _client.loadSession();
+    _http.setReuse(true);
+    _http.setTimeout(5000);
+}
+
+int RestConn::request(const String& path, String* body, Stream* sink, bool& retryable) {
+    retryable = true;
+    _client.clearConnectError();
+    if (!_http.begin(_client, _host, _port, path, true)) {
+        return HTTPC_ERROR_CONNECTION_REFUSED;
+    }
+    const char* headerKeys[] = {"Date", "Content-Encoding", "Retry-After", _weightHeader};
+    _http.collectHeaders(headerKeys, _weightHeader ? 4 : 3);
+    // 串流請求才能解 gzip；getString() 的請求維持 HTTPClient 預設的 identity
+    bool wantGzip = sink && _useGzip;
+#if ESP_ARDUINO_VERSION_MAJOR >= 3
+    _http.setAcceptEncoding(wantGzip ? REST_ACCEPT_ENCODING : REST_IDENTITY_ENCODING);
+#else
+    // 2.x 沒有 setAcceptEncoding()，預設那一行照樣送出，這裡再加一行 (begin() 會清掉上次加的標頭)。
+    // 重複的標頭依 RFC 9110 合併成一個清單，實際是否壓縮由伺服器決定，plain= 計數可看出來
+    if (wantGzip) _http.addHeader("Accept-Encoding", REST_ACCEPT_ENCODING);
+#endif
+    int httpCode = _http.GET();
+    _dateMs = httpCode > 0 ? parseHttpDate(_http.header("Date").c_str()) : 0;
+    _usedWeight = httpCode > 0 && _weightHeader ? headerInt(_http.header(_weightHeader)) : -1;
+    _retryAfter = httpCode > 0 ? headerInt(_http.header("Retry-After")) : -1;
+    if (httpCode == HTTP_CODE_OK) {
+        if (sink) {
+            // 已開始寫入 sink 就不能重試，否則解析器會收到重複資料
+            retryable = false;
+            String encoding = _http.header("Content-Encoding");
+            bool gzip = encoding.equalsIgnoreCase("gzip");
+            snprintf(_encoding, sizeof(_encoding), "%s", encoding.length() ? encoding.c_str() : "identity");
+            if (!gzip && _useGzip) _stats.plainResponses++;
+            int n;
+            StreamBodySink out(*sink);
+            if (gzip && _gzip.begin(out)) {
+                // 解壓器拒收時 write() 回傳 0，writeToStream() 以 HTTPC_ERROR_STREAM_WRITE 中止
+                BodySinkStream in(_gzip);
+                n = _http.writeToStream(&in);
+                if (n >= 0 && !_gzip.done()) n = HTTPC_ERROR_ENCODING;
+                _stats.gzipResponses++;
+                _stats.bytesDecoded += _gzip.outputBytes();
+            } else if (gzip) {
+                n = HTTPC_ERROR_TOO_LESS_RAM;
+            } else {
+                n = _http.writeToStream(sink);
+                if (n > 0) _stats.bytesDecoded += n;
+            }
+            if (n < 0) httpCode = n;
+            else _stats.bytes += n;
+        } else {
+            *body = _http.getString();
+            _stats.bytes += body->length();
+            _stats.bytesDecoded += body->length();
+        }
+    }
+    // setReuse(true) 時 end() 只結束這次請求，TLS 連線保留給下一次
+    _http.end();
+    return httpCode;
+}
+
+int RestConn::get(const String& path, String& body) {
+    return get(path, &body, nullptr);
+}
+
+int RestConn::get(const String& path, Stream& sink) {
+    return get(path, nullptr, &sink);
+}
+
+int RestConn::get(const char* path, BodySink& sink) {
+    BodySinkStream stream(sink);
+    return get(String(path), nullptr, &stream);
+}
+
+// 5xx 與連線層錯誤算在端點頭上；4xx 是請求本身的問題，換主機也沒用
+static bool endpointFailed(int httpCode) {
+    return httpCode < 0 || httpCode >= 500;
+}
+
+// 記錄模式時整個請求 (含換端點重送) 記成一筆；失敗的請求也記，回放時可重現錯誤的順序
+int RestConn::get(const String& path, String* body, Stream* sink) {
+    _stats.requests++;
+    bool capture = _capture && _capture->beginRecord(PAYLOAD_REST, _host.c_str(), path.c_str(), millis());
+    if (capture && sink) {
+        CaptureStream tee(*sink, *_capture);
+        int httpCode = fetch(path, body, &tee);
+        _capture->finish(httpCode, _dateMs, _usedWeight, _retryAfter);
+        return httpCode;
+    }
+    int httpCode = fetch(path, body, sink);
+    if (capture) {
+        if (body && httpCode == HTTP_CODE_OK) _capture->append((const uint8_t*)body->c_str(), body->length());
+        _capture->finish(httpCode, _dateMs, _usedWeight, _retryAfter);
+    }
+    return httpCode;
+}
+
+// 選端點，失敗時換一台重送一次
+int RestConn::fetch(const String& path, String* body, Stream* sink) {
+    int ep = _pool.pick(millis(), _current, -1, _client.connected());
+    bool retryable;
+    int httpCode = send(ep, path, body, sink, retryable);
+    if (endpointFailed(httpCode) && retryable && _pool.count() > 1) {
+        _stats.failovers++;
+        ep = _pool.pick(millis(), -1, ep);
+        httpCode = send(ep, path, body, sink, retryable);
+    }
+    if (httpCode < 0) {
+        _stats.failures++;
+        close();
+    }
+    return httpCode;
+}
+
+int RestConn::send(int ep, const String& path, String* body, Stream* sink, bool& retryable) {
+    if (ep >= 0 && ep != _current) {
+        if (_current >= 0) _stats.hostSwitches++;
+        close();
+        _current = ep;
+        _host = _pool.at(ep).host;
+        _port = _pool.at(ep).port;
+    }
+    unsigned long start = millis();
+    bool reused = _client.connected();
+    int httpCode = request(path, body, sink, retryable);
+    if (httpCode < 0 && reused && retryable) {
+        // 閒置時伺服器可能已關閉連線，重建一次再試
+        _stats.reconnects++;
+        close();
+        reused = false;
+        start = millis();
+        httpCode = request(path, body, sink, retryable);
+    }
+    if (endpointFailed(httpCode)) {
+        _pool.onFailure(_current, millis());
+        return httpCode;
+    }
+
+    uint32_t elapsed = millis() - start;
+    // 端點延遲扣掉握手時間，才不會讓剛換過去的主機看起來比較慢
+    uint32_t latency = elapsed;
+    if (reused) {
+        _stats.reuses++;
+        _stats.reuseMsTotal += elapsed;
+    } else {
+        _stats.handshakes++;
+        _stats.handshakeMsTotal += elapsed;
+        uint32_t hs = _client.stats().lastHandshakeMs;
+        latency = elapsed > hs ? elapsed - hs : 0;
+    }
+    _pool.onSuccess(_current, latency, millis());
+    return httpCode;
+}
+
+void RestConn::close() {
+    _http.end();
+    _client.stop();
+}
+
+void RestConn::printStats(Print& out) const {
+    out.printf("[conn] req=%u hs=%u reuse=%u reconn=%u fail=%u failover=%u switch=%u bytes=%u/%u gzip=%u plain=%u enc=%s avg_hs=%ums avg_reuse=%ums\n",
+               _stats.requests, _stats.handshakes, _stats.reuses, _stats.reconnects, _stats.failures,
+               _stats.failovers, _stats.hostSwitches,
+               _stats.bytes, _stats.bytesDecoded, _stats.gzipResponses, _stats.plainResponses,
+               _encoding[0] ? _encoding : "-",
+               _stats.handshakes ? _stats.handshakeMsTotal / _stats.handshakes : 0,
+               _stats.reuses ? _stats.reuseMsTotal / _stats.reuses : 0);
+    // [pool] 每台主機：延遲 EWMA / 錯誤分數，* 為目前連線，! 為斷路器跳脫，? 為半開
+    static const char marks[] = {' ', '!', '?'};
+    out.print("[pool]");
+    for (int i = 0; i < _pool.count(); i++) {
+        const Endpoint& e = _pool.at(i);
+        out.printf(" %c%c%s=%.0fms/%.1f", i == _current ? '*' : ' ', marks[e.state], e.host, e.latencyMs, e.errorScore);
+    }
+    out.println();
+    _client.printStats(out);
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <Arduino.h>
+#include <WiFiClientSecure.h>
+#include <HTTPClient.h>
+#include "tls_session.h"
+#include "gzip_stream.h"
+#include "endpoint_pool.h"
+#include "transport.h"
+#include "payload_log.h"
+
+// 串流請求時要求 gzip 壓縮 (設為 0 可關閉)
+#ifndef REST_GZIP
+#define REST_GZIP 1
+#endif
+// 串流請求的 Accept-Encoding (gzip 優先，伺服器不支援時仍可回未壓縮)
+#define REST_ACCEPT_ENCODING "gzip;q=1.0, identity;q=0.5"
+// HTTPClient 預設的 Accept-Encoding
+#define REST_IDENTITY_ENCODING "identity;q=1,chunked;q=0.1,*;q=0"
+
+// 連線統計：handshakes / reuses 用來確認 keep-alive 的沿用率
+struct ConnStats {
+    uint32_t requests;
+    uint32_t handshakes;     // 需要重新建立 TCP + TLS 的請求
+    uint32_t reuses;         // 沿用既有 keep-alive 連線的請求
+    uint32_t reconnects;     // 沿用失敗後自動重連的次數
+    uint32_t failures;
+    uint32_t handshakeMsTotal;
+    uint32_t reuseMsTotal;
+    uint32_t bytes;          // 收到的 body 位元組總數 (壓縮後，即實際傳輸量)
+    uint32_t bytesDecoded;   // 解壓後的位元組總數
+    uint32_t gzipResponses;
+    uint32_t plainResponses; // 要求 gzip 但伺服器回未壓縮的 body
+    uint32_t failovers;      // 失敗後改用另一個端點重送
+    uint32_t hostSwitches;   // 選路換到不同主機 (需要重新握手)
+};
+
+// 交易所 REST 的長連線管理 (不含任何交易所專屬的邏輯)：保留同一組 WiFiClientSecure/HTTPClient，
+// 跨請求沿用 HTTP/1.1 keep-alive；每個請求由 EndpointPool 挑選目前最好的主機，失敗時換一台重送一次。
+// 實作 Transport 供 K線流程使用。請求權重與 Retry-After 只回報，節流由呼叫端 (Binance 為 net_task 的 RateBudget) 決定
+class RestConn : public Transport {
+public:
+    // caBundle / caExtra 為信任的根憑證 (常數字串，同一組所有連線共用)；sessionNs 為保存 TLS session 的 NVS namespace
+    void begin(const char* hosts, uint16_t port, const char* caBundle, const char* caExtra = nullptr,
+               const char* sessionNs = "tls");
+    // 回報請求權重的回應標頭 (Binance 為 X-MBX-USED-WEIGHT-1m)；nullptr 表示沒有，lastUsedWeight() 一律為 -1
+    void setWeightHeader(const char* name) { _weightHeader = name; }
+    // 串流請求是否要求 gzip (預設 REST_GZIP)；關閉時不會配置解壓視窗
+    void setGzip(bool enable) { _useGzip = enable; }
+    int get(const String& path, String& body);
+    // body 直接寫進 sink (chunked 已解碼)，不在記憶體中組出整份回應
+    int get(const String& path, Stream& sink);
+    int get(const char* path, BodySink& sink) override;
+    void close();
+    bool connected() { return _client.connected(); }
+    const ConnStats& stats() const { return _stats; }
+    const EndpointPool& pool() const { return _pool; }
+    // 下一個請求預計使用的主機 (開機時預先解析 DNS 用)
+    const char* host() const { return _host.c_str(); }
+    uint16_t port() const { return _port; }
+    const TlsStats& tlsStats() const { return _client.stats(); }
+    // 最近一次回應的 Date 標頭 (epoch ms，秒級精度)，沒有時為 0
+    uint64_t lastDateMs() const override { return _dateMs; }
+    // 最近一次回應的請求權重 (setWeightHeader() 指定的標頭) 與 Retry-After (秒)，沒有時為 -1
+    int32_t lastUsedWeight() const override { return _usedWeight; }
+    int32_t lastRetryAfter() const override { return _retryAfter; }
+    // 最近一次請求若在建立連線時失敗，回傳失敗的階段
+    ConnectError connectError() const override { return _client.connectError(); }
+    void printStats(Print& out) const;
+    // 記錄模式：每個請求的狀態碼、回應標頭與 body (已解開 gzip) 寫進 writer；nullptr 關閉
+    void setCapture(PayloadWriter* writer) { _capture = writer; }
+
+private:
+    int get(const String& path, String* body, Stream* sink);
+    int fetch(const String& path, String* body, Stream* sink);
+    int send(int ep, const String& path, String* body, Stream* sink, bool& retryable);
+    int request(const String& path, String* body, Stream* sink, bool& retryable);
+
+    ResumableTlsClient _client;
+    HTTPClient _http;
+    GzipInflater _gzip;
+    String _host;
+    uint16_t _port = 443;
+    EndpointPool _pool;
+    int _current = -1;
+    ConnStats _stats = {};
+    uint64_t _dateMs = 0;
+    const char* _weightHeader = nullptr;
+    bool _useGzip = REST_GZIP;
+    int32_t _usedWeight = -1;
+    int32_t _retryAfter = -1;
+    char _encoding[16] = "";       // 最近一次串流請求回應的 Content-Encoding ("identity" 為未壓縮)
+    PayloadWriter* _capture = nullptr;
+};
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+// 單一生產者 / 單一消費者的固定容量環形佇列，不用鎖，只靠 head/tail 的 acquire/release。
+// 生產者 (網路 task) 只寫 _head，消費者 (UI task) 只寫 _tail；N 必須是 2 的次方。
+template <typename T, size_t N>
+class SpscRing {
+    static_assert((N & (N - 1)) == 0, "N must be a power of two");
+
+public:
+    bool push(const T& v) {
+        uint32_t head = _head.load(std::memory_order_relaxed);
+        uint32_t tail = _tail.load(std::memory_order_acquire);
+        if (head - tail == N) return false;  // 滿了，由生產者決定稍後重送
+        _buf[head & (N - 1)] = v;
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& out) {
+        uint32_t tail = _tail.load(std::memory_order_relaxed);
+        uint32_t head = _head.load(std::memory_order_acquire);
+        if (tail == head) return false;
+        out = _buf[tail & (N - 1)];
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    T _buf[N];
+    std::atomic<uint32_t> _head{0};
+    std::atomic<uint32_t> _tail{0};
+};
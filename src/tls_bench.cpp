@@ -0,0 +1,52 @@
+#include "tls_bench.h"
+
+#include "tls_session.h"
+#include "tls_ca.h"
+
+struct BenchConfig {
+    const char* name;
+    bool verify;
+    int suites;
+    bool resume;
+};
+
+static const BenchConfig CONFIGS[] = {
+    {"insecure/default", false, 0, false},
+    {"verify/default", true, 0, false},
+    {"verify/gcm", true, 1, false},
+    {"verify/ecdsa-gcm", true, 2, false},
+    {"verify/gcm+resume", true, 1, true},
+};
+
+// held 為連線建立後仍佔用的 heap (mbedTLS 緩衝區 + 憑證)，min_free 為開機以來的 heap 最低點
+void runTlsBench(const char* host, uint16_t port, Print& out) {
+    out.printf("[tlsbench] %s:%u rounds=%d\n", host, port, TLS_BENCH_ROUNDS);
+    for (const BenchConfig& cfg : CONFIGS) {
+        ResumableTlsClient client;
+        client.setCaBundle(cfg.verify ? BINANCE_CA_BUNDLE : nullptr);
+        client.setCipherSuites(cfg.suites);
+        client.setSessionReuse(cfg.resume);
+        // 測試用的 session 只留在 RAM，不覆蓋 RestConn 存在 NVS 的那一份
+        client.setSessionNamespace(nullptr);
+
+        uint32_t total = 0, best = UINT32_MAX, worst = 0, held = 0;
+        int ok = 0;
+        for (int i = 0; i < TLS_BENCH_ROUNDS; i++) {
+            uint32_t freeBefore = ESP.getFreeHeap();
+            if (client.connect(host, port)) {
+                uint32_t ms = client.stats().lastHandshakeMs;
+                total += ms;
+                best = min(best, ms);
+                worst = max(worst, ms);
+                held = max(held, freeBefore - ESP.getFreeHeap());
+                ok++;
+            }
+            client.stop();
+            delay(200);
+        }
+        const TlsStats& st = client.stats();
+        out.printf("[tlsbench] %-18s ok=%d/%d avg=%ums min=%ums max=%ums resumed=%u held=%uB min_free=%uB %s\n",
+                   cfg.name, ok, TLS_BENCH_ROUNDS, ok ? total / ok : 0, ok ? best : 0, worst,
+                   st.resumedHandshakes, held, ESP.getMinFreeHeap(), st.lastSuite ? st.lastSuite : "-");
+    }
+}
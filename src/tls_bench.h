@@ -0,0 +1,15 @@
+#pragma once
+
+#include <Arduino.h>
+
+// --- TLS 握手效能測試 (build_flags 加 -D TLS_BENCH=1 才會在開機時執行) ---
+// 依序以不同設定 (是否驗證憑證、加密套件、session 續用) 對同一台主機握手，
+// 回報每種設定的握手時間與 heap 用量。
+#ifndef TLS_BENCH
+#define TLS_BENCH 0
+#endif
+#ifndef TLS_BENCH_ROUNDS
+#define TLS_BENCH_ROUNDS 5
+#endif
+
+void runTlsBench(const char* host, uint16_t port, Print& out);
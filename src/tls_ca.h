@@ -0,0 +1,6 @@
+#pragma once
+
+// --- 釘選的 CA：只信任交易所主機實際使用的根憑證 (PEM，多張串接) ---
+extern const char BINANCE_CA_BUNDLE[];
+// Coinbase / Kraken / OKX 另外需要的根憑證
+extern const char EXCHANGE_CA_BUNDLE[];
@@ -0,0 +1,382 @@
+#include "tls_session.h"
+
+#include <WiFi.h>
+#include <Preferences.h>
+#include <lwip/sockets.h>
+#include <mbedtls/ssl.h>
+#include <mbedtls/net_sockets.h>
+#include "dns_cache.h"
+
+// 解析過的信任鏈依 (pem, extra) 的指標共用：同一組 bundle 只解析一次，所有連線引用同一份，永不釋放。
+// bundle 都是常數字串，指標相同即內容相同
+struct CaChainEntry {
+    const char* pem;
+    const char* extra;
+    mbedtls_x509_crt* chain;
+};
+static CaChainEntry caChains[TLS_CA_CHAINS];
+static portMUX_TYPE caMux = portMUX_INITIALIZER_UNLOCKED;
+
+static mbedtls_x509_crt* findCaChain(const char* pem, const char* extra) {
+    for (const CaChainEntry& e : caChains) {
+        if (e.chain && e.pem == pem && e.extra == extra) return e.chain;
+    }
+    return nullptr;
+}
+
+static mbedtls_x509_crt* parseCaChain(const char* pem, const char* extra) {
+    mbedtls_x509_crt* chain = (mbedtls_x509_crt*)malloc(sizeof(mbedtls_x509_crt));
+    if (!chain) return nullptr;
+    mbedtls_x509_crt_init(chain);
+    // 回傳值 > 0 代表有幾張解析失敗，其餘仍可使用
+    int ret = mbedtls_x509_crt_parse(chain, (const unsigned char*)pem, strlen(pem) + 1);
+    if (ret >= 0 && extra) ret = mbedtls_x509_crt_parse(chain, (const unsigned char*)extra, strlen(extra) + 1);
+    if (ret < 0 || chain->version == 0) {
+        log_e("CA bundle parse failed: -0x%04x", -ret);
+        mbedtls_x509_crt_free(chain);
+        free(chain);
+        return nullptr;
+    }
+    return chain;
+}
+
+// 解析在鎖外進行 (數十 ms)；兩個 task 同時解析同一組時留下先登記的，另一份釋放
+static mbedtls_x509_crt* sharedCaChain(const char* pem, const char* extra) {
+    portENTER_CRITICAL(&caMux);
+    mbedtls_x509_crt* chain = findCaChain(pem, extra);
+    portEXIT_CRITICAL(&caMux);
+    if (chain) return chain;
+
+    mbedtls_x509_crt* parsed = parseCaChain(pem, extra);
+    if (!parsed) return nullptr;
+    bool stored = false;
+    portENTER_CRITICAL(&caMux);
+    chain = findCaChain(pem, extra);
+    for (int i = 0; !chain && i < TLS_CA_CHAINS; i++) {
+        if (caChains[i].chain) continue;
+        caChains[i] = {pem, extra, parsed};
+        chain = parsed;
+        stored = true;
+    }
+    portEXIT_CRITICAL(&caMux);
+    if (!chain) {
+        // 表滿了：這條連線自己保留這一份 (同樣不釋放)
+        log_w("CA chain table full, not shared");
+        return parsed;
+    }
+    if (!stored) {
+        mbedtls_x509_crt_free(parsed);
+        free(parsed);
+    }
+    return chain;
+}
+
+ResumableTlsClient::ResumableTlsClient() {}
+
+ResumableTlsClient::~ResumableTlsClient() {
+    for (TlsSessionSlot& slot : _slots) free(slot.data);
+}
+
+bool ResumableTlsClient::setCaBundle(const char* pem, const char* extra) {
+    _caChain = pem ? sharedCaChain(pem, extra) : nullptr;
+    return !pem || _caChain;
+}
+
+// 全部是 ESP32 AES / SHA 硬體加速的 AES-GCM，AES-128 優先 (握手後的對稱加密較省)
+static const int SUITES_GCM[] = {
+    MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256,
+    MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_256_GCM_SHA384,
+    MBEDTLS_TLS_ECDHE_RSA_WITH_AES_128_GCM_SHA256,
+    MBEDTLS_TLS_ECDHE_RSA_WITH_AES_256_GCM_SHA384,
+    0,
+};
+static const int SUITES_ECDSA_GCM[] = {
+    MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256,
+    MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_256_GCM_SHA384,
+    0,
+};
+// P-256 有 mbedTLS 的 NIST 快速約簡，比其他曲線便宜
+static const mbedtls_ecp_group_id CURVES[] = {
+    MBEDTLS_ECP_DP_SECP256R1,
+    MBEDTLS_ECP_DP_SECP384R1,
+    MBEDTLS_ECP_DP_NONE,
+};
+
+TlsSessionSlot* ResumableTlsClient::findSlot(const char* host) {
+    for (TlsSessionSlot& slot : _slots) {
+        if (slot.len && strcmp(slot.host, host) == 0) return &slot;
+    }
+    return nullptr;
+}
+
+// 內容沒變或記憶體不足時回傳 false；不同主機時換掉空位或最久沒用的那一格
+bool ResumableTlsClient::storeSlot(const char* host, const uint8_t* data, size_t len) {
+    TlsSessionSlot* slot = findSlot(host);
+    if (slot && slot->len == len && memcmp(slot->data, data, len) == 0) {
+        slot->usedAt = millis();
+        return false;
+    }
+    if (!slot) {
+        slot = &_slots[0];
+        for (TlsSessionSlot& s : _slots) {
+            if (!s.len) {
+                slot = &s;
+                break;
+            }
+            if (s.usedAt < slot->usedAt) slot = &s;
+        }
+    }
+    uint8_t* buf = (uint8_t*)realloc(slot->data, len);
+    if (!buf) return false;
+    memcpy(buf, data, len);
+    slot->data = buf;
+    slot->len = len;
+    slot->usedAt = millis();
+    strlcpy(slot->host, host, sizeof(slot->host));
+    return true;
+}
+
+void ResumableTlsClient::dropSlot(const char* host) {
+    TlsSessionSlot* slot = findSlot(host);
+    if (!slot) return;
+    free(slot->data);
+    *slot = TlsSessionSlot();
+    // NVS 中的是同一份時也已失效，下次保存時覆蓋
+    if (_persistedHost == host) _persistedValid = false;
+}
+
+// 從 NVS 讀回上次保存的 session
+void ResumableTlsClient::loadSession() {
+    if (!_nvsNs) return;
+    Preferences prefs;
+    if (!prefs.begin(_nvsNs, true)) return;
+    String host = prefs.getString("host", "");
+    uint8_t* buf = (uint8_t*)malloc(TLS_SESSION_MAX);
+    size_t len = buf && host.length() ? prefs.getBytes("sess", buf, TLS_SESSION_MAX) : 0;
+    prefs.end();
+    if (len && storeSlot(host.c_str(), buf, len)) {
+        _persistedHost = host;
+        _persistedValid = true;
+    }
+    free(buf);
+    Serial.printf("[tls] NVS session %s (%u bytes)\n", len ? host.c_str() : "none", len);
+}
+
+void ResumableTlsClient::clearSession() {
+    for (TlsSessionSlot& slot : _slots) {
+        free(slot.data);
+        slot = TlsSessionSlot();
+    }
+    _persistedHost = "";
+    _persistedValid = false;
+    if (!_nvsNs) return;
+    Preferences prefs;
+    if (prefs.begin(_nvsNs, false)) {
+        prefs.clear();
+        prefs.end();
+    }
+}
+
+int ResumableTlsClient::connect(const char* host, uint16_t port, int32_t timeout) {
+    _connectTimeout = timeout;
+    return connect(host, port);
+}
+
+int ResumableTlsClient::connect(IPAddress ip, uint16_t port) {
+    // 沒有主機名稱就無法比對 session，也沒有 SNI
+    return WiFiClientSecure::connect(ip, port);
+}
+
+// 帶 session 的握手失敗時，只有 TLS 協定層的錯誤可能是 session 造成的；
+// 網路錯誤、逾時 (-1) 與憑證驗證失敗和 session 無關，重試或丟掉 session 都沒有用
+static bool sessionSuspect(int ret) {
+    if (ret == -1 || ret == MBEDTLS_ERR_X509_CERT_VERIFY_FAILED) return false;
+    // MBEDTLS_ERR_NET_* 介於 -0x0042 (SOCKET_FAILED) 與 -0x0052 (UNKNOWN_HOST) 之間
+    bool netError = ret <= MBEDTLS_ERR_NET_SOCKET_FAILED && ret >= MBEDTLS_ERR_NET_UNKNOWN_HOST;
+    return !netError;
+}
+
+int ResumableTlsClient::connect(const char* host, uint16_t port) {
+    // IP 由 DNS 快取提供，主機名稱仍用於 SNI 與 session 比對
+    _connectError = CONNECT_OK;
+    IPAddress ip;
+    if (!dnsCache.resolve(host, ip)) {
+        _connectError = CONNECT_DNS;
+        return 0;
+    }
+
+    const TlsSessionSlot* offer = _reuseSession ? findSlot(host) : nullptr;
+    unsigned long start = millis();
+    int ret = -1;
+    int sock = openSocket(ip, port);
+    if (sock == 0) {
+        ret = handshake(host, offer);
+    }
+    if (sock == 0 && ret != 0 && offer && sessionSuspect(ret)) {
+        // TCP 已連上、帶 session 的握手本身失敗：session 可能已損毀或伺服器處理失敗，
+        // 丟掉這台主機的 session，用完整握手再試一次
+        _stats.fallbacks++;
+        dropSlot(host);
+        sock = openSocket(ip, port);
+        if (sock == 0) {
+            ret = handshake(host, nullptr);
+        }
+    }
+    if (ret != 0) {
+        _connectError = sock != 0 ? CONNECT_TCP : CONNECT_TLS;
+        _lastError = ret;
+        if (ret == MBEDTLS_ERR_X509_CERT_VERIFY_FAILED) {
+            _stats.verifyFailures++;
+            log_e("certificate verify failed: flags=0x%x", mbedtls_ssl_get_verify_result(&sslclient->ssl_ctx));
+        }
+        log_e("handshake failed: -0x%04x", -ret);
+        stop();
+        return 0;
+    }
+    _stats.lastHandshakeMs = millis() - start;
+    _stats.lastSuite = mbedtls_ssl_get_ciphersuite(&sslclient->ssl_ctx);
+
+    // 簡短握手沿用原本的 master secret，完整握手則會產生新的 (session ID 與 ticket 皆適用)
+    const mbedtls_ssl_session* cur = sslclient->ssl_ctx.session;
+    bool resumed = _offered && cur && memcmp(cur->master, _offeredMaster, sizeof(_offeredMaster)) == 0;
+    if (resumed) {
+        _stats.resumedHandshakes++;
+    } else {
+        _stats.fullHandshakes++;
+        if (_offered) {
+            _stats.resumeRejected++;
+            if (_persistedHost == host) _persistedValid = false;
+        }
+    }
+    if (_reuseSession) saveSession(host);
+    _connected = true;
+    return 1;
+}
+
+// 與 ssl_client.cpp 相同：非阻塞 connect + select 逾時，之後切回非阻塞供 mbedTLS 使用
+int ResumableTlsClient::openSocket(IPAddress ip, uint16_t port) {
+    stop();
+    ssl_init(sslclient);
+    mbedtls_entropy_init(&sslclient->entropy_ctx);
+
+    int fd = lwip_socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (fd < 0) return -1;
+    sslclient->socket = fd;
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = (uint32_t)ip;
+    addr.sin_port = htons(port);
+
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    int res = lwip_connect(fd, (struct sockaddr*)&addr, sizeof(addr));
+    if (res < 0 && errno != EINPROGRESS) return -1;
+
+    fd_set fdset;
+    FD_ZERO(&fdset);
+    FD_SET(fd, &fdset);
+    struct timeval tv;
+    tv.tv_sec = _connectTimeout / 1000;
+    tv.tv_usec = (_connectTimeout % 1000) * 1000;
+    if (select(fd + 1, nullptr, &fdset, nullptr, &tv) <= 0) return -1;
+    int sockerr = 0;
+    socklen_t len = sizeof(sockerr);
+    getsockopt(fd, SOL_SOCKET, SO_ERROR, &sockerr, &len);
+    if (sockerr != 0) return -1;
+
+    int enable = 1;
+    lwip_setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+    lwip_setsockopt(fd, SOL_SOCKET, SO_KEEPALIVE, &enable, sizeof(enable));
+    return 0;
+}
+
+int ResumableTlsClient::handshake(const char* host, const TlsSessionSlot* offer) {
+    int ret = mbedtls_ctr_drbg_seed(&sslclient->drbg_ctx, mbedtls_entropy_func, &sslclient->entropy_ctx, nullptr, 0);
+    if (ret != 0) return ret;
+    ret = mbedtls_ssl_config_defaults(&sslclient->ssl_conf, MBEDTLS_SSL_IS_CLIENT,
+                                      MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT);
+    if (ret != 0) return ret;
+    if (_caChain) {
+        // 主機名稱由下面的 mbedtls_ssl_set_hostname() 一併比對
+        mbedtls_ssl_conf_authmode(&sslclient->ssl_conf, MBEDTLS_SSL_VERIFY_REQUIRED);
+        mbedtls_ssl_conf_ca_chain(&sslclient->ssl_conf, _caChain, nullptr);
+    } else {
+        mbedtls_ssl_conf_authmode(&sslclient->ssl_conf, MBEDTLS_SSL_VERIFY_NONE);
+    }
+    if (_suiteProfile > 0) {
+        mbedtls_ssl_conf_ciphersuites(&sslclient->ssl_conf, _suiteProfile == 2 ? SUITES_ECDSA_GCM : SUITES_GCM);
+        mbedtls_ssl_conf_curves(&sslclient->ssl_conf, CURVES);
+    }
+    mbedtls_ssl_conf_rng(&sslclient->ssl_conf, mbedtls_ctr_drbg_random, &sslclient->drbg_ctx);
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+    mbedtls_ssl_conf_session_tickets(&sslclient->ssl_conf, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+#endif
+    if ((ret = mbedtls_ssl_setup(&sslclient->ssl_ctx, &sslclient->ssl_conf)) != 0) return ret;
+    if ((ret = mbedtls_ssl_set_hostname(&sslclient->ssl_ctx, host)) != 0) return ret;
+    mbedtls_ssl_set_bio(&sslclient->ssl_ctx, &sslclient->socket, mbedtls_net_send, mbedtls_net_recv, nullptr);
+
+    _offered = false;
+    if (offer) {
+        mbedtls_ssl_session session;
+        mbedtls_ssl_session_init(&session);
+        if (mbedtls_ssl_session_load(&session, offer->data, offer->len) == 0 &&
+            mbedtls_ssl_set_session(&sslclient->ssl_ctx, &session) == 0) {
+            _stats.resumeOffered++;
+            _offered = true;
+            memcpy(_offeredMaster, session.master, sizeof(_offeredMaster));
+        }
+        mbedtls_ssl_session_free(&session);
+    }
+
+    unsigned long start = millis();
+    while ((ret = mbedtls_ssl_handshake(&sslclient->ssl_ctx)) != 0) {
+        if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) return ret;
+        if (millis() - start > sslclient->handshake_timeout) return -1;
+        vTaskDelay(2);
+    }
+    return 0;
+}
+
+// 握手完成後保存 session 到 RAM，再視需要寫進 NVS (上次因間隔限制沒寫的也在這時補上)
+void ResumableTlsClient::saveSession(const char* host) {
+    mbedtls_ssl_session session;
+    mbedtls_ssl_session_init(&session);
+    if (mbedtls_ssl_get_session(&sslclient->ssl_ctx, &session) == 0) {
+        uint8_t* buf = (uint8_t*)malloc(TLS_SESSION_MAX);
+        size_t len = 0;
+        if (buf && mbedtls_ssl_session_save(&session, buf, TLS_SESSION_MAX, &len) == 0) {
+            storeSlot(host, buf, len);
+            const TlsSessionSlot* slot = findSlot(host);
+            if (slot) persistSession(host, *slot);
+        }
+        free(buf);
+    }
+    mbedtls_ssl_session_free(&session);
+}
+
+// NVS 寫入會磨損 flash：伺服器常常輪換 ticket，同一台主機且 NVS 中的還能用就不寫；
+// 需要寫時，開機後第一次立即寫，之後至少間隔 TLS_SESSION_PERSIST_MS
+void ResumableTlsClient::persistSession(const char* host, const TlsSessionSlot& slot) {
+    if (!_nvsNs || (_persistedValid && _persistedHost == host)) return;
+    uint32_t now = millis();
+    if (_persistedThisBoot && now - _persistedAt < TLS_SESSION_PERSIST_MS) return;
+    Preferences prefs;
+    if (!prefs.begin(_nvsNs, false)) return;
+    prefs.putString("host", host);
+    prefs.putBytes("sess", slot.data, slot.len);
+    prefs.end();
+    _persistedHost = host;
+    _persistedValid = true;
+    _persistedThisBoot = true;
+    _persistedAt = now;
+    _stats.sessionWrites++;
+}
+
+void ResumableTlsClient::printStats(Print& out) const {
+    out.printf("[tls] full=%u resumed=%u offered=%u rejected=%u fallback=%u verify_fail=%u nvs_writes=%u last=%ums %s%s\n",
+               _stats.fullHandshakes, _stats.resumedHandshakes, _stats.resumeOffered,
+               _stats.resumeRejected, _stats.fallbacks, _stats.verifyFailures, _stats.sessionWrites,
+               _stats.lastHandshakeMs,
+               _stats.lastSuite ? _stats.lastSuite : "-", _caChain ? "" : " (unverified)");
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <Arduino.h>
+#include <WiFiClientSecure.h>
+#include "transport.h"
+#include "endpoint_pool.h"
+
+// --- TLS session 續用 (session ID / session ticket)，session 存在 NVS 跨重開機沿用 ---
+// RAM 中依主機各保存一份 (選路換主機時也能走簡短握手)；NVS 只保存一份，且限制寫入頻率：
+// 同一台主機只是換了 ticket 不寫，換主機或 NVS 的 session 已被拒絕時才寫，開機後第一次之外至少間隔 TLS_SESSION_PERSIST_MS。
+#ifndef TLS_SESSION_MAX
+#define TLS_SESSION_MAX 4096
+#endif
+// 每台可能輪到的主機都有一格，選路換回來時才一定走簡短握手 (session 依實際長度配置，沒用到的格子不佔 heap)
+#define TLS_SESSION_SLOTS POOL_MAX_ENDPOINTS
+#define TLS_CA_CHAINS 4                // 共用信任鏈的種類上限 (Binance、Binance + 其他交易所)
+#ifndef TLS_SESSION_PERSIST_MS
+#define TLS_SESSION_PERSIST_MS 1800000
+#endif
+// 以釘選的 CA 驗證伺服器憑證 (連本地自簽的測試伺服器時設為 0)
+#ifndef TLS_VERIFY
+#define TLS_VERIFY 1
+#endif
+// 加密套件：0 = mbedTLS 預設全部，1 = ECDHE + AES-GCM (ECDSA 優先、RSA 相容)，2 = 只用 ECDHE-ECDSA + AES-GCM
+#ifndef TLS_SUITES
+#define TLS_SUITES 1
+#endif
+
+struct TlsStats {
+    uint32_t fullHandshakes;    // 完整握手
+    uint32_t resumedHandshakes; // 簡短握手 (伺服器接受 session)
+    uint32_t resumeOffered;     // 有帶 session 嘗試續用
+    uint32_t resumeRejected;    // 伺服器不接受，改走完整握手
+    uint32_t fallbacks;         // 帶 session 的握手在 TLS 層失敗，清掉 session 後重試 (網路錯誤與憑證失敗不算)
+    uint32_t lastHandshakeMs;
+    const char* lastSuite;      // 最近一次協商出的加密套件
+    uint32_t verifyFailures;    // 憑證驗證失敗
+    uint32_t sessionWrites;     // 寫入 NVS 的次數
+};
+
+struct TlsSessionSlot {
+    char host[64];
+    uint8_t* data;              // mbedtls_ssl_session_save() 序列化結果，依實際長度配置
+    size_t len;
+    uint32_t usedAt;            // millis()，滿了就換掉最久沒用的
+};
+
+// 繼承 WiFiClientSecure，改寫 connect()：握手前套用儲存的 session，握手後保存新 session。
+// 讀寫仍走 WiFiClientSecure 原本的 sslclient，HTTPClient 可直接使用。
+class ResumableTlsClient : public WiFiClientSecure {
+public:
+    ResumableTlsClient();
+    ~ResumableTlsClient();
+
+    int connect(IPAddress ip, uint16_t port) override;
+    int connect(const char* host, uint16_t port) override;
+    int connect(const char* host, uint16_t port, int32_t timeout) override;
+
+    void loadSession();
+    // 清掉 RAM 與 NVS 中的所有 session
+    void clearSession();
+    // 解析 PEM (可多張串接) 作為信任的根憑證，extra 追加在同一條信任鏈；nullptr 表示不驗證。
+    // pem / extra 須為常數字串：同一組只解析一次，所有連線共用
+    bool setCaBundle(const char* pem, const char* extra = nullptr);
+    // 每條連線的 session 存在各自的 NVS namespace (最長 15 字元)，避免互相覆蓋；nullptr 只存在 RAM
+    void setSessionNamespace(const char* ns) { _nvsNs = ns; }
+    void setCipherSuites(int profile) { _suiteProfile = profile; }
+    // 關閉時不帶也不保存 session，每次都是完整握手 (握手效能測試用)
+    void setSessionReuse(bool enable) { _reuseSession = enable; }
+    const TlsStats& stats() const { return _stats; }
+    ConnectError connectError() const { return _connectError; }
+    void clearConnectError() { _connectError = CONNECT_OK; }
+    void printStats(Print& out) const;
+
+private:
+    int openSocket(IPAddress ip, uint16_t port);
+    int handshake(const char* host, const TlsSessionSlot* offer);
+    void saveSession(const char* host);
+    TlsSessionSlot* findSlot(const char* host);
+    bool storeSlot(const char* host, const uint8_t* data, size_t len);
+    void dropSlot(const char* host);
+    void persistSession(const char* host, const TlsSessionSlot& slot);
+
+    const char* _nvsNs = "tls";
+    TlsSessionSlot _slots[TLS_SESSION_SLOTS] = {};
+    String _persistedHost;        // NVS 中 session 的主機
+    bool _persistedValid = false; // NVS 中的 session 還沒被伺服器拒絕
+    bool _persistedThisBoot = false;
+    uint32_t _persistedAt = 0;
+    uint8_t _offeredMaster[48];   // 帶出去的 session master secret，用來判斷是否續用成功
+    bool _offered = false;
+    int32_t _connectTimeout = 5000;
+    mbedtls_x509_crt* _caChain = nullptr;   // 共用的信任鏈，不屬於這條連線，不釋放
+    int _suiteProfile = TLS_SUITES;
+    bool _reuseSession = true;
+    TlsStats _stats = {};
+    ConnectError _connectError = CONNECT_OK;
+};
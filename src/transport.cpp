@@ -0,0 +1,22 @@
+#include "transport.h"
+
+#include <stdio.h>
+#include <string.h>
+
+uint64_t parseHttpDate(const char* date) {
+    static const char* months = "JanFebMarAprMayJunJulAugSepOctNovDec";
+    char mon[4];
+    int d, y, hh, mm, ss;
+    if (!date || sscanf(date, "%*3s, %d %3s %d %d:%d:%d", &d, mon, &y, &hh, &mm, &ss) != 6) return 0;
+    const char* m = strstr(months, mon);
+    if (!m) return 0;
+    int month = (m - months) / 3 + 1;
+    // days_from_civil (Howard Hinnant)
+    y -= month <= 2;
+    int era = y / 400;
+    int yoe = y - era * 400;
+    int doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    int64_t days = (int64_t)era * 146097 + doe - 719468;
+    return (uint64_t)(days * 86400 + hh * 3600 + mm * 60 + ss) * 1000;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// --- REST 傳輸介面 ---
+// K線抓取 / 解析 / 合併的流程只依賴這個介面：裝置上由 RestConn (WiFiClientSecure + HTTPClient)
+// 實作，主機上由 PosixTransport (Linux socket) 實作，可對著 tools/mock_binance.py 跑完整流程。
+
+// 最近一次請求若在建立連線時失敗，失敗在哪個階段
+enum ConnectError : uint8_t { CONNECT_OK, CONNECT_DNS, CONNECT_TCP, CONNECT_TLS };
+
+// 接收 body 的區塊 (chunked / gzip 已解碼)；回傳 false 中止讀取
+class BodySink {
+public:
+    virtual ~BodySink() {}
+    virtual bool write(const uint8_t* data, size_t len) = 0;
+};
+
+class Transport {
+public:
+    virtual ~Transport() {}
+    // 回傳 HTTP 狀態碼，<0 為傳輸層錯誤；只有 200 的 body 會寫進 sink
+    virtual int get(const char* path, BodySink& sink) = 0;
+    // 最近一次回應的 Date 標頭 (epoch ms，秒級精度)，沒有時為 0
+    virtual uint64_t lastDateMs() const = 0;
+    // 最近一次回應的請求權重 (Binance 的 X-MBX-USED-WEIGHT-1m) 與 Retry-After (秒)，沒有時為 -1
+    virtual int32_t lastUsedWeight() const = 0;
+    virtual int32_t lastRetryAfter() const = 0;
+    virtual ConnectError connectError() const = 0;
+};
+
+// "Tue, 15 Nov 2024 08:12:31 GMT" -> epoch ms，格式不符回傳 0
+uint64_t parseHttpDate(const char* date);
@@ -0,0 +1,98 @@
+#include "watchlist.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int Watchlist::begin(const char* list) {
+    count = 0;
+    const char* p = list;
+    while (*p && count < WATCHLIST_MAX) {
+        const char* end = strchr(p, ',');
+        size_t n = end ? (size_t)(end - p) : strlen(p);
+        bool valid = n > 0 && n < WATCHLIST_SYMBOL;
+        for (size_t i = 0; valid && i < n; i++) {
+            valid = (p[i] >= 'A' && p[i] <= 'Z') || (p[i] >= '0' && p[i] <= '9');
+        }
+        if (valid) {
+            TickerRecord& r = items[count++];
+            memset(&r, 0, sizeof(r));
+            memcpy(r.symbol, p, n);
+        }
+        if (!end) break;
+        p = end + 1;
+    }
+    return count;
+}
+
+int Watchlist::find(const char* symbol, int hint) const {
+    if (hint >= 0 && hint < count && strcmp(items[hint].symbol, symbol) == 0) return hint;
+    for (int i = 0; i < count; i++) {
+        if (strcmp(items[i].symbol, symbol) == 0) return i;
+    }
+    return -1;
+}
+
+enum TickerField : int8_t { F_SYMBOL, F_OPEN, F_HIGH, F_LOW, F_LAST, F_QUOTE_VOLUME, F_CLOSE_TIME, F_COUNT };
+
+static const char* const fieldKeys[F_COUNT] = {"symbol", "openPrice", "highPrice", "lowPrice",
+                                               "lastPrice", "quoteVolume", "closeTime"};
+
+void TickerJsonHandler::onBegin(int depth, bool isArray) {
+    if (depth == 2) {
+        memset(&_r, 0, sizeof(_r));
+        _fields = 0;
+    }
+}
+
+void TickerJsonHandler::onKey(int depth, const char* key) {
+    _field = -1;
+    if (depth != 2) return;
+    for (int i = 0; i < F_COUNT; i++) {
+        if (strcmp(key, fieldKeys[i]) == 0) {
+            _field = i;
+            return;
+        }
+    }
+}
+
+void TickerJsonHandler::onValue(int depth, int index, const char* value, bool isString) {
+    if (depth != 2 || _field < 0) return;
+    switch (_field) {
+        case F_SYMBOL:
+            strncpy(_r.symbol, value, WATCHLIST_SYMBOL - 1);
+            break;
+        case F_OPEN: _r.open = strtof(value, nullptr); break;
+        case F_HIGH: _r.high = strtof(value, nullptr); break;
+        case F_LOW: _r.low = strtof(value, nullptr); break;
+        case F_LAST: _r.last = strtof(value, nullptr); break;
+        case F_QUOTE_VOLUME: _r.quoteVolume = strtof(value, nullptr); break;
+        case F_CLOSE_TIME: _r.closeTime = strtoull(value, nullptr, 10); break;
+    }
+    _fields |= 1u << _field;
+    _field = -1;
+}
+
+void TickerJsonHandler::onEnd(int depth, bool isArray) {
+    if (depth != 2 || isArray || _fields != (1u << F_COUNT) - 1) return;
+    int i = _list.find(_r.symbol, _next);
+    if (i < 0) return;
+    _list.items[i] = _r;
+    _next = i + 1;
+    _updated++;
+}
+
+// symbols 的值是 JSON 陣列，方括號與引號要做 URL 編碼
+bool WatchlistFetch::path(char* buf, size_t len) const {
+    size_t n = snprintf(buf, len, "/api/v3/ticker/24hr?type=MINI&symbols=%%5B");
+    for (int i = 0; i < _list.count && n < len; i++) {
+        n += snprintf(buf + n, len - n, "%s%%22%s%%22", i ? "," : "", _list.items[i].symbol);
+    }
+    if (n < len) n += snprintf(buf + n, len - n, "%%5D");
+    return n < len;
+}
+
+bool WatchlistFetch::write(const uint8_t* data, size_t len) {
+    _parser.feed(data, len);
+    return !_parser.error();
+}
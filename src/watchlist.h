@@ -0,0 +1,71 @@
+#pragma once
+
+#include "transport.h"
+#include "json_stream.h"
+
+// --- 自選清單：多個交易對以一次 /api/v3/ticker/24hr?symbols=[...] 批次刷新 ---
+// 1~20 個 symbols 的請求權重與單一 symbol 相同，清單上限設在 20，成本不隨清單長度增加。
+// 不依賴 Arduino，裝置與主機 (tools/bench_watchlist.cpp) 共用。
+
+#define WATCHLIST_MAX 20
+#define WATCHLIST_SYMBOL 12   // 含結尾 0
+
+// 每個交易對只留畫面會用到的欄位，約 40 bytes
+struct TickerRecord {
+    char symbol[WATCHLIST_SYMBOL];
+    float last;
+    float open;
+    float high;
+    float low;
+    float quoteVolume;
+    uint64_t closeTime;   // 0 表示還沒收到資料
+
+    float changePct() const { return open > 0 ? (last - open) / open * 100 : 0; }
+};
+
+struct Watchlist {
+    uint8_t count;
+    TickerRecord items[WATCHLIST_MAX];
+
+    void clear() { count = 0; }
+    // "BTCUSDT,ETHUSDT,..."；只接受大寫英數 (非法的 symbol 會讓整個批次回 400)，超過上限的捨棄。
+    // 回傳收下的數量
+    int begin(const char* list);
+    int find(const char* symbol, int hint = 0) const;
+};
+
+// 回應：[{"symbol":"BTCUSDT","openPrice":"...","lastPrice":"...",...}, ...]
+// 每個物件結束時寫回清單中對應的紀錄，不保留整份回應
+class TickerJsonHandler : public JsonStreamHandler {
+public:
+    explicit TickerJsonHandler(Watchlist& list) : _list(list) {}
+    void onBegin(int depth, bool isArray) override;
+    void onEnd(int depth, bool isArray) override;
+    void onKey(int depth, const char* key) override;
+    void onValue(int depth, int index, const char* value, bool isString) override;
+    int updated() const { return _updated; }
+
+private:
+    Watchlist& _list;
+    TickerRecord _r;
+    int8_t _field = -1;
+    uint8_t _fields = 0;
+    int _next = 0;      // 回應通常依請求順序，先猜下一筆
+    int _updated = 0;
+};
+
+class WatchlistFetch : public BodySink {
+public:
+    explicit WatchlistFetch(Watchlist& list) : _list(list), _handler(list), _parser(_handler) {}
+    // type=MINI 不含 bid/ask 與漲跌欄位，回應約小一半；漲跌幅由開盤價自行計算。
+    // 緩衝區不夠放時回傳 false
+    bool path(char* buf, size_t len) const;
+    bool write(const uint8_t* data, size_t len) override;
+    bool parsed() { return _parser.done(); }
+    int updated() const { return _handler.updated(); }
+
+private:
+    Watchlist& _list;
+    TickerJsonHandler _handler;
+    JsonStreamParser _parser;
+};
@@ -0,0 +1,250 @@
+#include "wifi_manager.h"
+
+#include <Preferences.h>
+#include <esp_wifi.h>
+#include <sys/time.h>
+
+WifiManager wifiManager;
+
+std::atomic<bool> WifiManager::_gotIp{false};
+std::atomic<bool> WifiManager::_lostLink{false};
+std::atomic<uint8_t> WifiManager::_reason{0};
+std::atomic<bool> WifiManager::_leaving{false};
+
+static const uint32_t CACHE_MAGIC = 0x57494649;   // "WIFI"
+static const char* NVS_NS = "wifi";
+
+// NVS 只存 AP 資訊；IP 設定只存在 RTC 記憶體
+struct WifiApCache {
+    uint32_t magic;
+    uint8_t bssid[6];
+    uint8_t channel;
+};
+
+struct WifiCache {
+    WifiApCache ap;
+    uint32_t ip, gateway, subnet, dns;
+    int64_t leasedAt;     // DHCP 取得 IP 時的系統時間 (秒)；0 表示沒有可沿用的 IP
+};
+
+// RTC 記憶體在軟體重啟 / 深度睡眠後仍保留；斷電後只能從 NVS 讀回 AP 資訊
+RTC_DATA_ATTR static WifiCache rtcCache;
+
+// 系統時間在軟體重啟後延續 (IDF 把開機時間存在 RTC)，可用來計算 IP 的年齡；
+// SNTP 校時會讓時間往前跳，只會使 IP 提早過期，不會延長
+static int64_t nowSeconds() {
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    return tv.tv_sec;
+}
+
+static bool staticIpUsable(const WifiCache& c) {
+    if (!c.ip || !c.leasedAt) return false;
+    int64_t age = nowSeconds() - c.leasedAt;
+    return age >= 0 && age < WIFI_STATIC_IP_MAX_AGE_S;
+}
+
+static bool loadCache(WifiCache& c) {
+    if (rtcCache.ap.magic == CACHE_MAGIC) {
+        c = rtcCache;
+        return true;
+    }
+    // 冷開機：只有 AP 資訊，IP 走 DHCP
+    c = WifiCache();
+    Preferences prefs;
+    if (!prefs.begin(NVS_NS, true)) return false;
+    bool ok = prefs.getBytes("ap", &c.ap, sizeof(c.ap)) == sizeof(c.ap) && c.ap.magic == CACHE_MAGIC;
+    prefs.end();
+    if (ok) rtcCache = c;
+    return ok;
+}
+
+void WifiManager::onEvent(arduino_event_id_t event, arduino_event_info_t info) {
+    switch (event) {
+        case ARDUINO_EVENT_WIFI_STA_GOT_IP:
+            _leaving = false;
+            _gotIp = true;
+            break;
+        case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
+            if (info.wifi_sta_disconnected.reason == WIFI_REASON_ASSOC_LEAVE && _leaving.exchange(false)) break;
+            _reason = info.wifi_sta_disconnected.reason;
+            _lostLink = true;
+            break;
+        default:
+            break;
+    }
+}
+
+void WifiManager::begin(const char* ssid, const char* password) {
+    _ssid = ssid;
+    _password = password;
+    WiFi.mode(WIFI_STA);
+    // 重連由狀態機負責，關掉 Arduino 核心的自動重連以免兩邊同時動作
+    WiFi.setAutoReconnect(false);
+    WiFi.persistent(false);
+    WiFi.onEvent(onEvent);
+    _attemptStart = millis();
+    startFast();
+}
+
+void WifiManager::startFast() {
+    WifiCache c;
+    if (!loadCache(c)) {
+        startFull();
+        return;
+    }
+    // 軟體重啟後且還在時效內才沿用上次 DHCP 給的 IP，省掉 DHCP 的來回；否則指定 AP 但照常 DHCP
+    _staticIp = staticIpUsable(c);
+    if (_staticIp) {
+        WiFi.config(IPAddress(c.ip), IPAddress(c.gateway), IPAddress(c.subnet), IPAddress(c.dns));
+    } else {
+        WiFi.config(INADDR_NONE, INADDR_NONE, INADDR_NONE);
+    }
+    WiFi.begin(_ssid, _password, c.ap.channel, c.ap.bssid, true);
+    _state = WIFI_CONNECTING_FAST;
+    _stateSince = millis();
+}
+
+// 主動斷線 (換成完整流程或放棄這次連線)；隨後的斷線事件是自己造成的，不是 AP 或訊號的問題
+void WifiManager::disconnect() {
+    _leaving = true;
+    WiFi.disconnect();
+}
+
+void WifiManager::startFull() {
+    _staticIp = false;
+    disconnect();
+    // 0.0.0.0 代表改回 DHCP
+    WiFi.config(INADDR_NONE, INADDR_NONE, INADDR_NONE);
+    WiFi.begin(_ssid, _password);
+    _state = WIFI_CONNECTING;
+    _stateSince = millis();
+}
+
+void WifiManager::enterBackoff() {
+    disconnect();
+    _state = WIFI_BACKOFF;
+    _stateSince = millis();
+    Serial.printf("[wifi] connect failed, retry in %ums\n", _backoffMs);
+}
+
+void WifiManager::saveCache() {
+    WifiCache c = rtcCache;
+    c.ap.magic = CACHE_MAGIC;
+    memcpy(c.ap.bssid, WiFi.BSSID(), sizeof(c.ap.bssid));
+    c.ap.channel = WiFi.channel();
+    // 只有經過 DHCP 的連線才更新 IP 與取得時間；沿用的 IP 不能延長自己的時效
+    if (!_staticIp) {
+        c.ip = WiFi.localIP();
+        c.gateway = WiFi.gatewayIP();
+        c.subnet = WiFi.subnetMask();
+        c.dns = WiFi.dnsIP(0);
+        c.leasedAt = nowSeconds();
+    }
+    bool apChanged = memcmp(&c.ap, &rtcCache.ap, sizeof(c.ap)) != 0;
+    rtcCache = c;
+    // AP 沒變就不寫 NVS，避免磨損
+    if (!apChanged) return;
+    Preferences prefs;
+    if (prefs.begin(NVS_NS, false)) {
+        prefs.putBytes("ap", &c.ap, sizeof(c.ap));
+        // 舊版連 IP 一起存在 "cache"，清掉以免冷開機時誤用
+        prefs.remove("cache");
+        prefs.end();
+    }
+}
+
+void WifiManager::onConnected() {
+    uint32_t elapsed = millis() - _attemptStart;
+    if (_state == WIFI_CONNECTING_FAST) _stats.fastConnects++;
+    if (_staticIp) _stats.staticIpConnects++;
+    _state = WIFI_CONNECTED;
+    _stateSince = millis();
+    _backoffMs = WIFI_BACKOFF_MIN_MS;
+    _stats.connects++;
+    _stats.lastConnectMs = elapsed;
+    _stats.totalConnectMs += elapsed;
+    saveCache();
+    printStats(Serial);
+}
+
+void WifiManager::recordReason(uint8_t reason) {
+    _stats.lastReason = reason;
+    int slot = -1;
+    for (int i = 0; i < WIFI_REASON_SLOTS; i++) {
+        if (_stats.reasons[i] == reason || _stats.reasons[i] == 0) {
+            slot = i;
+            break;
+        }
+    }
+    if (slot < 0) slot = WIFI_REASON_SLOTS - 1;   // 種類太多時併進最後一格
+    _stats.reasons[slot] = reason;
+    _stats.reasonCounts[slot]++;
+}
+
+void WifiManager::loop() {
+    uint32_t now = millis();
+    if (_gotIp.exchange(false) && (_state == WIFI_CONNECTING_FAST || _state == WIFI_CONNECTING)) {
+        onConnected();
+    }
+    if (_lostLink.exchange(false)) {
+        uint8_t reason = _reason;
+        if (_state == WIFI_CONNECTED) {
+            _stats.disconnects++;
+            recordReason(reason);
+            Serial.printf("[wifi] disconnected reason=%u, reconnecting\n", reason);
+            _attemptStart = now;
+            startFast();
+            return;
+        }
+        if (_state == WIFI_CONNECTING_FAST) {
+            // AP 暫時沒回應或已換頻道：改走完整流程。AP 資訊留著 (連上不同的 AP 時 saveCache() 才覆寫)，
+            // 只有 RTC 中的 IP 不再沿用，下次快速連線走 DHCP
+            recordReason(reason);
+            _stats.fastFailures++;
+            rtcCache.leasedAt = 0;
+            startFull();
+            return;
+        }
+        if (_state == WIFI_CONNECTING) recordReason(reason);
+    }
+
+    switch (_state) {
+        case WIFI_CONNECTING_FAST:
+            if (now - _stateSince > WIFI_FAST_TIMEOUT_MS) {
+                _stats.fastFailures++;
+                rtcCache.leasedAt = 0;
+                startFull();
+            }
+            break;
+        case WIFI_CONNECTING:
+            if (now - _stateSince > WIFI_FULL_TIMEOUT_MS) enterBackoff();
+            break;
+        case WIFI_BACKOFF:
+            if (now - _stateSince > _backoffMs) {
+                _backoffMs = min<uint32_t>(_backoffMs * 2, WIFI_BACKOFF_MAX_MS);
+                _attemptStart = now;
+                startFast();
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+const char* WifiManager::stateName() const {
+    static const char* names[] = {"idle", "fast", "connecting", "ok", "retry"};
+    return names[_state];
+}
+
+void WifiManager::printStats(Print& out) const {
+    out.printf("[wifi] %s connects=%u fast=%u static_ip=%u fast_fail=%u disc=%u last=%ums avg=%ums rssi=%d ch=%u",
+               stateName(), _stats.connects, _stats.fastConnects, _stats.staticIpConnects, _stats.fastFailures,
+               _stats.disconnects,
+               _stats.lastConnectMs, _stats.connects ? _stats.totalConnectMs / _stats.connects : 0,
+               WiFi.RSSI(), WiFi.channel());
+    for (int i = 0; i < WIFI_REASON_SLOTS && _stats.reasons[i]; i++) {
+        out.printf(" r%u=%u", _stats.reasons[i], _stats.reasonCounts[i]);
+    }
+    out.println();
+}
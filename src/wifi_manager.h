@@ -0,0 +1,76 @@
+#pragma once
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <atomic>
+
+// --- 非阻塞 WiFi 連線狀態機 ---
+// 連上後把 BSSID / 頻道存進 RTC 記憶體與 NVS，下次直接指定 AP 與頻道 (免掃描)；
+// DHCP 拿到的 IP 只存在 RTC 記憶體，軟體重啟後 WIFI_STATIC_IP_MAX_AGE_S 內沿用 (免 DHCP)，
+// 冷開機或超過時效一律走 DHCP，避免租約過期後與其他裝置撞 IP。快速連線失敗才退回完整掃描 + DHCP；
+// 快取的 AP 資訊保留，完整掃描連上不同的 AP / 頻道時才覆寫。
+// 斷線後在背景依指數退避自動重連，不會卡住 UI。
+
+#define WIFI_FAST_TIMEOUT_MS 3000    // 快速連線 (指定 BSSID / 頻道 / 靜態 IP) 的等待時間
+#ifndef WIFI_STATIC_IP_MAX_AGE_S
+#define WIFI_STATIC_IP_MAX_AGE_S 1800 // 沿用 IP 的時效，從 DHCP 取得時起算 (遠短於一般的租約)
+#endif
+#define WIFI_FULL_TIMEOUT_MS 15000   // 完整掃描 + DHCP 的等待時間
+#define WIFI_BACKOFF_MIN_MS 1000
+#define WIFI_BACKOFF_MAX_MS 30000
+#define WIFI_REASON_SLOTS 6          // 斷線原因統計保留的種類數
+
+enum WifiState : uint8_t { WIFI_IDLE, WIFI_CONNECTING_FAST, WIFI_CONNECTING, WIFI_CONNECTED, WIFI_BACKOFF };
+
+struct WifiStats {
+    uint32_t connects;
+    uint32_t fastConnects;       // 用快取資訊連上的次數
+    uint32_t staticIpConnects;   // 其中沿用 IP、沒有經過 DHCP 的次數
+    uint32_t fastFailures;       // 快取失效 (AP 換頻道 / IP 被佔用) 改走完整流程
+    uint32_t disconnects;
+    uint32_t lastConnectMs;      // 最近一次從開始連線到拿到 IP 的時間
+    uint32_t totalConnectMs;
+    uint8_t lastReason;          // wifi_err_reason_t
+    uint8_t reasons[WIFI_REASON_SLOTS];
+    uint16_t reasonCounts[WIFI_REASON_SLOTS];
+};
+
+class WifiManager {
+public:
+    void begin(const char* ssid, const char* password);
+    // 由 loop() 週期呼叫，推進狀態機 (不阻塞)
+    void loop();
+    bool connected() const { return _state == WIFI_CONNECTED; }
+    WifiState state() const { return _state; }
+    const char* stateName() const;
+    const WifiStats& stats() const { return _stats; }
+    void printStats(Print& out) const;
+
+private:
+    void startFast();
+    void startFull();
+    void enterBackoff();
+    void disconnect();
+    void onConnected();
+    void saveCache();
+    void recordReason(uint8_t reason);
+    static void onEvent(arduino_event_id_t event, arduino_event_info_t info);
+
+    const char* _ssid = nullptr;
+    const char* _password = nullptr;
+    WifiState _state = WIFI_IDLE;
+    uint32_t _attemptStart = 0;   // 本次連線 (含快速失敗後的完整流程) 的開始時間
+    uint32_t _stateSince = 0;
+    uint32_t _backoffMs = WIFI_BACKOFF_MIN_MS;
+    bool _staticIp = false;       // 這次連線沿用了 RTC 中的 IP
+    WifiStats _stats = {};
+
+    // 事件在 WiFi 事件 task 觸發，只設旗標，由 loop() 處理
+    static std::atomic<bool> _gotIp;
+    static std::atomic<bool> _lostLink;
+    static std::atomic<uint8_t> _reason;
+    // 自己呼叫 WiFi.disconnect() 之後的那一次 ASSOC_LEAVE 斷線事件不算斷線，也不計入原因統計
+    static std::atomic<bool> _leaving;
+};
+
+extern WifiManager wifiManager;
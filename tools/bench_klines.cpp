@@ -0,0 +1,228 @@
+// 在主機上比對 K線回應的兩種解析方式：錄下來的 body 以 JsonStreamParser 逐位元組 (及每 1460 bytes) 餵入，
+// 結果必須與舊的 ArduinoJson 流程 (整份 body 建成 JsonDocument 再逐列合併) 相同，並印出兩者的時間與峰值記憶體。
+// 開盤時間必須完全相同；價格容許差 1 ulp：ArduinoJson 的浮點數解析不是正確捨入，strtof 是，差異的欄位數另外列出。
+// 輸入可以是 payload 記錄檔 (tools/replay_bench.cpp record 或裝置 CAPTURE_MODE 錄的，只取 HTTP 200 的 K線紀錄)，
+// 也可以是直接存下來的原始 body，例如 curl -o 1h.json 'https://api.binance.com/api/v3/klines?symbol=BTCUSDT&interval=1h&limit=500'。
+//
+//   g++ -std=gnu++17 -O2 -Isrc -I.pio/libdeps/esp32dev/ArduinoJson/src -o bench_klines tools/bench_klines.cpp
+//       src/kline_parser.cpp src/json_stream.cpp src/kline_store.cpp src/kline_fetch.cpp src/exchange.cpp
+//       src/payload_log.cpp
+//   ./bench_klines /tmp/capture.bin 1h.json
+#include <ArduinoJson.h>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "kline_fetch.h"
+#include "payload_log.h"
+
+#define ROUNDS 20   // 每份 body 重複解析的次數，計時取平均
+
+static uint64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// 統計 JsonDocument 的峰值配置量
+class CountingAllocator : public ArduinoJson::Allocator {
+public:
+    void* allocate(size_t size) override {
+        size_t* p = (size_t*)malloc(size + sizeof(size_t));
+        *p = size;
+        add(size);
+        return p + 1;
+    }
+    void deallocate(void* ptr) override {
+        if (!ptr) return;
+        size_t* p = (size_t*)ptr - 1;
+        _current -= *p;
+        free(p);
+    }
+    void* reallocate(void* ptr, size_t size) override {
+        size_t* p = (size_t*)ptr - 1;
+        _current -= *p;
+        p = (size_t*)realloc(p, size + sizeof(size_t));
+        *p = size;
+        add(size);
+        return p + 1;
+    }
+    size_t peak() const { return _peak; }
+
+private:
+    void add(size_t size) {
+        _current += size;
+        if (_current > _peak) _peak = _current;
+    }
+    size_t _current = 0;
+    size_t _peak = 0;
+};
+
+struct Body {
+    std::string name;
+    std::string data;
+};
+
+// 舊流程：user-011 之前 net_task 的寫法
+static bool parseDocument(const std::string& body, KLineSeries& series, size_t* peak) {
+    CountingAllocator alloc;
+    {
+        JsonDocument doc(&alloc);
+        if (deserializeJson(doc, body.data(), body.size())) return false;
+        for (JsonVariant row : doc.as<JsonArray>()) {
+            KLine k;
+            k.openTime = row[0].as<uint64_t>();
+            k.open = row[1].as<float>();
+            k.high = row[2].as<float>();
+            k.low = row[3].as<float>();
+            k.close = row[4].as<float>();
+            series.merge(k);
+        }
+    }
+    // 舊流程還有一份 String payload 與整份 body 一樣大
+    *peak = alloc.peak() + body.size();
+    return true;
+}
+
+static bool parseStream(const std::string& body, KLineSeries& series, size_t chunk) {
+    KLineFetch fetch(series);
+    for (size_t off = 0; off < body.size(); off += chunk) {
+        size_t len = body.size() - off < chunk ? body.size() - off : chunk;
+        if (!fetch.write((const uint8_t*)body.data() + off, len)) return false;
+    }
+    return fetch.parsed();
+}
+
+// 兩個同號的 float 相差幾個 ulp
+static uint32_t ulps(float a, float b) {
+    int32_t x, y;
+    memcpy(&x, &a, sizeof(x));
+    memcpy(&y, &b, sizeof(y));
+    return x > y ? (uint32_t)(x - y) : (uint32_t)(y - x);
+}
+
+// 回傳是否相同 (價格差 1 ulp 以內)，相差 1 ulp 的欄位數累加到 ulpFields
+static bool sameSeries(const KLineSeries& a, const KLineSeries& b, int* ulpFields) {
+    if (a.count != b.count) return false;
+    for (int i = 0; i < a.count; i++) {
+        const KLine& x = a.items[i];
+        const KLine& y = b.items[i];
+        const float fx[] = {x.open, x.high, x.low, x.close};
+        const float fy[] = {y.open, y.high, y.low, y.close};
+        uint32_t worst = 0;
+        int diff = 0;
+        for (int f = 0; f < 4; f++) {
+            uint32_t u = ulps(fx[f], fy[f]);
+            if (u > worst) worst = u;
+            if (u) diff++;
+        }
+        *ulpFields += diff;
+        if (x.openTime != y.openTime || worst > 1) {
+            fprintf(stderr, "  row %d: %llu %.8g %.8g %.8g %.8g vs %llu %.8g %.8g %.8g %.8g\n", i,
+                    (unsigned long long)x.openTime, x.open, x.high, x.low, x.close,
+                    (unsigned long long)y.openTime, y.open, y.high, y.low, y.close);
+            return false;
+        }
+    }
+    return true;
+}
+
+static void load(const char* path, std::vector<Body>& out) {
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        fprintf(stderr, "cannot open %s\n", path);
+        return;
+    }
+    uint16_t magic = 0;
+    bool capture = fread(&magic, 1, sizeof(magic), f) == sizeof(magic) && magic == PAYLOAD_MAGIC;
+    if (!capture) {
+        std::string data;
+        rewind(f);
+        char buf[4096];
+        size_t n;
+        while ((n = fread(buf, 1, sizeof(buf), f)) > 0) data.append(buf, n);
+        fclose(f);
+        out.push_back({path, data});
+        return;
+    }
+    fclose(f);
+
+    PayloadReader reader;
+    const char* paths[] = {path};
+    reader.begin(paths, 1);
+    PayloadEntry e;
+    while (reader.next(e)) {
+        if (payloadRoute(e, nullptr) != ROUTE_KLINES || e.rec.httpCode != 200 ||
+            (e.rec.flags & PAYLOAD_TRUNCATED)) continue;
+        char name[PAYLOAD_PATH_MAX + 16];
+        snprintf(name, sizeof(name), "#%u %s", (unsigned)e.rec.seq, e.path);
+        out.push_back({name, std::string((const char*)e.body, e.bodyLen)});
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <capture.bin | body.json>...\n", argv[0]);
+        return 2;
+    }
+    std::vector<Body> bodies;
+    for (int i = 1; i < argc; i++) load(argv[i], bodies);
+    if (bodies.empty()) {
+        fprintf(stderr, "no kline bodies\n");
+        return 1;
+    }
+
+    int mismatches = 0, ulpFields = 0, rows = 0;
+    size_t bytes = 0, docPeak = 0;
+    uint64_t docNs = 0, byteNs = 0, segmentNs = 0;
+    for (const Body& b : bodies) {
+        KLineSeries ref, one, seg;
+        ref.clear();
+        one.clear();
+        seg.clear();
+        size_t peak = 0;
+        bool refOk = parseDocument(b.data, ref, &peak);
+        bool oneOk = parseStream(b.data, one, 1);
+        bool segOk = parseStream(b.data, seg, 1460);
+        int diff = 0;
+        if (!refOk || !oneOk || !segOk || !sameSeries(ref, one, &diff) || !sameSeries(ref, seg, &diff)) {
+            fprintf(stderr, "mismatch %s (document=%d byte=%d segment=%d)\n", b.name.c_str(), refOk, oneOk, segOk);
+            mismatches++;
+            continue;
+        }
+        ulpFields += diff / 2;
+        rows += ref.count;
+        bytes += b.data.size();
+        if (peak > docPeak) docPeak = peak;
+
+        for (int r = 0; r < ROUNDS; r++) {
+            ref.clear();
+            one.clear();
+            seg.clear();
+            uint64_t t0 = nowNs();
+            parseDocument(b.data, ref, &peak);
+            uint64_t t1 = nowNs();
+            parseStream(b.data, one, 1);
+            uint64_t t2 = nowNs();
+            parseStream(b.data, seg, 1460);
+            uint64_t t3 = nowNs();
+            docNs += t1 - t0;
+            byteNs += t2 - t1;
+            segmentNs += t3 - t2;
+        }
+    }
+
+    int matched = (int)bodies.size() - mismatches;
+    printf("bodies=%zu matched=%d bytes=%zu series_rows=%d ulp_fields=%d\n", bodies.size(), matched, bytes, rows,
+           ulpFields);
+    if (matched) {
+        double n = (double)matched * ROUNDS * 1000.0;
+        printf("%-22s %10s %12s\n", "path", "us/body", "peak_bytes");
+        printf("%-22s %10.2f %12zu\n", "JsonDocument", docNs / n, docPeak);
+        printf("%-22s %10.2f %12zu\n", "stream (1 byte)", byteNs / n, sizeof(KLineFetch));
+        printf("%-22s %10.2f %12zu\n", "stream (1460 bytes)", segmentNs / n, sizeof(KLineFetch));
+    }
+    return mismatches ? 1 : 0;
+}
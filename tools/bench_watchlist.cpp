@@ -0,0 +1,76 @@
+// 在主機上量測自選清單 24hr ticker 回應的串流解析時間與 symbol 數量的關係。
+// 回應以 TCP 區段大小 (1460 bytes) 分塊餵入，模擬裝置上從連線讀取的情況。
+//
+//   g++ -std=gnu++17 -O2 -Isrc -o bench_watchlist tools/bench_watchlist.cpp src/watchlist.cpp src/json_stream.cpp
+//   ./bench_watchlist 2000
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+#include "watchlist.h"
+
+static const char* const symbols[] = {
+    "BTCUSDT", "ETHUSDT", "BNBUSDT", "SOLUSDT", "XRPUSDT", "DOGEUSDT", "ADAUSDT", "TRXUSDT", "AVAXUSDT", "LINKUSDT",
+    "DOTUSDT", "MATICUSDT", "LTCUSDT", "BCHUSDT", "UNIUSDT", "ATOMUSDT", "XLMUSDT", "ETCUSDT", "FILUSDT", "NEARUSDT"};
+
+static uint64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// 與 type=MINI 實際回應相同的欄位與數字長度
+static std::string response(int n) {
+    std::string body = "[";
+    char buf[512];
+    for (int i = 0; i < n; i++) {
+        snprintf(buf, sizeof(buf),
+                 "%s{\"symbol\":\"%s\",\"openPrice\":\"%.8f\",\"highPrice\":\"%.8f\",\"lowPrice\":\"%.8f\","
+                 "\"lastPrice\":\"%.8f\",\"volume\":\"%.8f\",\"quoteVolume\":\"%.8f\",\"openTime\":1731571200000,"
+                 "\"closeTime\":1731657599999,\"firstId\":4123456789,\"lastId\":4124456789,\"count\":1000001}",
+                 i ? "," : "", symbols[i], 64000.0 / (i + 1), 65000.0 / (i + 1), 63000.0 / (i + 1),
+                 64500.0 / (i + 1), 12345.6789 * (i + 1), 789012345.678 / (i + 1));
+        body += buf;
+    }
+    return body + "]";
+}
+
+int main(int argc, char** argv) {
+    int rounds = argc > 1 ? atoi(argv[1]) : 2000;
+    const int counts[] = {1, 2, 5, 10, 15, 20};
+    printf("%8s %8s %10s %12s %10s\n", "symbols", "bytes", "parse_us", "us/symbol", "path_len");
+    for (int n : counts) {
+        std::string body = response(n);
+        std::string list;
+        for (int i = 0; i < n; i++) list += std::string(i ? "," : "") + symbols[i];
+        Watchlist watch;
+        watch.begin(list.c_str());
+        char path[WATCHLIST_MAX * (WATCHLIST_SYMBOL + 7) + 48];
+
+        uint64_t total = 0;
+        int updated = 0;
+        for (int r = 0; r < rounds; r++) {
+            WatchlistFetch fetch(watch);
+            fetch.path(path, sizeof(path));
+            uint64_t t0 = nowNs();
+            for (size_t off = 0; off < body.size(); off += 1460) {
+                size_t len = body.size() - off < 1460 ? body.size() - off : 1460;
+                fetch.write((const uint8_t*)body.data() + off, len);
+            }
+            total += nowNs() - t0;
+            if (!fetch.parsed()) {
+                fprintf(stderr, "parse failed at %d symbols\n", n);
+                return 1;
+            }
+            updated = fetch.updated();
+        }
+        if (updated != n) {
+            fprintf(stderr, "updated %d of %d\n", updated, n);
+            return 1;
+        }
+        double us = total / 1000.0 / rounds;
+        printf("%8d %8zu %10.2f %12.2f %10zu\n", n, body.size(), us, us / n, strlen(path));
+    }
+    return 0;
+}
@@ -0,0 +1,67 @@
+#!/usr/bin/env python3
+"""從 Serial monitor 的輸出還原裝置的 payload 記錄檔 (CAPTURE_MODE 下在 Serial 輸入 dump)。
+
+裝置把 LittleFS 上的 capture.old / capture.bin 以 base64 印在
+"[capture] dump <name> <size>" 與 "[capture] dump end <name>" 之間；其他 task 的輸出夾在中間也沒關係。
+
+  pio device monitor | tee monitor.log          # 輸入 dump，等到 [capture] dump end capture.bin
+  python3 tools/capture_pull.py monitor.log data/
+  ./replay_bench replay data/capture.bin 0      # 在主機上回放
+  pio run -t uploadfs                           # 或上傳回裝置，以 REPLAY_MODE 回放
+
+輸出目錄放在專案的 data/ 時，uploadfs 會把檔案放在 LittleFS 根目錄，REPLAY_MODE 直接讀得到。
+"""
+
+import argparse
+import base64
+import os
+import re
+import sys
+
+BEGIN = re.compile(r"\[capture\] dump (\S+) (\d+)\s*$")
+END = re.compile(r"\[capture\] dump end (\S+)\s*$")
+B64 = re.compile(r"^[A-Za-z0-9+/]+={0,2}$")
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("log", help="monitor 的輸出")
+    ap.add_argument("outdir", help="寫出記錄檔的目錄")
+    opts = ap.parse_args()
+
+    os.makedirs(opts.outdir, exist_ok=True)
+    files = {}
+    name = size = None
+    chunks = []
+    for line in open(opts.log, encoding="utf-8", errors="replace"):
+        line = line.strip()
+        m = BEGIN.search(line)
+        if m and not END.search(line):
+            name, size, chunks = m.group(1), int(m.group(2)), []
+            continue
+        if name is None:
+            continue
+        m = END.search(line)
+        if m:
+            data = b"".join(chunks)
+            if len(data) != size:
+                print(f"{name}: got {len(data)} of {size} bytes, skipped", file=sys.stderr)
+            else:
+                files[name] = data   # 同一個檔案 dump 多次時留最後一次
+            name = None
+        elif B64.match(line):
+            chunks.append(base64.b64decode(line))
+
+    if not files:
+        print("no complete dump found", file=sys.stderr)
+        return 1
+    for fname, data in files.items():
+        path = os.path.join(opts.outdir, fname)
+        with open(path, "wb") as f:
+            f.write(data)
+        print(f"{path}: {len(data)} bytes")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
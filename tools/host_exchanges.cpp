@@ -0,0 +1,81 @@
+// 在主機上對 tools/mock_binance.py (或 --replay 回放的錄製回應) 逐一驗證各交易所轉接器：
+// 每個支援的週期抓一次完整 K線與一次增量，檢查排序與筆數，再抓各家 ticker 算出中位數。
+//
+//   g++ -std=gnu++17 -O2 -Isrc -o host_exchanges tools/host_exchanges.cpp src/exchange.cpp src/kline_fetch.cpp
+//       src/kline_parser.cpp src/json_stream.cpp src/kline_store.cpp src/posix_transport.cpp src/transport.cpp
+//   ./host_exchanges 127.0.0.1 8080
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "kline_fetch.h"
+#include "posix_transport.h"
+
+static bool ordered(const KLineSeries& s) {
+    for (int i = 1; i < s.count; i++) {
+        if (s.items[i].openTime <= s.items[i - 1].openTime) return false;
+    }
+    return true;
+}
+
+// 開盤時間必須對齊週期邊界 (抓出秒 / 毫秒換算錯誤)
+static bool aligned(const KLineSeries& s, int idx) {
+    for (int i = 0; i < s.count; i++) {
+        if (s.items[i].openTime % (intervalSeconds[idx] * 1000ULL)) return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    const char* host = argc > 1 ? argv[1] : "127.0.0.1";
+    int port = argc > 2 ? atoi(argv[2]) : 8080;
+    PosixTransport transport(host, port);
+    int failures = 0;
+    std::vector<float> prices;
+
+    for (int ex = 0; ex < EXCHANGE_COUNT; ex++) {
+        const ExchangeAdapter& adapter = *exchanges[ex];
+        for (int idx = 0; idx < INTERVAL_COUNT; idx++) {
+            if (!adapter.supports(idx)) {
+                printf("%-8s %-3s unsupported\n", adapter.name(), intervals[idx]);
+                continue;
+            }
+            KLineSeries s;
+            s.clear();
+            char path[160];
+            int status[2] = {0, 0}, rows[2] = {0, 0};
+            bool parsed = true;
+            // 第二次在序列已滿時發出，支援增量的交易所只會回最後一根之後的資料
+            for (int pass = 0; pass < 2; pass++) {
+                KLineFetch fetch(s, adapter);
+                fetch.path(path, sizeof(path), idx);
+                status[pass] = transport.get(path, fetch);
+                rows[pass] = fetch.rows();
+                parsed = parsed && fetch.parsed();
+            }
+            bool ok = status[0] == 200 && status[1] == 200 && parsed && s.count == KLINE_COUNT && ordered(s) &&
+                      aligned(s, idx);
+            if (!ok) failures++;
+            printf("%-8s %-3s %s http=%d/%d rows=%d/%d count=%d close=%.1f\n", adapter.name(), intervals[idx],
+                   ok ? "ok  " : "FAIL", status[0], status[1], rows[0], rows[1], s.count,
+                   s.last() ? s.last()->close : 0.0f);
+        }
+        char path[96];
+        adapter.tickerPath(path, sizeof(path));
+        TickerFetch ticker(adapter);
+        int status = transport.get(path, ticker);
+        if (status == 200 && ticker.parsed()) prices.push_back(ticker.price());
+        else failures++;
+        printf("%-8s ticker http=%d price=%.2f\n", adapter.name(), status, ticker.price());
+    }
+
+    std::sort(prices.begin(), prices.end());
+    int quoted = prices.size();
+    if (quoted) {
+        float median = quoted % 2 ? prices[quoted / 2] : (prices[quoted / 2 - 1] + prices[quoted / 2]) / 2;
+        printf("quotes=%d median=%.2f spread=%.2f\n", quoted, median, prices[quoted - 1] - prices[0]);
+    }
+    printf("%s (%d failures)\n", failures ? "FAILED" : "PASSED", failures);
+    return failures ? 1 : 0;
+}
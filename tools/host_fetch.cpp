@@ -0,0 +1,73 @@
+// 在主機上對 tools/mock_binance.py 跑完整的 K線抓取 -> 串流解析 -> 合併流程，統計延遲與失敗。
+//
+//   g++ -std=gnu++17 -O2 -Isrc -o host_fetch tools/host_fetch.cpp src/posix_transport.cpp src/transport.cpp
+//       src/kline_fetch.cpp src/exchange.cpp src/kline_parser.cpp src/json_stream.cpp src/kline_store.cpp
+//   ./host_fetch 127.0.0.1 8080 500
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "kline_fetch.h"
+#include "posix_transport.h"
+
+static uint64_t nowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// 序列必須依開盤時間嚴格遞增
+static bool ordered(const KLineSeries& s) {
+    for (int i = 1; i < s.count; i++) {
+        if (s.items[i].openTime <= s.items[i - 1].openTime) return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    const char* host = argc > 1 ? argv[1] : "127.0.0.1";
+    int port = argc > 2 ? atoi(argv[2]) : 8080;
+    int count = argc > 3 ? atoi(argv[3]) : 100;
+
+    PosixTransport transport(host, port);
+    KLineSeries series[INTERVAL_COUNT];
+    for (int i = 0; i < INTERVAL_COUNT; i++) series[i].clear();
+
+    std::vector<uint32_t> latency;
+    int ok = 0, httpErrors = 0, transportErrors = 0, parseErrors = 0, gaps = 0, broken = 0;
+    for (int n = 0; n < count; n++) {
+        int idx = n % INTERVAL_COUNT;
+        KLineSeries& s = series[idx];
+        KLineFetch fetch(s);
+        char path[128];
+        fetch.path(path, sizeof(path), idx);
+        uint64_t start = nowUs();
+        int status = transport.get(path, fetch);
+        latency.push_back((uint32_t)(nowUs() - start));
+        if (status < 0) transportErrors++;
+        else if (status != 200) httpErrors++;
+        else if (!fetch.parsed()) parseErrors++;
+        else ok++;
+        if (status == 200 && fetch.parsed() && fetch.gap()) {
+            gaps++;
+            s.clear();
+        }
+        if (!ordered(s)) broken++;
+    }
+
+    std::sort(latency.begin(), latency.end());
+    auto pct = [&](double p) { return latency.empty() ? 0 : latency[(size_t)(p * (latency.size() - 1))]; };
+    const PosixStats& st = transport.stats();
+    printf("requests=%d ok=%d http=%d transport=%d parse=%d gap=%d unordered=%d\n",
+           count, ok, httpErrors, transportErrors, parseErrors, gaps, broken);
+    printf("latency p50=%.2fms p95=%.2fms max=%.2fms\n", pct(0.5) / 1000.0, pct(0.95) / 1000.0, pct(1.0) / 1000.0);
+    printf("connects=%u reuses=%u reconnects=%u bytes=%llu used_weight=%d\n", st.connects, st.reuses,
+           st.reconnects, (unsigned long long)st.bytes, transport.lastUsedWeight());
+    for (int i = 0; i < INTERVAL_COUNT; i++) {
+        const KLine* k = series[i].last();
+        printf("  %-3s count=%2d last=%llu close=%.2f\n", intervals[i], series[i].count,
+               k ? (unsigned long long)k->openTime : 0ULL, k ? k->close : 0.0f);
+    }
+    return broken ? 1 : 0;
+}
@@ -0,0 +1,153 @@
+// 在主機上驗證 gzip 串流解壓 (src/gzip_stream.cpp)：把錄下來的 gzip K線回應依不同大小分段餵入，
+// 解壓結果必須與 zlib 一次解完的相同，並能由 KLineFetch 解析；再驗證結尾 CRC32 / ISIZE 不符、body 被截斷、
+// 下游中途拒收時都會停下來並回報錯誤。ROM 的 tinfl / crc32_le 以 tools/host_rom 中的 zlib 替身代替。
+//
+//   python3 tools/mock_binance.py --port 8080 --gzip &
+//   curl -s -H 'Accept-Encoding: gzip' -o 1m.gz 'http://127.0.0.1:8080/api/v3/klines?symbol=BTCUSDT&interval=1m&limit=500'
+//   g++ -std=gnu++17 -O2 -Isrc -Itools/host_rom -o host_gzip tools/host_gzip.cpp src/gzip_stream.cpp
+//       src/kline_fetch.cpp src/exchange.cpp src/kline_parser.cpp src/json_stream.cpp src/kline_store.cpp -lz
+//   ./host_gzip 1m.gz
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <zlib.h>
+
+#include "gzip_stream.h"
+#include "kline_fetch.h"
+
+// 收下解壓結果並轉給 K線解析；limit 之後拒收，模擬下游寫入失敗
+class CollectSink : public BodySink {
+public:
+    explicit CollectSink(KLineFetch* fetch = nullptr, size_t limit = SIZE_MAX) : _fetch(fetch), _limit(limit) {}
+    bool write(const uint8_t* data, size_t len) override {
+        if (_rejected) _afterReject++;
+        if (data_.size() + len > _limit) {
+            _rejected = true;
+            return false;
+        }
+        data_.append((const char*)data, len);
+        return !_fetch || _fetch->write(data, len);
+    }
+    std::string data_;
+    int afterReject() const { return _afterReject; }
+
+private:
+    KLineFetch* _fetch;
+    size_t _limit;
+    bool _rejected = false;
+    int _afterReject = 0;   // 拒收之後又被呼叫的次數，應為 0
+};
+
+static bool readFile(const char* path, std::string& out) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return false;
+    char buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) out.append(buf, n);
+    fclose(f);
+    return true;
+}
+
+// zlib 一次解完 (15 + 16：gzip 格式)，作為比對基準
+static bool gunzip(const std::string& in, std::string& out) {
+    z_stream z = {};
+    if (inflateInit2(&z, 15 + 16) != Z_OK) return false;
+    z.next_in = (Bytef*)in.data();
+    z.avail_in = (uInt)in.size();
+    char buf[16384];
+    int r;
+    do {
+        z.next_out = (Bytef*)buf;
+        z.avail_out = sizeof(buf);
+        r = inflate(&z, Z_NO_FLUSH);
+        out.append(buf, sizeof(buf) - z.avail_out);
+    } while (r == Z_OK);
+    inflateEnd(&z);
+    return r == Z_STREAM_END;
+}
+
+// 依 chunk 分段餵入，回傳最後一次 write() 的結果；失敗後不再餵
+static bool feed(GzipInflater& gz, const std::string& body, size_t chunk) {
+    for (size_t off = 0; off < body.size(); off += chunk) {
+        size_t len = body.size() - off < chunk ? body.size() - off : chunk;
+        if (!gz.write((const uint8_t*)body.data() + off, len)) return false;
+    }
+    return true;
+}
+
+static int failures = 0;
+
+static void check(bool ok, const char* name, const char* what) {
+    printf("  %-8s %-34s %s\n", ok ? "ok" : "FAIL", what, name);
+    if (!ok) failures++;
+}
+
+static void testFile(const char* name, const std::string& body) {
+    std::string expect;
+    if (!gunzip(body, expect)) {
+        fprintf(stderr, "%s: not a gzip body\n", name);
+        failures++;
+        return;
+    }
+    printf("%s: %zu -> %zu bytes\n", name, body.size(), expect.size());
+    GzipInflater gz;
+
+    const size_t chunks[] = {1, 7, 256, 1460, body.size()};
+    for (size_t chunk : chunks) {
+        KLineSeries series;
+        series.clear();
+        KLineFetch fetch(series);
+        CollectSink sink(&fetch);
+        gz.begin(sink);
+        bool ok = feed(gz, body, chunk) && gz.done() && sink.data_ == expect && fetch.parsed() && series.count > 0 &&
+                  gz.inputBytes() == body.size() && gz.outputBytes() == expect.size();
+        char what[48];
+        snprintf(what, sizeof(what), "chunk %zu (%d rows)", chunk, fetch.rows());
+        check(ok, name, what);
+    }
+
+    // 結尾 8 bytes：CRC32 + ISIZE
+    std::string bad = body;
+    bad[bad.size() - 8] ^= 0x01;
+    CollectSink crcSink;
+    gz.begin(crcSink);
+    check(!feed(gz, bad, 1460) && gz.error() && crcSink.data_ == expect, name, "crc32 mismatch rejected");
+
+    bad = body;
+    bad[bad.size() - 4] ^= 0x01;
+    CollectSink sizeSink;
+    gz.begin(sizeSink);
+    check(!feed(gz, bad, 1460) && gz.error(), name, "isize mismatch rejected");
+
+    CollectSink cutSink;
+    gz.begin(cutSink);
+    check(feed(gz, body.substr(0, body.size() - 4), 1460) && !gz.done() && !gz.error(), name,
+          "truncated body not done");
+
+    // 下游在一半時拒收：write() 回傳 false，之後不再寫給下游
+    CollectSink rejectSink(nullptr, expect.size() / 2);
+    gz.begin(rejectSink);
+    bool stopped = !feed(gz, body, 64) && gz.error();
+    bool again = gz.write((const uint8_t*)body.data(), body.size());
+    check(stopped && !again && rejectSink.afterReject() == 0 && gz.outputBytes() <= expect.size() / 2, name,
+          "short sink write stops inflating");
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <body.gz>...\n", argv[0]);
+        return 2;
+    }
+    for (int i = 1; i < argc; i++) {
+        std::string body;
+        if (!readFile(argv[i], body)) {
+            fprintf(stderr, "cannot open %s\n", argv[i]);
+            failures++;
+            continue;
+        }
+        testFile(argv[i], body);
+    }
+    printf("%s\n", failures ? "FAILED" : "all ok");
+    return failures ? 1 : 0;
+}
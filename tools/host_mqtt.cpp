@@ -0,0 +1,185 @@
+// 在主機上測試 MQTT 輸入：以最小的 MQTT 3.1.1 client (CONNECT / SUBSCRIBE / PINGREQ，QoS 0) 訂閱
+// tools/mqtt_broker.py 或 mosquitto，訊息交給與裝置相同的 decodeMarketMsg，K線合併進各週期序列。
+// 結束時印出各格式的訊息數、延遲分佈 (發布端的 "E" 到收到) 與各週期最後一根，與 broker 的 feed 輸出比對。
+//
+//   g++ -std=gnu++17 -O2 -Isrc -o host_mqtt tools/host_mqtt.cpp src/market_msg.cpp src/msgpack_parser.cpp
+//       src/json_stream.cpp src/kline_store.cpp
+//   python3 tools/mqtt_broker.py --port 1883 --feed --rate 0.1 --duration 15 &
+//   ./host_mqtt 127.0.0.1 1883 'market/BTCUSDT/#' 16
+#include <algorithm>
+#include <arpa/inet.h>
+#include <chrono>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+#include "market_msg.h"
+
+#define KEEPALIVE_S 15
+
+static uint64_t epochMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+static uint64_t nowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+class SeriesSink : public MarketMsgSink {
+public:
+    KLineSeries series[INTERVAL_COUNT];
+    float price = 0;
+    uint32_t merged = 0;
+
+    SeriesSink() {
+        for (auto& s : series) s.clear();
+    }
+    void onKLine(const char* interval, const KLine& k, bool closed) override {
+        for (int i = 0; i < INTERVAL_COUNT; i++) {
+            if (strcmp(interval, intervals[i]) != 0) continue;
+            if (series[i].merge(k)) merged++;
+            return;
+        }
+    }
+    void onPrice(float p) override { price = p; }
+};
+
+static bool sendPacket(int fd, uint8_t type, const std::vector<uint8_t>& body) {
+    std::vector<uint8_t> out{type};
+    size_t n = body.size();
+    do {
+        uint8_t b = n % 128;
+        n /= 128;
+        out.push_back(b | (n ? 0x80 : 0));
+    } while (n);
+    out.insert(out.end(), body.begin(), body.end());
+    return send(fd, out.data(), out.size(), 0) == (ssize_t)out.size();
+}
+
+static void putString(std::vector<uint8_t>& v, const char* s) {
+    size_t n = strlen(s);
+    v.push_back(n >> 8);
+    v.push_back(n & 0xff);
+    v.insert(v.end(), s, s + n);
+}
+
+static bool readFull(int fd, uint8_t* buf, size_t n) {
+    while (n) {
+        ssize_t r = recv(fd, buf, n, 0);
+        if (r <= 0) return false;
+        buf += r;
+        n -= r;
+    }
+    return true;
+}
+
+// 讀一個完整封包；回傳封包類型 (高 4 位元 + 旗標)，連線中斷時回傳 -1
+static int readPacket(int fd, std::vector<uint8_t>& body) {
+    uint8_t head, b;
+    if (!readFull(fd, &head, 1)) return -1;
+    size_t len = 0;
+    int shift = 0;
+    do {
+        if (!readFull(fd, &b, 1)) return -1;
+        len |= (size_t)(b & 0x7f) << shift;
+        shift += 7;
+    } while (b & 0x80);
+    body.resize(len);
+    if (len && !readFull(fd, body.data(), len)) return -1;
+    return head;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 5) {
+        fprintf(stderr, "usage: %s host port topic seconds\n", argv[0]);
+        return 2;
+    }
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(atoi(argv[2]));
+    inet_pton(AF_INET, argv[1], &addr.sin_addr);
+    if (connect(fd, (sockaddr*)&addr, sizeof(addr)) != 0) {
+        perror("connect");
+        return 1;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    // CONNECT：clean session，與裝置相同
+    std::vector<uint8_t> body;
+    putString(body, "MQTT");
+    body.insert(body.end(), {4, 0x02, 0, KEEPALIVE_S});
+    putString(body, "host-mqtt");
+    sendPacket(fd, 0x10, body);
+    std::vector<uint8_t> in;
+    if (readPacket(fd, in) != 0x20 || in.size() < 2 || in[1] != 0) {
+        fprintf(stderr, "connack refused\n");
+        return 1;
+    }
+    body.assign({0, 1});
+    putString(body, argv[3]);
+    body.push_back(0);
+    sendPacket(fd, 0x82, body);
+
+    SeriesSink sink;
+    uint32_t messages = 0, perFormat[2] = {}, klines = 0, prices = 0, errors = 0, retained = 0;
+    std::vector<uint32_t> latency;
+    char topic[128];
+    uint64_t end = nowMs() + atoi(argv[4]) * 1000ull;
+    uint64_t lastSent = nowMs();
+    while (nowMs() < end) {
+        pollfd p = {fd, POLLIN, 0};
+        if (poll(&p, 1, 200) <= 0) {
+            if (nowMs() - lastSent > KEEPALIVE_S * 500) {
+                sendPacket(fd, 0xc0, {});
+                lastSent = nowMs();
+            }
+            continue;
+        }
+        int head = readPacket(fd, in);
+        if (head < 0) break;
+        if ((head >> 4) != 3) continue;
+        // QoS 0 的 PUBLISH：topic 之後直接是 payload (沒有 packet id)
+        size_t n = ((size_t)in[0] << 8) | in[1];
+        if (n + 2 > in.size()) continue;
+        size_t tn = std::min(n, sizeof(topic) - 1);
+        memcpy(topic, in.data() + 2, tn);
+        topic[tn] = 0;
+        MarketMsgResult r = decodeMarketMsg(topic, in.data() + 2 + n, in.size() - 2 - n, sink);
+        uint64_t now = epochMs();
+        messages++;
+        perFormat[r.format]++;
+        if (head & 1) retained++;
+        if (!r.ok) errors++;
+        klines += r.klines;
+        prices += r.prices;
+        // retained 訊息的 "E" 是當初發布的時間，不算延遲
+        if (r.eventMs && !(head & 1) && now >= r.eventMs) latency.push_back(now - r.eventMs);
+    }
+    sendPacket(fd, 0xe0, {});
+    close(fd);
+
+    printf("host msgs=%u json=%u msgpack=%u retained=%u klines=%u merged=%u prices=%u errors=%u price=%.2f\n",
+           messages, perFormat[MARKET_JSON], perFormat[MARKET_MSGPACK], retained, klines, sink.merged, prices, errors,
+           sink.price);
+    if (!latency.empty()) {
+        std::sort(latency.begin(), latency.end());
+        printf("host latency n=%zu p50=%ums p95=%ums max=%ums\n", latency.size(), latency[latency.size() / 2],
+               latency[latency.size() * 95 / 100], latency.back());
+    }
+    for (int i = 0; i < INTERVAL_COUNT; i++) {
+        const KLine* k = sink.series[i].last();
+        printf("host %-3s count=%2d last=%llu close=%.2f\n", intervals[i], sink.series[i].count,
+               k ? (unsigned long long)k->openTime : 0ull, k ? k->close : 0.0f);
+    }
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+// 主機上的 ROM crc32_le 替身：與 zlib 的 crc32() 相同 (標準 CRC-32，初值 0，可分段累加)
+
+#include <stdint.h>
+#include <zlib.h>
+
+static inline uint32_t crc32_le(uint32_t crc, const uint8_t* buf, uint32_t len) {
+    return (uint32_t)crc32(crc, buf, len);
+}
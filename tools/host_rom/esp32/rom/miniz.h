@@ -0,0 +1,51 @@
+#pragma once
+
+// 主機上的 ROM miniz 替身：只提供 gzip_stream.cpp 用到的 tinfl 介面，以系統的 zlib (raw deflate) 實作。
+// 輸出直接寫進呼叫端給的位置，視窗由 zlib 自己保存。編譯時加 -Itools/host_rom ... -lz
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <zlib.h>
+
+#define TINFL_LZ_DICT_SIZE 32768
+#define TINFL_FLAG_HAS_MORE_INPUT 2
+
+typedef enum {
+    TINFL_STATUS_FAILED = -1,
+    TINFL_STATUS_DONE = 0,
+    TINFL_STATUS_NEEDS_MORE_INPUT = 1,
+    TINFL_STATUS_HAS_MORE_OUTPUT = 2
+} tinfl_status;
+
+// 呼叫端以 calloc 配置，ready 為 0 表示 zlib 還沒初始化
+typedef struct {
+    z_stream z;
+    int ready;
+} tinfl_decompressor;
+
+static inline void tinfl_init(tinfl_decompressor* d) {
+    if (d->ready) {
+        inflateReset(&d->z);
+        return;
+    }
+    memset(&d->z, 0, sizeof(d->z));
+    d->ready = inflateInit2(&d->z, -15) == Z_OK;
+}
+
+static inline tinfl_status tinfl_decompress(tinfl_decompressor* d, const uint8_t* in, size_t* inSize,
+                                            uint8_t* outStart, uint8_t* out, size_t* outSize, int flags) {
+    (void)outStart;
+    (void)flags;
+    if (!d->ready) return TINFL_STATUS_FAILED;
+    d->z.next_in = (Bytef*)in;
+    d->z.avail_in = (uInt)*inSize;
+    d->z.next_out = out;
+    d->z.avail_out = (uInt)*outSize;
+    int r = inflate(&d->z, Z_NO_FLUSH);
+    *inSize -= d->z.avail_in;
+    *outSize -= d->z.avail_out;
+    if (r == Z_STREAM_END) return TINFL_STATUS_DONE;
+    if (r != Z_OK && r != Z_BUF_ERROR) return TINFL_STATUS_FAILED;
+    return d->z.avail_out == 0 ? TINFL_STATUS_HAS_MORE_OUTPUT : TINFL_STATUS_NEEDS_MORE_INPUT;
+}
@@ -0,0 +1,166 @@
+// 在主機上驗證網路 task -> UI task 的快照交接 (SpscRing<KLineSnapshot, SNAPSHOT_SLOTS>)。
+// 生產者執行緒照 net_task.cpp publishPending() 的方式發布 (佇列滿時保留 pending 位元，下一輪再發布最新狀態)，
+// 不時一次更新全部週期把佇列塞滿；消費者執行緒照 UI loop() 的節奏每 period_us 取一次。檢查：
+//   1. 取到的快照沒有撕裂 (整份序列屬於同一個版本)，同一週期的版本不會倒退
+//   2. 結束後每個週期 UI 端的版本與網路 task 最後的版本相同 (佇列滿也不遺失)
+//   3. push -> pop 的延遲 p99 不超過 period_us + slack_us (交接本身最多多等一輪 UI loop)
+//
+//   g++ -std=gnu++17 -O2 -pthread -Isrc -o host_spsc tools/host_spsc.cpp src/kline_store.cpp
+//   ./host_spsc [period_us=1000] [slack_us=2000] [seconds=3]
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+#include <vector>
+
+#include "kline_store.h"
+#include "spsc_ring.h"
+
+struct Stamped {
+    KLineSnapshot snap;
+    uint32_t version;
+    uint64_t pushedNs;
+};
+
+static SpscRing<Stamped, SNAPSHOT_SLOTS> ring;
+static std::atomic<bool> producerDone{false};
+
+static uint64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// 每一根 K線都帶版本號，消費端可檢查整份序列是否一致
+static void fill(KLineSeries& s, uint32_t version) {
+    s.count = KLINE_COUNT;
+    for (int j = 0; j < KLINE_COUNT; j++) {
+        s.items[j].openTime = (uint64_t)version * 1000 + j;
+        s.items[j].open = s.items[j].high = s.items[j].low = s.items[j].close = (float)version;
+    }
+}
+
+struct Producer {
+    KLineSeries series[INTERVAL_COUNT];
+    uint32_t versions[INTERVAL_COUNT] = {};
+    uint32_t pendingMask = 0;
+    uint32_t pushed = 0;
+    uint32_t full = 0;       // 佇列滿、留待下一輪的次數
+
+    void update(int i, uint32_t version) {
+        fill(series[i], version);
+        versions[i] = version;
+        pendingMask |= 1u << i;
+    }
+
+    // 與 publishPending() 相同：滿了就停，pending 位元留著
+    void publish() {
+        static Stamped s;
+        for (int i = 0; i < INTERVAL_COUNT && pendingMask; i++) {
+            if (!(pendingMask & (1u << i))) continue;
+            s.snap.intervalIdx = i;
+            s.snap.price = (float)versions[i];
+            s.snap.series = series[i];
+            s.version = versions[i];
+            s.pushedNs = nowNs();
+            if (!ring.push(s)) {
+                full++;
+                return;
+            }
+            pushed++;
+            pendingMask &= ~(1u << i);
+        }
+    }
+
+    void run(uint32_t seconds) {
+        uint64_t end = nowNs() + (uint64_t)seconds * 1000000000ull;
+        uint32_t version = 0;
+        for (uint32_t step = 0; nowNs() < end; step++) {
+            // 每 50 輪一次全部週期都變 (例如重新連線後全部重抓)，超過佇列容量
+            if (step % 50 == 0) {
+                for (int i = 0; i < INTERVAL_COUNT; i++) update(i, ++version);
+            } else {
+                update(rand() % INTERVAL_COUNT, ++version);
+            }
+            publish();
+            std::this_thread::sleep_for(std::chrono::microseconds(100 + rand() % 400));
+        }
+        while (pendingMask) {
+            publish();
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+        producerDone = true;
+    }
+};
+
+struct Consumer {
+    uint32_t versions[INTERVAL_COUNT] = {};
+    uint32_t torn = 0;
+    uint32_t regressed = 0;
+    std::vector<uint64_t> latencyNs;
+
+    void drain() {
+        static Stamped s;
+        while (ring.pop(s)) {
+            uint64_t t = nowNs();
+            latencyNs.push_back(t - s.pushedNs);
+            const KLineSeries& k = s.snap.series;
+            bool ok = k.count == KLINE_COUNT && s.snap.price == (float)s.version;
+            for (int j = 0; ok && j < KLINE_COUNT; j++) {
+                ok = k.items[j].openTime == (uint64_t)s.version * 1000 + j && k.items[j].close == (float)s.version;
+            }
+            if (!ok) torn++;
+            if (s.version <= versions[s.snap.intervalIdx]) regressed++;
+            versions[s.snap.intervalIdx] = s.version;
+        }
+    }
+
+    void run(uint32_t periodUs) {
+        while (!producerDone) {
+            drain();
+            std::this_thread::sleep_for(std::chrono::microseconds(periodUs));
+        }
+        drain();
+    }
+};
+
+static double percentileUs(std::vector<uint64_t>& v, double p) {
+    if (v.empty()) return 0;
+    size_t i = (size_t)(p * (v.size() - 1));
+    std::nth_element(v.begin(), v.begin() + i, v.end());
+    return v[i] / 1000.0;
+}
+
+int main(int argc, char** argv) {
+    uint32_t periodUs = argc > 1 ? atoi(argv[1]) : 1000;
+    uint32_t slackUs = argc > 2 ? atoi(argv[2]) : 2000;
+    uint32_t seconds = argc > 3 ? atoi(argv[3]) : 3;
+    srand(1);
+
+    static Producer producer;
+    static Consumer consumer;
+    for (int i = 0; i < INTERVAL_COUNT; i++) producer.series[i].clear();
+    std::thread ui([&] { consumer.run(periodUs); });
+    std::thread net([&] { producer.run(seconds); });
+    net.join();
+    ui.join();
+
+    int lost = 0;
+    for (int i = 0; i < INTERVAL_COUNT; i++) {
+        if (consumer.versions[i] != producer.versions[i]) lost++;
+    }
+    double p50 = percentileUs(consumer.latencyNs, 0.5);
+    double p99 = percentileUs(consumer.latencyNs, 0.99);
+    double max = percentileUs(consumer.latencyNs, 1.0);
+    uint32_t bound = periodUs + slackUs;
+    printf("[spsc] snapshot=%zu bytes pushed=%u full=%u torn=%u regressed=%u lost=%d\n", sizeof(KLineSnapshot),
+           producer.pushed, producer.full, consumer.torn, consumer.regressed, lost);
+    printf("[spsc] push->pop p50=%.0fus p99=%.0fus max=%.0fus bound=%uus (period %uus + slack %uus)\n", p50, p99, max,
+           bound, periodUs, slackUs);
+
+    bool ok = consumer.torn == 0 && consumer.regressed == 0 && lost == 0 &&
+              consumer.latencyNs.size() == producer.pushed && p99 <= bound;
+    printf("%s\n", ok ? "all ok" : "FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,213 @@
+// 在主機上驗證 REST 抓取進行中觸控仍即時反應 (觸控 -> 處理完 < 30 ms)。
+// 網路執行緒照 net_task 的方式：標記 busy，阻塞在 socket 的 recv() 上等一份慢慢送來的 K線回應
+// (伺服器執行緒在 fetch_ms 內分段送出 500 列)，以 KLineFetch 串流解析，完成後經 SpscRing 發布快照；
+// UI 執行緒照 loop() 的節奏 (handleTouch -> applySnapshots -> 等 1 ms) 處理預先排定時間的觸控：
+// 換週期、setViewInterval / requestFetch、依 UI 端副本決定直接重畫或顯示 Loading。檢查：
+//   1. 觸控發生到處理完的延遲 (含等到下一輪 loop) 最大值不超過 bound_ms，且確實有觸控落在抓取進行中
+//   2. 網路端發布的快照全部送到 UI 端，每份都是完整的 KLINE_COUNT 根
+// TFT 的實際繪圖 (SPI) 無法在主機上跑，不在這個延遲內；裝置上由 Serial 的 [ui] touch->render 量測。
+// handleTouch() 裡的 cacheLookup() 依賴 Arduino，這裡以「副本是否有資料」代替。
+//
+//   g++ -std=gnu++17 -O2 -pthread -Isrc -o host_touch tools/host_touch.cpp src/kline_fetch.cpp src/exchange.cpp
+//       src/kline_parser.cpp src/json_stream.cpp src/kline_store.cpp
+//   ./host_touch [fetch_ms=2000] [bound_ms=30] [seconds=8]
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "kline_fetch.h"
+#include "spsc_ring.h"
+
+// 與 net_task.cpp 的 UI 端介面相同：快照佇列加上幾個 atomic，UI 端的呼叫都不會阻塞
+static SpscRing<KLineSnapshot, SNAPSHOT_SLOTS> snapshots;
+static std::atomic<uint32_t> fetchRequests{0};
+static std::atomic<int> viewInterval{2};
+static std::atomic<bool> busy{false};
+static std::atomic<bool> stopping{false};
+static std::atomic<bool> netDone{false};
+
+static uint64_t nowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Binance /api/v3/klines 格式的回應，rows 列
+static std::string klineBody(int rows, uint64_t start, uint64_t stepMs) {
+    std::string body = "[";
+    char row[256];
+    for (int i = 0; i < rows; i++) {
+        uint64_t t = start + i * stepMs;
+        float o = 60000.0f + (i % 97) * 1.25f;
+        snprintf(row, sizeof(row),
+                 "%s[%llu,\"%.2f\",\"%.2f\",\"%.2f\",\"%.2f\",\"12.345\",%llu,\"740000.1\",1234,\"6.1\",\"370000.0\",\"0\"]",
+                 i ? "," : "", (unsigned long long)t, o, o + 30, o - 30, o + 5, (unsigned long long)(t + stepMs - 1));
+        body += row;
+    }
+    return body + "]";
+}
+
+// 伺服器端：body 以 1460 bytes 一段平均分散在 ms 內送出，模擬慢速的 TLS 回應
+static void serve(int fd, const std::string& body, uint32_t ms) {
+    size_t chunks = (body.size() + 1459) / 1460;
+    for (size_t off = 0; off < body.size(); off += 1460) {
+        size_t len = std::min((size_t)1460, body.size() - off);
+        if (send(fd, body.data() + off, len, MSG_NOSIGNAL) != (ssize_t)len) return;
+        std::this_thread::sleep_for(std::chrono::microseconds((uint64_t)ms * 1000 / chunks));
+    }
+}
+
+struct Net {
+    KLineSeries series[INTERVAL_COUNT];
+    uint32_t pendingMask = 0;
+    uint32_t fetches = 0;
+    uint32_t published = 0;
+    uint64_t busyUs = 0;
+
+    // 與 publishPending() 相同：滿了就停，pending 位元留著下一輪
+    void publish() {
+        static KLineSnapshot s;
+        for (int i = 0; i < INTERVAL_COUNT && pendingMask; i++) {
+            if (!(pendingMask & (1u << i))) continue;
+            s.intervalIdx = i;
+            s.price = series[i].last() ? series[i].last()->close : 0;
+            s.series = series[i];
+            if (!snapshots.push(s)) return;
+            published++;
+            pendingMask &= ~(1u << i);
+        }
+    }
+
+    // 一次阻塞的抓取：recv() 等到伺服器送完整份 body
+    void fetch(int idx, uint32_t fetchMs) {
+        int sv[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0) return;
+        std::string body = klineBody(500, 1700000000000ull + fetches * 60000ull, 60000);
+        std::thread server([&] {
+            serve(sv[1], body, fetchMs);
+            close(sv[1]);
+        });
+        uint64_t t0 = nowUs();
+        busy = true;
+        series[idx].clear();
+        KLineFetch f(series[idx]);
+        uint8_t buf[1460];
+        ssize_t n;
+        while ((n = recv(sv[0], buf, sizeof(buf), 0)) > 0) f.write(buf, n);
+        busy = false;
+        busyUs += nowUs() - t0;
+        server.join();
+        close(sv[0]);
+        if (f.parsed()) {
+            fetches++;
+            pendingMask |= 1u << idx;
+        }
+    }
+
+    // 使用者點的週期優先，否則依序背景刷新
+    void run(uint32_t fetchMs) {
+        int idx = viewInterval;
+        while (!stopping) {
+            uint32_t req = fetchRequests.exchange(0);
+            idx = req ? __builtin_ctz(req) : (idx + 1) % INTERVAL_COUNT;
+            fetch(idx, fetchMs);
+            publish();
+        }
+        while (pendingMask) {
+            publish();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        netDone = true;
+    }
+};
+
+struct Ui {
+    KLineSeries series[INTERVAL_COUNT];
+    int current = 2;
+    uint32_t duringFetch = 0;   // 發生在抓取進行中的觸控
+    uint32_t loading = 0;       // 副本沒有資料，顯示 Loading 等網路
+    uint32_t redraw = 0;        // 副本有資料，直接重畫
+    uint32_t applied = 0;
+    uint32_t incomplete = 0;    // 收到筆數不足的快照
+    std::vector<uint64_t> latencyUs;
+
+    // handleTouch() 中不涉及繪圖的部分
+    void touch(int i) {
+        current = i;
+        viewInterval = i;
+        if (series[i].count == 0) loading++;
+        else redraw++;
+        fetchRequests.fetch_or(1u << i);
+    }
+
+    void applySnapshots() {
+        static KLineSnapshot s;
+        while (snapshots.pop(s)) {
+            series[s.intervalIdx] = s.series;
+            applied++;
+            if (s.series.count != KLINE_COUNT) incomplete++;
+        }
+    }
+
+    // 觸控時間點預先排定 (每 100~400 ms 一次)，延遲從該時間點算起，包含等待下一輪 loop
+    void run() {
+        uint64_t nextTouch = nowUs() + 100000;
+        while (!netDone) {
+            uint64_t now = nowUs();
+            if (!stopping && now >= nextTouch) {
+                bool inFetch = busy;
+                touch((current + 1 + rand() % (INTERVAL_COUNT - 1)) % INTERVAL_COUNT);
+                latencyUs.push_back(nowUs() - nextTouch);
+                if (inFetch) duringFetch++;
+                nextTouch = now + (100 + rand() % 300) * 1000;
+            }
+            applySnapshots();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        applySnapshots();
+    }
+};
+
+int main(int argc, char** argv) {
+    uint32_t fetchMs = argc > 1 ? atoi(argv[1]) : 2000;
+    uint32_t boundMs = argc > 2 ? atoi(argv[2]) : 30;
+    uint32_t seconds = argc > 3 ? atoi(argv[3]) : 8;
+    srand(1);
+
+    static Net net;
+    static Ui ui;
+    for (int i = 0; i < INTERVAL_COUNT; i++) {
+        net.series[i].clear();
+        ui.series[i].clear();
+    }
+    uint64_t start = nowUs();
+    std::thread uiThread([&] { ui.run(); });
+    std::thread netThread([&] { net.run(fetchMs); });
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    stopping = true;
+    netThread.join();
+    uiThread.join();
+    uint64_t elapsed = nowUs() - start;
+
+    std::vector<uint64_t>& v = ui.latencyUs;
+    std::sort(v.begin(), v.end());
+    double p50 = v.empty() ? 0 : v[v.size() / 2] / 1000.0;
+    double p99 = v.empty() ? 0 : v[(size_t)(0.99 * (v.size() - 1))] / 1000.0;
+    double max = v.empty() ? 0 : v.back() / 1000.0;
+    printf("[touch] fetches=%u (%ums each, net busy %.0f%%) published=%u applied=%u incomplete=%u\n", net.fetches,
+           fetchMs, net.busyUs * 100.0 / elapsed, net.published, ui.applied, ui.incomplete);
+    printf("[touch] touches=%zu during_fetch=%u loading=%u redraw=%u\n", v.size(), ui.duringFetch, ui.loading,
+           ui.redraw);
+    printf("[touch] touch->handled p50=%.2fms p99=%.2fms max=%.2fms bound=%ums\n", p50, p99, max, boundMs);
+
+    bool ok = !v.empty() && ui.duringFetch > 0 && max <= boundMs && ui.applied == net.published &&
+              ui.incomplete == 0 && net.fetches > 0;
+    printf("%s\n", ok ? "all ok" : "FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,416 @@
+#!/usr/bin/env python3
+"""本地 Binance 替身伺服器：提供 REST K線 / ticker / 24hr ticker / time 與 WebSocket K線串流。
+
+可注入延遲、丟包 (不回應直接斷線)、截斷 (body 送一半就斷線) 與 5xx，並回報
+X-MBX-USED-WEIGHT-1m；超過 --weight-limit 時回 429 + Retry-After。
+
+  python3 tools/mock_binance.py --port 8080 --latency 150 --jitter 50 --loss 0.02 --truncate 0.02
+  python3 tools/mock_binance.py --port 8443 --cert cert.pem --key key.pem     # 給裝置用 (TLS)
+  python3 tools/mock_binance.py --record klines.json                          # 回放錄下來的回應
+  python3 tools/mock_binance.py --replay tools/fixtures                       # 回放錄下來的原始 body
+
+同一個埠也模擬 Coinbase (/products/...)、Kraken (/0/public/...) 與 OKX (/api/v5/market/...) 的 K線與
+ticker，價格與 Binance 相差萬分之幾，給多交易所轉接器 (src/exchange.cpp) 與選價邏輯測試用。
+
+--record 的 JSON 格式：{"klines": {"1m": [[openTime, "o", "h", "l", "c", ...], ...]}, "price": "64000.00"}
+--script 的 JSON 可依路徑覆寫故障參數：{"/api/v3/klines": {"latency": 300, "truncate": 0.2}}
+--replay 目錄中的檔名為路徑把 "/" 換成 "_" (不含開頭與 query)，例如 products_BTC-USD_candles.json；
+有對應檔案的路徑直接回傳檔案內容，可用 curl 從真實交易所錄下來。
+"""
+
+import argparse
+import base64
+import gzip
+import hashlib
+import json
+import os
+import random
+import socket
+import ssl
+import struct
+import threading
+import time
+from email.utils import formatdate
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from urllib.parse import parse_qs, urlparse
+
+INTERVAL_MS = {"1m": 60_000, "3m": 180_000, "5m": 300_000, "15m": 900_000, "30m": 1_800_000,
+               "1h": 3_600_000, "2h": 7_200_000, "4h": 14_400_000, "6h": 21_600_000, "1d": 86_400_000}
+INTERVAL_BY_MS = {ms: name for name, ms in INTERVAL_MS.items()}
+OKX_BARS = {"1m": "1m", "5m": "5m", "1H": "1h", "4H": "4h", "6H": "6h", "1D": "1d", "1Dutc": "1d"}
+# 各交易所相對 Binance 的價差
+EXCHANGE_SPREAD = {"coinbase": 1.0003, "kraken": 0.9998, "okx": 1.0001}
+WS_GUID = "258EAFA5-E914-47DA-95CA-C5AB0DC11B65"
+
+
+class Market:
+    """以隨機漫步產生價格；同一個開盤時間的 K線在整個執行期間保持一致。"""
+
+    def __init__(self, seed, record=None):
+        self.rng = random.Random(seed)
+        self.lock = threading.Lock()
+        self.price = 64000.0
+        self.candles = {}
+        self.record = record or {}
+        if "price" in self.record:
+            self.price = float(self.record["price"])
+
+    def tick(self):
+        with self.lock:
+            self.price *= 1 + self.rng.gauss(0, 0.0004)
+            return self.price
+
+    def ticker24(self, symbol, mini):
+        """非 BTCUSDT 的交易對以固定倍率由 BTC 價格換算，漲跌幅各自固定。"""
+        rng = random.Random(symbol)
+        scale = 1.0 if symbol == "BTCUSDT" else rng.uniform(1e-5, 0.06)
+        last = self.tick() * scale
+        o = last / (1 + rng.gauss(0, 0.03))
+        now = int(time.time() * 1000)
+        t = {"symbol": symbol, "openPrice": "%.8f" % o, "highPrice": "%.8f" % (max(o, last) * 1.01),
+             "lowPrice": "%.8f" % (min(o, last) * 0.99), "lastPrice": "%.8f" % last,
+             "volume": "%.8f" % (rng.random() * 1e5), "quoteVolume": "%.8f" % (rng.random() * 1e9),
+             "openTime": now - 86_400_000, "closeTime": now, "firstId": 1, "lastId": 1000, "count": 1000}
+        if not mini:
+            t.update({"priceChange": "%.8f" % (last - o), "priceChangePercent": "%.3f" % ((last - o) / o * 100),
+                      "weightedAvgPrice": "%.8f" % ((o + last) / 2), "prevClosePrice": "%.8f" % o,
+                      "lastQty": "0.01000000", "bidPrice": "%.8f" % last, "bidQty": "1.00000000",
+                      "askPrice": "%.8f" % last, "askQty": "1.00000000"})
+        return t
+
+    def _candle(self, interval, open_time):
+        key = (interval, open_time)
+        if key not in self.candles:
+            rng = random.Random(hash(key))
+            o = self.price * (1 + rng.gauss(0, 0.002))
+            c = o * (1 + rng.gauss(0, 0.002))
+            self.candles[key] = [open_time, o, max(o, c) * (1 + rng.random() * 0.001),
+                                 min(o, c) * (1 - rng.random() * 0.001), c]
+        return self.candles[key]
+
+    def klines(self, interval, limit, start_time=None, now_ms=None):
+        if interval in self.record.get("klines", {}):
+            rows = self.record["klines"][interval]
+            if start_time is not None:
+                rows = [r for r in rows if r[0] >= start_time]
+            return rows[-limit:] if start_time is None else rows[:limit]
+        period = INTERVAL_MS[interval]
+        now_ms = now_ms or int(time.time() * 1000)
+        current = now_ms - now_ms % period
+        first = current - (limit - 1) * period
+        if start_time is not None:
+            first = start_time - start_time % period
+        rows = []
+        with self.lock:
+            t = first
+            while t <= current and len(rows) < limit:
+                o, h, l, c = self._candle(interval, t)[1:]
+                if t == current:
+                    c = self.price
+                    h, l = max(h, c), min(l, c)
+                rows.append([t, "%.2f" % o, "%.2f" % h, "%.2f" % l, "%.2f" % c, "12.345", t + period - 1,
+                             "790000.0", 1000, "6.0", "390000.0", "0"])
+                t += period
+        return rows
+
+
+class Weights:
+    """每分鐘的請求權重，模擬整個 IP 共用的額度。"""
+
+    def __init__(self, limit):
+        self.limit = limit
+        self.minute = 0
+        self.used = 0
+        self.lock = threading.Lock()
+
+    def add(self, weight):
+        with self.lock:
+            minute = int(time.time() // 60)
+            if minute != self.minute:
+                self.minute, self.used = minute, 0
+            self.used += weight
+            retry = 60 - int(time.time()) % 60
+            return self.used, (retry if self.limit and self.used > self.limit else None)
+
+
+class Handler(BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"
+    server_version = "mock-binance"
+
+    def setup(self):
+        super().setup()
+        # 標頭與 body 分兩次寫出，關掉 Nagle 才不會被 delayed ACK 卡 40 ms
+        self.connection.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+
+    def log_message(self, fmt, *args):
+        if self.server.opts.verbose:
+            super().log_message(fmt, *args)
+
+    def fault(self, name):
+        path = urlparse(self.path).path
+        return self.server.script.get(path, {}).get(name, getattr(self.server.opts, name))
+
+    def do_GET(self):
+        url = urlparse(self.path)
+        if url.path == "/ws" and self.headers.get("Upgrade", "").lower() == "websocket":
+            return self.websocket()
+        latency = self.fault("latency") + random.uniform(0, self.fault("jitter"))
+        time.sleep(latency / 1000)
+        if random.random() < self.fault("loss"):
+            self.close_connection = True
+            self.connection.shutdown(socket.SHUT_RDWR)
+            return
+        if random.random() < self.fault("error_rate"):
+            return self.reply(503, b'{"code":-1001,"msg":"Internal error; unable to process your request."}')
+
+        q = {k: v[0] for k, v in parse_qs(url.query).items()}
+        market = self.server.market
+        if self.server.opts.replay:
+            name = os.path.join(self.server.opts.replay, url.path.strip("/").replace("/", "_") + ".json")
+            if os.path.isfile(name):
+                with open(name, "rb") as f:
+                    return self.reply(200, f.read())
+        if url.path.startswith(("/products/", "/0/public/", "/api/v5/")):
+            return self.other_exchange(url.path, q)
+        if url.path == "/api/v3/klines":
+            interval = q.get("interval", "1m")
+            if interval not in INTERVAL_MS:
+                return self.reply(400, b'{"code":-1120,"msg":"Invalid interval."}')
+            limit = min(int(q.get("limit", 500)), 1000)
+            start = int(q["startTime"]) if "startTime" in q else None
+            body, weight = json.dumps(market.klines(interval, limit, start), separators=(",", ":")), 2
+        elif url.path == "/api/v3/ticker/price":
+            body, weight = json.dumps({"symbol": q.get("symbol", "BTCUSDT"), "price": "%.2f" % market.tick()}), 2
+        elif url.path == "/api/v3/ticker/24hr":
+            # 權重依 symbols 數量分級：1~20 為 2、21~100 為 40、更多或不帶則為 80
+            try:
+                symbols = json.loads(q["symbols"]) if "symbols" in q else [q.get("symbol", "BTCUSDT")]
+            except ValueError:
+                return self.reply(400, b'{"code":-1100,"msg":"Illegal characters found in parameter symbols."}')
+            mini = q.get("type", "FULL") == "MINI"
+            tickers = [market.ticker24(s, mini) for s in symbols]
+            weight = 2 if len(symbols) <= 20 else 40 if len(symbols) <= 100 else 80
+            body = json.dumps(tickers if "symbols" in q else tickers[0], separators=(",", ":"))
+        elif url.path == "/api/v3/time":
+            body, weight = json.dumps({"serverTime": int(time.time() * 1000)}), 1
+        else:
+            return self.reply(404, b'{"code":-1,"msg":"not found"}')
+        used, retry = self.server.weights.add(weight)
+        if retry is not None:
+            return self.reply(429, b'{"code":-1003,"msg":"Too many requests."}', used, retry)
+        self.reply(200, body.encode(), used)
+
+    def other_exchange(self, path, q):
+        """Coinbase / Kraken / OKX 的 K線與 ticker，欄位格式與排序照各交易所文件。"""
+        market = self.server.market
+        if path == "/products/BTC-USD/candles":
+            interval = INTERVAL_BY_MS.get(int(q.get("granularity", 0)) * 1000)
+            if not interval:
+                return self.reply(400, b'{"message":"Unsupported granularity"}')
+            k = EXCHANGE_SPREAD["coinbase"]
+            rows = [[r[0] // 1000, float(r[3]) * k, float(r[2]) * k, float(r[1]) * k, float(r[4]) * k, 12.345]
+                    for r in reversed(market.klines(interval, 300))]
+            body = json.dumps(rows)
+        elif path == "/products/BTC-USD/ticker":
+            p = market.tick() * EXCHANGE_SPREAD["coinbase"]
+            body = json.dumps({"ask": "%.2f" % (p + 0.01), "bid": "%.2f" % p, "volume": "8123.5", "trade_id": 1,
+                               "price": "%.2f" % p, "size": "0.01", "time": formatdate(usegmt=True)})
+        elif path == "/0/public/OHLC":
+            interval = INTERVAL_BY_MS.get(int(q.get("interval", 1)) * 60_000)
+            if not interval:
+                return self.reply(200, b'{"error":["EGeneral:Invalid arguments"]}')
+            k = EXCHANGE_SPREAD["kraken"]
+            since = int(q["since"]) * 1000 + 1 if "since" in q else None
+            rows = [[r[0] // 1000] + ["%.1f" % (float(v) * k) for v in r[1:5]] + ["%.1f" % (float(r[4]) * k), "1.5", 42]
+                    for r in market.klines(interval, 720, since)]
+            body = json.dumps({"error": [], "result": {"XBTUSDT": rows, "last": rows[-1][0] if rows else 0}})
+        elif path == "/0/public/Ticker":
+            p = "%.1f" % (market.tick() * EXCHANGE_SPREAD["kraken"])
+            body = json.dumps({"error": [], "result": {"XBTUSDT": {
+                "a": [p, "1", "1.000"], "b": [p, "1", "1.000"], "c": [p, "0.00100000"], "v": ["10.0", "100.0"],
+                "p": [p, p], "t": [10, 100], "l": [p, p], "h": [p, p], "o": p}}})
+        elif path == "/api/v5/market/candles":
+            interval = OKX_BARS.get(q.get("bar", "1m"))
+            if not interval:
+                return self.reply(200, b'{"code":"51000","msg":"Parameter bar error","data":[]}')
+            k = EXCHANGE_SPREAD["okx"]
+            rows = [[str(r[0])] + ["%.1f" % (float(v) * k) for v in r[1:5]] + ["12.3", "790000", "790000", "1"]
+                    for r in reversed(market.klines(interval, min(int(q.get("limit", 100)), 300)))]
+            body = json.dumps({"code": "0", "msg": "", "data": rows})
+        elif path == "/api/v5/market/ticker":
+            p = "%.1f" % (market.tick() * EXCHANGE_SPREAD["okx"])
+            body = json.dumps({"code": "0", "msg": "", "data": [{
+                "instType": "SPOT", "instId": "BTC-USDT", "last": p, "lastSz": "0.01", "askPx": p, "bidPx": p,
+                "open24h": p, "high24h": p, "low24h": p, "ts": str(int(time.time() * 1000))}]})
+        else:
+            return self.reply(404, b'{"message":"not found"}')
+        self.reply(200, body.encode())
+
+    def reply(self, status, body, used=None, retry=None):
+        gz = self.server.opts.gzip and "gzip" in ", ".join(self.headers.get_all("Accept-Encoding", [])) and status == 200
+        if gz:
+            body = gzip.compress(body)
+        truncate = status == 200 and random.random() < self.fault("truncate")
+        self.send_response(status)
+        self.send_header("Content-Type", "application/json;charset=UTF-8")
+        self.send_header("Date", formatdate(usegmt=True))
+        if used is not None:
+            self.send_header("X-MBX-USED-WEIGHT-1m", str(used))
+        if retry is not None:
+            self.send_header("Retry-After", str(retry))
+        if gz:
+            self.send_header("Content-Encoding", "gzip")
+        chunked = self.server.opts.chunked
+        if chunked:
+            self.send_header("Transfer-Encoding", "chunked")
+        else:
+            self.send_header("Content-Length", str(len(body)))
+        self.end_headers()
+        if truncate:
+            body = body[:len(body) // 2]
+        if chunked:
+            size = max(1, self.server.opts.chunk_size)
+            for i in range(0, len(body), size):
+                part = body[i:i + size]
+                self.wfile.write(b"%x\r\n%s\r\n" % (len(part), part))
+            if not truncate:
+                self.wfile.write(b"0\r\n\r\n")
+        else:
+            self.wfile.write(body)
+        if truncate:
+            self.wfile.flush()
+            self.close_connection = True
+            self.connection.shutdown(socket.SHUT_RDWR)
+
+    # --- WebSocket: 回應 SUBSCRIBE，之後定期推送已訂閱週期的 K線事件 ---
+
+    def websocket(self):
+        key = self.headers.get("Sec-WebSocket-Key", "")
+        accept = base64.b64encode(hashlib.sha1((key + WS_GUID).encode()).digest()).decode()
+        self.send_response(101, "Switching Protocols")
+        self.send_header("Upgrade", "websocket")
+        self.send_header("Connection", "Upgrade")
+        self.send_header("Sec-WebSocket-Accept", accept)
+        self.end_headers()
+        self.wfile.flush()
+        self.close_connection = True
+        sock = self.connection
+        sock.settimeout(self.server.opts.ws_interval)
+        streams = []
+        while True:
+            try:
+                frame = self.ws_recv(sock)
+                if frame is None:
+                    return
+                opcode, payload = frame
+                if opcode == 0x8:
+                    self.ws_send(sock, 0x8, payload[:2])
+                    return
+                if opcode == 0x9:
+                    self.ws_send(sock, 0xA, payload)
+                elif opcode == 0x1:
+                    msg = json.loads(payload)
+                    if msg.get("method") == "SUBSCRIBE":
+                        streams = msg.get("params", [])
+                    self.ws_send(sock, 0x1, json.dumps({"result": None, "id": msg.get("id")}).encode())
+            except (socket.timeout, TimeoutError):
+                pass
+            except (OSError, ValueError):
+                return
+            if random.random() < self.server.opts.loss:
+                sock.shutdown(socket.SHUT_RDWR)
+                return
+            for name in streams:
+                symbol, _, interval = name.partition("@kline_")
+                row = self.server.market.klines(interval, 1)[-1] if interval in INTERVAL_MS else None
+                if not row:
+                    continue
+                now = int(time.time() * 1000)
+                event = {"e": "kline", "E": now, "s": symbol.upper(),
+                         "k": {"t": row[0], "T": row[6], "s": symbol.upper(), "i": interval,
+                               "o": row[1], "h": row[2], "l": row[3], "c": row[4], "v": row[5],
+                               "x": False}}
+                try:
+                    self.ws_send(sock, 0x1, json.dumps(event).encode())
+                except OSError:
+                    return
+            self.server.market.tick()
+
+    @staticmethod
+    def ws_recv(sock):
+        def read(n):
+            data = b""
+            while len(data) < n:
+                part = sock.recv(n - len(data))
+                if not part:
+                    raise OSError("closed")
+                data += part
+            return data
+
+        b1, b2 = read(2)
+        length = b2 & 0x7F
+        if length == 126:
+            length = struct.unpack(">H", read(2))[0]
+        elif length == 127:
+            length = struct.unpack(">Q", read(8))[0]
+        mask = read(4) if b2 & 0x80 else b"\0\0\0\0"
+        payload = bytes(b ^ mask[i % 4] for i, b in enumerate(read(length)))
+        return b1 & 0x0F, payload
+
+    @staticmethod
+    def ws_send(sock, opcode, payload):
+        header = bytes([0x80 | opcode])
+        n = len(payload)
+        if n < 126:
+            header += bytes([n])
+        elif n < 65536:
+            header += bytes([126]) + struct.pack(">H", n)
+        else:
+            header += bytes([127]) + struct.pack(">Q", n)
+        sock.sendall(header + payload)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--host", default="0.0.0.0")
+    ap.add_argument("--port", type=int, default=8080)
+    ap.add_argument("--cert", help="PEM 憑證 (與 --key 一起使用時改走 TLS)")
+    ap.add_argument("--key")
+    ap.add_argument("--latency", type=float, default=0, help="每個 REST 回應的固定延遲 (ms)")
+    ap.add_argument("--jitter", type=float, default=0, help="額外 0~N ms 的隨機延遲")
+    ap.add_argument("--loss", type=float, default=0, help="不回應直接斷線的機率")
+    ap.add_argument("--truncate", type=float, default=0, help="body 送一半就斷線的機率")
+    ap.add_argument("--error-rate", type=float, default=0, help="回 503 的機率")
+    ap.add_argument("--weight-limit", type=int, default=6000, help="每分鐘權重上限，0 表示不限")
+    ap.add_argument("--chunked", action="store_true", help="以 chunked 傳送 body")
+    ap.add_argument("--chunk-size", type=int, default=512)
+    ap.add_argument("--gzip", action="store_true", help="請求帶 Accept-Encoding: gzip 時壓縮回應")
+    ap.add_argument("--ws-interval", type=float, default=1.0, help="WebSocket 推送間隔 (秒)")
+    ap.add_argument("--record", help="回放的 K線 / 價格 JSON")
+    ap.add_argument("--script", help="依路徑覆寫故障參數的 JSON")
+    ap.add_argument("--replay", help="依路徑回放原始 body 的目錄")
+    ap.add_argument("--seed", type=int, default=1)
+    ap.add_argument("-v", "--verbose", action="store_true")
+    opts = ap.parse_args()
+
+    random.seed(opts.seed)
+    record = json.load(open(opts.record)) if opts.record else None
+    server = ThreadingHTTPServer((opts.host, opts.port), Handler)
+    server.daemon_threads = True
+    server.opts = opts
+    server.market = Market(opts.seed, record)
+    server.weights = Weights(opts.weight_limit)
+    server.script = json.load(open(opts.script)) if opts.script else {}
+    if opts.cert:
+        ctx = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+        ctx.load_cert_chain(opts.cert, opts.key)
+        server.socket = ctx.wrap_socket(server.socket, server_side=True)
+    print("mock binance on %s:%d%s" % (opts.host, opts.port, " (tls)" if opts.cert else ""))
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,319 @@
+#!/usr/bin/env python3
+"""本地 MQTT broker 替身 (mosquitto 的最小子集) 與行情產生器，測試 MQTT 輸入 (src/mqtt_feed.cpp)。
+
+broker：MQTT 3.1.1 的 CONNECT / SUBSCRIBE / UNSUBSCRIBE / PUBLISH / PINGREQ / DISCONNECT，
+        轉送一律 QoS 0，支援 + / # 萬用字元與 retained 訊息；其他 client (mosquitto_pub 等) 也能發布。
+--feed：內建發布端，以 tools/mock_binance.py 的隨機漫步產生價格，每個 --rate 秒對每個週期發布
+        market/BTCUSDT/kline/<i> (最後一根) 與 market/BTCUSDT/price，每 --snapshot 秒以 retained
+        發布 market/BTCUSDT/series/<i> (整組 30 根)；--format 選 json / msgpack / mixed (每則隨機)。
+        每則都帶 "E" (發布時間，epoch ms) 供訂閱端量延遲。結束時印出各週期最後一根，與訂閱端比對。
+
+  python3 tools/mqtt_broker.py --port 1883 --feed --rate 0.2 --format mixed
+  python3 tools/mqtt_broker.py --port 1883 --feed --duration 20     # 20 秒後停止並印出最後的 K線
+  mosquitto_pub -p 1883 -t market/BTCUSDT/price -m 64000.5          # 也可手動發布
+
+裝置以 -D MQTT_BROKER=\\"192.168.1.10\\" 指向這台主機。
+"""
+
+import argparse
+import json
+import os
+import random
+import socket
+import socketserver
+import struct
+import sys
+import threading
+import time
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from mock_binance import INTERVAL_MS, Market  # noqa: E402
+
+INTERVALS = ["1m", "5m", "1h", "4h", "1d"]
+PREFIX = "market/BTCUSDT"
+
+
+def msgpack(v):
+    """行情訊息用到的型別 (dict / list / str / int / float / bool / None) 的 MsgPack 編碼。"""
+    if v is None:
+        return b"\xc0"
+    if v is True:
+        return b"\xc3"
+    if v is False:
+        return b"\xc2"
+    if isinstance(v, int):
+        if 0 <= v < 0x80:
+            return bytes([v])
+        if -32 <= v < 0:
+            return struct.pack("b", v)
+        if v >= 0:
+            return b"\xcf" + struct.pack(">Q", v)
+        return b"\xd3" + struct.pack(">q", v)
+    if isinstance(v, float):
+        return b"\xcb" + struct.pack(">d", v)
+    if isinstance(v, str):
+        b = v.encode()
+        if len(b) < 32:
+            return bytes([0xa0 | len(b)]) + b
+        return b"\xd9" + bytes([len(b)]) + b
+    if isinstance(v, (list, tuple)):
+        head = bytes([0x90 | len(v)]) if len(v) < 16 else b"\xdc" + struct.pack(">H", len(v))
+        return head + b"".join(msgpack(x) for x in v)
+    if isinstance(v, dict):
+        head = bytes([0x80 | len(v)]) if len(v) < 16 else b"\xde" + struct.pack(">H", len(v))
+        return head + b"".join(msgpack(k) + msgpack(x) for k, x in v.items())
+    raise TypeError(type(v))
+
+
+def topic_matches(filt, topic):
+    f, t = filt.split("/"), topic.split("/")
+    for i, part in enumerate(f):
+        if part == "#":
+            return True
+        if i >= len(t) or (part != "+" and part != t[i]):
+            return False
+    return len(f) == len(t)
+
+
+def packet(ptype, body):
+    n, rl = len(body), bytearray()
+    while True:
+        b = n % 128
+        n //= 128
+        rl.append(b | (0x80 if n else 0))
+        if not n:
+            break
+    return bytes([ptype]) + bytes(rl) + body
+
+
+def utf8(s):
+    b = s.encode()
+    return struct.pack(">H", len(b)) + b
+
+
+def publish_packet(topic, payload, retain=False):
+    return packet(0x30 | (1 if retain else 0), utf8(topic) + payload)
+
+
+class Broker:
+    def __init__(self, verbose):
+        self.lock = threading.Lock()
+        self.clients = {}     # handler -> [filters]
+        self.retained = {}
+        self.verbose = verbose
+        self.routed = 0
+
+    def publish(self, topic, payload, retain=False):
+        with self.lock:
+            if retain:
+                if payload:
+                    self.retained[topic] = payload
+                else:
+                    self.retained.pop(topic, None)
+            targets = [h for h, filters in self.clients.items() if any(topic_matches(f, topic) for f in filters)]
+            self.routed += len(targets)
+        data = publish_packet(topic, payload)
+        for h in targets:
+            h.send(data)
+
+    def subscribe(self, handler, filters):
+        with self.lock:
+            self.clients.setdefault(handler, []).extend(filters)
+            retained = [(t, p) for t, p in self.retained.items() if any(topic_matches(f, t) for f in filters)]
+        # 新訂閱立即收到符合的 retained 訊息 (retain 旗標設起來)
+        for t, p in retained:
+            handler.send(publish_packet(t, p, retain=True))
+
+    def unsubscribe(self, handler, filters):
+        with self.lock:
+            subs = self.clients.get(handler, [])
+            for f in filters:
+                if f in subs:
+                    subs.remove(f)
+
+    def drop(self, handler):
+        with self.lock:
+            self.clients.pop(handler, None)
+
+
+class Handler(socketserver.BaseRequestHandler):
+    def setup(self):
+        self.request.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        self.send_lock = threading.Lock()
+        self.broker = self.server.broker
+
+    def send(self, data):
+        try:
+            with self.send_lock:
+                self.request.sendall(data)
+        except OSError:
+            pass
+
+    def read(self, n):
+        buf = b""
+        while len(buf) < n:
+            chunk = self.request.recv(n - len(buf))
+            if not chunk:
+                raise ConnectionError
+            buf += chunk
+        return buf
+
+    def handle(self):
+        try:
+            while True:
+                head = self.read(1)[0]
+                length, shift = 0, 0
+                while True:
+                    b = self.read(1)[0]
+                    length |= (b & 0x7F) << shift
+                    shift += 7
+                    if not b & 0x80:
+                        break
+                body = self.read(length) if length else b""
+                if not self.dispatch(head, body):
+                    break
+        except (ConnectionError, OSError):
+            pass
+        finally:
+            self.broker.drop(self)
+
+    def dispatch(self, head, body):
+        ptype = head >> 4
+        if ptype == 1:                      # CONNECT
+            name_len = struct.unpack(">H", body[:2])[0]
+            if body[2:2 + name_len] != b"MQTT" or body[2 + name_len] != 4:
+                self.send(packet(0x20, b"\x00\x01"))   # 不支援的協定版本
+                return False
+            if self.broker.verbose:
+                cid_at = 2 + name_len + 4
+                cid_len = struct.unpack(">H", body[cid_at:cid_at + 2])[0]
+                print("connect", body[cid_at + 2:cid_at + 2 + cid_len].decode(errors="replace"), flush=True)
+            self.send(packet(0x20, b"\x00\x00"))
+        elif ptype == 8:                    # SUBSCRIBE
+            pid, i, filters = body[:2], 2, []
+            while i < len(body):
+                n = struct.unpack(">H", body[i:i + 2])[0]
+                filters.append(body[i + 2:i + 2 + n].decode())
+                i += 2 + n + 1
+            # 一律授與 QoS 0
+            self.send(packet(0x90, pid + b"\x00" * len(filters)))
+            self.broker.subscribe(self, filters)
+        elif ptype == 10:                   # UNSUBSCRIBE
+            pid, i, filters = body[:2], 2, []
+            while i < len(body):
+                n = struct.unpack(">H", body[i:i + 2])[0]
+                filters.append(body[i + 2:i + 2 + n].decode())
+                i += 2 + n
+            self.broker.unsubscribe(self, filters)
+            self.send(packet(0xB0, pid))
+        elif ptype == 3:                    # PUBLISH
+            qos = (head >> 1) & 3
+            n = struct.unpack(">H", body[:2])[0]
+            topic = body[2:2 + n].decode()
+            i = 2 + n
+            if qos:
+                pid = body[i:i + 2]
+                i += 2
+                self.send(packet(0x40 if qos == 1 else 0x50, pid))   # PUBACK / PUBREC
+            self.broker.publish(topic, body[i:], retain=bool(head & 1))
+        elif ptype == 6:                    # PUBREL (QoS 2 發布端)
+            self.send(packet(0x70, body[:2]))
+        elif ptype == 12:                   # PINGREQ
+            self.send(packet(0xD0, b""))
+        elif ptype == 14:                   # DISCONNECT
+            return False
+        return True
+
+
+class Server(socketserver.ThreadingTCPServer):
+    allow_reuse_address = True
+    daemon_threads = True
+
+
+def candle(market, interval, now_ms):
+    t, o, h, l, c = market.klines(interval, 1, now_ms=now_ms)[-1][:5]
+    return {"i": interval, "t": t, "o": float(o), "h": float(h), "l": float(l), "c": float(c)}
+
+
+def encode(obj, fmt, rng):
+    if fmt == "mixed":
+        fmt = rng.choice(["json", "msgpack"])
+    return msgpack(obj) if fmt == "msgpack" else json.dumps(obj, separators=(",", ":")).encode()
+
+
+def feed(broker, opts, stop):
+    market = Market(opts.seed)
+    rng = random.Random(opts.seed)
+    sent = {"json": 0, "msgpack": 0}
+    next_snapshot = 0
+    last = {}
+    while not stop.is_set():
+        market.tick()
+        now = int(time.time() * 1000)
+        if time.time() >= next_snapshot:
+            next_snapshot = time.time() + opts.snapshot
+            for i in INTERVALS:
+                rows = [{"t": r[0], "o": float(r[1]), "h": float(r[2]), "l": float(r[3]), "c": float(r[4])}
+                        for r in market.klines(i, 30, now_ms=now)]
+                # 整組以 topic 的最後一段表示週期，省掉每根的 "i"
+                rows[-1]["E"] = now
+                broker.publish("%s/series/%s" % (PREFIX, i), encode(rows, opts.format, rng), retain=True)
+        for i in INTERVALS:
+            k = candle(market, i, now)
+            closed = now >= k["t"] + INTERVAL_MS[i] - 1
+            msg = dict(k, x=closed, E=int(time.time() * 1000))
+            data = encode(msg, opts.format, rng)
+            sent["msgpack" if data[0] >= 0x80 else "json"] += 1
+            broker.publish("%s/kline/%s" % (PREFIX, i), data)
+            last[i] = k
+        broker.publish(PREFIX + "/price", encode({"p": market.price, "E": int(time.time() * 1000)}, opts.format, rng))
+        stop.wait(opts.rate)
+    print("feed sent kline json=%d msgpack=%d routed=%d" % (sent["json"], sent["msgpack"], broker.routed), flush=True)
+    for i in INTERVALS:
+        k = last.get(i)
+        if k:
+            print("feed %-3s last=%d close=%.2f" % (i, k["t"], k["c"]), flush=True)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--host", default="0.0.0.0")
+    ap.add_argument("--port", type=int, default=1883)
+    ap.add_argument("--feed", action="store_true", help="啟用內建行情發布端")
+    ap.add_argument("--rate", type=float, default=0.5, help="每輪發布的間隔 (秒)")
+    ap.add_argument("--snapshot", type=float, default=5.0, help="retained 整組序列的發布間隔 (秒)")
+    ap.add_argument("--format", choices=["json", "msgpack", "mixed"], default="mixed")
+    ap.add_argument("--duration", type=float, default=0, help="發布這麼多秒後結束，0 表示不停")
+    ap.add_argument("--seed", type=int, default=1)
+    ap.add_argument("-v", "--verbose", action="store_true")
+    opts = ap.parse_args()
+
+    broker = Broker(opts.verbose)
+    server = Server((opts.host, opts.port), Handler)
+    server.broker = broker
+    threading.Thread(target=server.serve_forever, daemon=True).start()
+    print("mqtt broker on %s:%d" % (opts.host, opts.port), flush=True)
+
+    stop = threading.Event()
+    feeder = None
+    if opts.feed:
+        feeder = threading.Thread(target=feed, args=(broker, opts, stop))
+        feeder.start()
+    try:
+        if opts.duration:
+            time.sleep(opts.duration)
+        else:
+            while True:
+                time.sleep(3600)
+    except KeyboardInterrupt:
+        pass
+    stop.set()
+    if feeder:
+        feeder.join()
+    # 讓訂閱端收完最後幾則再關閉
+    time.sleep(0.5)
+    server.shutdown()
+
+
+if __name__ == "__main__":
+    main()
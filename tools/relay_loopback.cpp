@@ -0,0 +1,197 @@
+// 在主機上以多個行程跑區網轉發：一個 relay 從 tools/mock_binance.py 抓 K線與價格並以 UDP multicast
+// 廣播，多個 follower 接收 (可模擬丟包) 並以 NACK 補回缺號。結束時各自印出每個週期序列的摘要，
+// follower 的摘要應與 relay 相同。
+//
+//   g++ -std=gnu++17 -O2 -Isrc -o relay_loopback tools/relay_loopback.cpp src/relay_proto.cpp src/exchange.cpp
+//       src/kline_fetch.cpp src/kline_parser.cpp src/json_stream.cpp src/kline_store.cpp src/posix_transport.cpp
+//       src/transport.cpp
+//   ./relay_loopback follow 20 0.1 & ./relay_loopback follow 20 0.1 & ./relay_loopback relay 127.0.0.1 8080 15
+// (relay 在指定秒數後停止抓取，再送 2 秒心跳；follower 的秒數要涵蓋這段)
+#include <arpa/inet.h>
+#include <chrono>
+#include <netinet/in.h>
+#include <poll.h>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "kline_fetch.h"
+#include "posix_transport.h"
+#include "relay_proto.h"
+
+#define GROUP "239.255.42.99"
+#define PORT 42424
+
+static uint32_t nowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// 摘要 = FNV-1a(開盤時間與收盤價)；浮點數經過 frame 原樣傳遞，兩端應完全相同
+static uint32_t digest(const KLineSeries& s) {
+    uint32_t h = 2166136261u;
+    for (int i = 0; i < s.count; i++) {
+        const uint8_t* p = (const uint8_t*)&s.items[i];
+        for (size_t j = 0; j < sizeof(KLine); j++) h = (h ^ p[j]) * 16777619u;
+    }
+    return h;
+}
+
+static void printSeries(const char* role, const KLineSeries* series) {
+    for (int i = 0; i < INTERVAL_COUNT; i++) {
+        printf("%s %-3s count=%2d digest=%08x close=%.2f\n", role, intervals[i], series[i].count, digest(series[i]),
+               series[i].last() ? series[i].last()->close : 0.0f);
+    }
+}
+
+static int relay(const char* host, int port, int seconds) {
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    in_addr lo;
+    lo.s_addr = htonl(INADDR_LOOPBACK);
+    setsockopt(fd, IPPROTO_IP, IP_MULTICAST_IF, &lo, sizeof(lo));
+    unsigned char loop = 1;
+    setsockopt(fd, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop));
+    sockaddr_in group = {};
+    group.sin_family = AF_INET;
+    group.sin_port = htons(PORT);
+    inet_pton(AF_INET, GROUP, &group.sin_addr);
+
+    PosixTransport transport(host, port);
+    KLineSeries series[INTERVAL_COUNT];
+    for (auto& s : series) s.clear();
+    float price = 0;
+    RelaySender sender;
+    sender.begin(nowMs() ^ getpid());
+    uint8_t buf[RELAY_MAX_FRAME];
+    auto send = [&](size_t n) {
+        if (n) sendto(fd, buf, n, 0, (sockaddr*)&group, sizeof(group));
+    };
+
+    uint32_t start = nowMs(), lastFetch = 0, lastBeat = 0, lastFull = 0, lastAll = 0;
+    int next = 0, fullNext = 0;
+    // 停止抓取後再多跑 2 秒心跳與 NACK，讓 follower 發現並補回結尾的缺號
+    while (nowMs() - start < (uint32_t)seconds * 1000 + 2000) {
+        uint32_t now = nowMs();
+        bool fetching = now - start < (uint32_t)seconds * 1000;
+        // 每 200 ms 抓一個週期 (輪流)，順便抓價格
+        if (fetching && now - lastFetch >= 200) {
+            lastFetch = now;
+            TickerFetch ticker(*exchanges[EXCHANGE_BINANCE]);
+            char path[128];
+            exchanges[EXCHANGE_BINANCE]->tickerPath(path, sizeof(path));
+            if (transport.get(path, ticker) == 200 && ticker.parsed()) price = ticker.price();
+            KLineFetch fetch(series[next]);
+            fetch.path(path, sizeof(path), next);
+            if (transport.get(path, fetch) == 200 && fetch.parsed()) {
+                send(sender.encodeUpdate(buf, sizeof(buf), next, series[next], price));
+            }
+            next = (next + 1) % INTERVAL_COUNT;
+        }
+        if (now - lastBeat >= 1000) {
+            lastBeat = now;
+            send(sender.encodePrice(buf, sizeof(buf), price));
+        }
+        // 輪流送完整序列，晚加入的 follower 也能收齊
+        if (fetching && now - lastFull >= 2000) {
+            lastFull = now;
+            send(sender.encodeSeries(buf, sizeof(buf), fullNext, series[fullNext], price));
+            fullNext = (fullNext + 1) % INTERVAL_COUNT;
+        }
+        pollfd pfd = {fd, POLLIN, 0};
+        while (poll(&pfd, 1, 10) > 0) {
+            uint8_t nack[64];
+            ssize_t n = recv(fd, nack, sizeof(nack), 0);
+            if (n <= 0) break;
+            uint32_t seqs[RELAY_NACK_MAX];
+            bool all;
+            int count = sender.onNack(nack, n, nowMs(), seqs, RELAY_NACK_MAX, all);
+            for (int i = 0; i < count; i++) send(sender.encodeRepair(buf, sizeof(buf), seqs[i], series, price));
+            if (all && nowMs() - lastAll >= 1000) {
+                lastAll = nowMs();
+                for (int i = 0; i < INTERVAL_COUNT; i++) send(sender.encodeSeries(buf, sizeof(buf), i, series[i], price));
+            }
+        }
+    }
+    const RelayStats& st = sender.stats();
+    printf("relay frames=%u bytes=%u nacks=%u repairs=%u price=%.2f\n", st.frames, st.bytes, st.nacks, st.repairs,
+           price);
+    printSeries("relay", series);
+    close(fd);
+    return 0;
+}
+
+static int follow(int seconds, double drop) {
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(PORT);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(fd, (sockaddr*)&addr, sizeof(addr)) < 0) {
+        perror("bind");
+        return 1;
+    }
+    ip_mreq mreq = {};
+    inet_pton(AF_INET, GROUP, &mreq.imr_multiaddr);
+    mreq.imr_interface.s_addr = htonl(INADDR_LOOPBACK);
+    if (setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0) {
+        perror("IP_ADD_MEMBERSHIP");
+        return 1;
+    }
+
+    KLineSeries series[INTERVAL_COUNT];
+    for (auto& s : series) s.clear();
+    RelayReceiver receiver;
+    receiver.begin(series, INTERVAL_COUNT);
+    std::mt19937 rng(getpid());
+    std::uniform_real_distribution<double> uni(0, 1);
+    sockaddr_in relayAddr = {};
+    bool haveRelay = false;
+    uint32_t dropped = 0, updates = 0;
+    uint32_t start = nowMs(), nextNack = 0;
+    while (nowMs() - start < (uint32_t)seconds * 1000) {
+        pollfd pfd = {fd, POLLIN, 0};
+        if (poll(&pfd, 1, 20) > 0) {
+            uint8_t buf[RELAY_MAX_FRAME];
+            socklen_t alen = sizeof(relayAddr);
+            ssize_t n = recvfrom(fd, buf, sizeof(buf), 0, (sockaddr*)&relayAddr, &alen);
+            haveRelay = n > 0;
+            if (n > 0 && uni(rng) < drop) {
+                dropped++;
+            } else if (n > 0 && receiver.onFrame(buf, n)) {
+                updates++;
+            }
+        }
+        // NACK 間隔加上抖動，避免所有 follower 同時要求
+        uint32_t now = nowMs();
+        if (haveRelay && (int32_t)(now - nextNack) >= 0) {
+            nextNack = now + 100 + rng() % 100;
+            uint8_t nack[64];
+            size_t n = receiver.encodeNack(nack, sizeof(nack));
+            if (n) sendto(fd, nack, n, 0, (sockaddr*)&relayAddr, sizeof(relayAddr));
+        }
+    }
+    const RelayStats& st = receiver.stats();
+    printf("follower[%d] frames=%u dropped=%u updates=%u missing=%u repaired=%u lost=%u stale=%u nacks=%u price=%.2f\n",
+           getpid(), st.frames, dropped, updates, st.missing, st.repaired, st.lost, st.stale, st.nacks,
+           receiver.price());
+    printSeries("follower", series);
+    close(fd);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && strcmp(argv[1], "relay") == 0) {
+        return relay(argc > 2 ? argv[2] : "127.0.0.1", argc > 3 ? atoi(argv[3]) : 8080, argc > 4 ? atoi(argv[4]) : 15);
+    }
+    if (argc > 1 && strcmp(argv[1], "follow") == 0) {
+        return follow(argc > 2 ? atoi(argv[2]) : 20, argc > 3 ? atof(argv[3]) : 0);
+    }
+    fprintf(stderr, "usage: %s relay [host] [port] [seconds] | follow [seconds] [drop]\n", argv[0]);
+    return 2;
+}
@@ -0,0 +1,213 @@
+// 在主機上錄製 / 回放網路 payload 記錄檔 (與裝置的 CAPTURE_MODE / REPLAY_MODE 同一種格式)。
+// record：對 tools/mock_binance.py 照裝置的節奏抓 K線 / ticker / 自選清單，回應經過解析並寫進記錄檔，
+//         結束時印出各週期序列的摘要。
+// replay：把記錄檔依原本的順序餵回同一套解析 -> 合併流程 (speed 1 為原速，0 為盡快)，
+//         印出各類 payload 的處理時間與序列摘要；摘要應與錄製時相同。
+// 裝置錄的檔案 (tools/capture_pull.py 取出) 也能直接回放，WebSocket 訊息在主機上只計數不解析。
+//
+//   g++ -std=gnu++17 -O2 -Isrc -o replay_bench tools/replay_bench.cpp src/payload_log.cpp src/watchlist.cpp
+//       src/exchange.cpp src/kline_fetch.cpp src/kline_parser.cpp src/json_stream.cpp src/kline_store.cpp
+//       src/posix_transport.cpp src/transport.cpp
+//   ./replay_bench record 127.0.0.1 8080 20 /tmp/capture.bin
+//   ./replay_bench replay /tmp/capture.bin 0
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <thread>
+
+#include "kline_fetch.h"
+#include "payload_log.h"
+#include "posix_transport.h"
+#include "watchlist.h"
+
+#define KLINE_GAP_MS 500      // 每 0.5 秒輪流刷新一個週期
+#define TICKER_GAP_MS 2000
+#define WATCHLIST_GAP_MS 5000
+
+static uint64_t nowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static uint32_t nowMs() {
+    return (uint32_t)(nowUs() / 1000);
+}
+
+// 摘要 = FNV-1a(整個 KLine)；回放的解析結果應逐位元相同
+static uint32_t digest(const KLineSeries& s) {
+    uint32_t h = 2166136261u;
+    for (int i = 0; i < s.count; i++) {
+        const uint8_t* p = (const uint8_t*)&s.items[i];
+        for (size_t j = 0; j < sizeof(KLine); j++) h = (h ^ p[j]) * 16777619u;
+    }
+    return h;
+}
+
+static void printSeries(const char* role, const KLineSeries* series, const Watchlist& watch) {
+    for (int i = 0; i < INTERVAL_COUNT; i++) {
+        printf("%s %-3s count=%2d digest=%08x close=%.2f\n", role, intervals[i], series[i].count, digest(series[i]),
+               series[i].last() ? series[i].last()->close : 0.0f);
+    }
+    for (int i = 0; i < watch.count; i++) {
+        printf("%s %-8s last=%.4f change=%+.2f%%\n", role, watch.items[i].symbol, watch.items[i].last,
+               watch.items[i].changePct());
+    }
+}
+
+// 與裝置上 RestConn 的 CaptureStream 相同：body 寫進解析器的同時附加到記錄檔
+class CaptureSink : public BodySink {
+public:
+    CaptureSink(BodySink& sink, PayloadWriter& writer) : _sink(sink), _writer(writer) {}
+    bool write(const uint8_t* data, size_t len) override {
+        _writer.append(data, len);
+        return _sink.write(data, len);
+    }
+
+private:
+    BodySink& _sink;
+    PayloadWriter& _writer;
+};
+
+// 與裝置相同：capture.bin 的舊檔為 capture.old
+static std::string oldPath(const char* file) {
+    std::string old = file;
+    size_t dot = old.rfind('.');
+    if (dot != std::string::npos && old.find('/', dot) == std::string::npos) old.resize(dot);
+    return old + ".old";
+}
+
+static int capturedGet(PosixTransport& t, PayloadWriter& w, const char* host, const char* path, BodySink& sink) {
+    w.beginRecord(PAYLOAD_REST, host, path, nowMs());
+    CaptureSink tee(sink, w);
+    int status = t.get(path, tee);
+    w.finish(status, t.lastDateMs(), t.lastUsedWeight(), t.lastRetryAfter());
+    return status;
+}
+
+static int record(const char* host, int port, int seconds, const char* file) {
+    std::string old = oldPath(file);
+    remove(old.c_str());
+    remove(file);
+    PayloadWriter writer;
+    if (!writer.begin(file, old.c_str(), 64u << 20, nowMs())) {
+        fprintf(stderr, "cannot open %s\n", file);
+        return 1;
+    }
+    PosixTransport transport(host, port);
+    KLineSeries series[INTERVAL_COUNT];
+    for (int i = 0; i < INTERVAL_COUNT; i++) series[i].clear();
+    Watchlist watch;
+    watch.begin("BTCUSDT,ETHUSDT,BNBUSDT,SOLUSDT,XRPUSDT");
+
+    uint32_t end = nowMs() + seconds * 1000;
+    uint32_t lastTicker = 0, lastWatch = 0;
+    int next = 0, requests = 0;
+    while ((int32_t)(nowMs() - end) < 0) {
+        char path[WATCHLIST_MAX * (WATCHLIST_SYMBOL + 7) + 48];
+        KLineFetch fetch(series[next]);
+        fetch.path(path, sizeof(path), next);
+        if (capturedGet(transport, writer, host, path, fetch) == 200 && fetch.parsed() && fetch.gap()) {
+            series[next].clear();
+            KLineFetch full(series[next]);
+            full.path(path, sizeof(path), next);
+            capturedGet(transport, writer, host, path, full);
+            requests++;
+        }
+        requests++;
+        next = (next + 1) % INTERVAL_COUNT;
+        if (nowMs() - lastTicker > TICKER_GAP_MS) {
+            TickerFetch ticker(*exchanges[EXCHANGE_BINANCE]);
+            capturedGet(transport, writer, host, "/api/v3/ticker/price?symbol=BTCUSDT", ticker);
+            lastTicker = nowMs();
+            requests++;
+        }
+        if (nowMs() - lastWatch > WATCHLIST_GAP_MS) {
+            WatchlistFetch wf(watch);
+            wf.path(path, sizeof(path));
+            capturedGet(transport, writer, host, path, wf);
+            lastWatch = nowMs();
+            requests++;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(KLINE_GAP_MS));
+    }
+    writer.end();
+    const PayloadStats& st = writer.stats();
+    printf("recorded requests=%d records=%u bytes=%u truncated=%u errors=%u\n", requests, st.records, st.bytes,
+           st.truncated, st.errors);
+    printSeries("record", series, watch);
+    return st.errors ? 1 : 0;
+}
+
+static int replay(const char* file, float speed) {
+    std::string old = oldPath(file);
+    const char* files[] = {old.c_str(), file};
+    PayloadReader reader;
+    if (!reader.begin(files, 2)) {
+        fprintf(stderr, "cannot open %s\n", file);
+        return 1;
+    }
+    KLineSeries series[INTERVAL_COUNT];
+    for (int i = 0; i < INTERVAL_COUNT; i++) series[i].clear();
+    Watchlist watch;
+    watch.begin("BTCUSDT,ETHUSDT,BNBUSDT,SOLUSDT,XRPUSDT");
+
+    ReplayClock pace;
+    pace.begin(speed);
+    uint32_t records[ROUTE_COUNT] = {}, failed = 0, parseErrors = 0, diverged = 0;
+    uint64_t busyUs[ROUTE_COUNT] = {};
+    PayloadEntry e;
+    uint64_t start = nowUs();
+    while (reader.next(e)) {
+        uint32_t wait = pace.waitMs(e.rec.tMs, nowMs());
+        if (wait) std::this_thread::sleep_for(std::chrono::milliseconds(wait));
+        uint64_t t0 = nowUs();
+        int idx = 0;
+        PayloadRoute route = payloadRoute(e, &idx);
+        // 失敗的請求照樣餵：斷線前已串流解析的部分在錄製時就合併了
+        bool http200 = route == ROUTE_STREAM || e.rec.httpCode == 200;
+        bool ok = true;
+        if (!http200) failed++;
+        if (route == ROUTE_KLINES) {
+            KLineFetch fetch(series[idx]);
+            char path[128];
+            fetch.path(path, sizeof(path), idx);
+            if (strcmp(path, e.path) != 0) diverged++;
+            if (e.bodyLen) fetch.write(e.body, e.bodyLen);
+            ok = fetch.parsed() || !http200;
+            if (http200 && fetch.parsed() && fetch.gap()) series[idx].clear();
+        } else if (route == ROUTE_TICKER && http200) {
+            TickerFetch ticker(*exchanges[EXCHANGE_BINANCE]);
+            ticker.write(e.body, e.bodyLen);
+            ok = ticker.parsed();
+        } else if (route == ROUTE_WATCHLIST) {
+            WatchlistFetch wf(watch);
+            if (e.bodyLen) wf.write(e.body, e.bodyLen);
+        }
+        if (!ok) parseErrors++;
+        records[route]++;
+        busyUs[route] += nowUs() - t0;
+    }
+    double wallMs = (nowUs() - start) / 1000.0;
+    const PayloadStats& st = reader.stats();
+    printf("replayed records=%u bytes=%u in %.1fms (%.0f records/s, %.1f MB/s) ", st.records, st.bytes, wallMs,
+           st.records * 1000.0 / wallMs, st.bytes / wallMs / 1000.0);
+    if (speed > 0) printf("speed=%.1fx\n", speed);
+    else printf("speed=max\n");
+    for (int i = 0; i < ROUTE_COUNT; i++) {
+        if (!records[i]) continue;
+        printf("  %-6s n=%5u avg=%.2fus%s\n", payloadRouteName((PayloadRoute)i), records[i],
+               (double)busyUs[i] / records[i], i == ROUTE_STREAM ? " (counted only)" : "");
+    }
+    printf("failed=%u parse_err=%u diverged=%u corrupt=%u truncated=%u\n", failed, parseErrors, diverged, st.errors,
+           st.truncated);
+    printSeries("replay", series, watch);
+    return parseErrors || diverged || st.errors ? 1 : 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc >= 6 && strcmp(argv[1], "record") == 0) return record(argv[2], atoi(argv[3]), atoi(argv[4]), argv[5]);
+    if (argc >= 3 && strcmp(argv[1], "replay") == 0) return replay(argv[2], argc > 3 ? atof(argv[3]) : 1);
+    fprintf(stderr, "usage: %s record <host> <port> <seconds> <file> | replay <file> [speed]\n", argv[0]);
+    return 2;
+}